@@ -6,8 +6,11 @@
 
 #include <AutopilotManagerConfig.hpp>
 #include <DbusInterface.hpp>
+#include <TelemetryHub.hpp>
+#include <condition_variable>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 
 // Manager modules
@@ -39,8 +42,11 @@ class AutopilotManager {
 
     void initialProvisioning();
 
-    auto SetConfiguration(AutopilotManagerConfig config) -> ResponseCode;
+    // Unknown enum values reject the configuration, unless use_defaults_on_error replaces them by their default
+    auto SetConfiguration(AutopilotManagerConfig config, bool use_defaults_on_error = false) -> ResponseCode;
     auto GetConfiguration(AutopilotManagerConfig config) -> ResponseCode;
+    // Called by SetConfiguration() with _config_mutex held
+    void publish_module_configurations();
 
     void start();
 
@@ -58,13 +64,14 @@ class AutopilotManager {
     void update_obstacle_avoidance_enabled();
 
     void create_avoidance_mavlink_heartbeat_message();
+    void send_obstacle_distance(const CollisionAvoidanceManager::ObstacleSectors& sectors);
 
     std::atomic<bool> _obstacle_avoidance_enabled;
 
     mavlink_message_t _avoidance_heartbeat_message;
 
     uint8_t _autopilot_manager_enabled = false;
-    std::string _decision_maker_input_type = "";
+    DecisionMakerInputType _decision_maker_input_type = DecisionMakerInputType::NONE;
 
     // General configurations dependent on selected actions
     std::string _script_to_call = "";
@@ -91,7 +98,7 @@ class AutopilotManager {
     uint8_t _safe_landing_enabled = false;
     double _safe_landing_area_square_size = 0.0;
     double _safe_landing_distance_to_ground = 0.0;
-    std::string _safe_landing_on_no_safe_land = "";
+    MissionAction _safe_landing_on_no_safe_land = MissionAction::NONE;
     uint8_t _safe_landing_try_landing_after_action = false;
 
     // Landing site search configurations
@@ -110,7 +117,7 @@ class AutopilotManager {
     // Simple collision avoidance configurations
     uint8_t _simple_collision_avoid_enabled = false;
     double _simple_collision_avoid_distance_threshold = 0.0;
-    std::string _simple_collision_avoid_action_on_condition_true = "";
+    MissionAction _simple_collision_avoid_action_on_condition_true = MissionAction::NONE;
 
     std::thread _sensor_manager_th;
     std::thread _landing_manager_th;
@@ -122,9 +129,16 @@ class AutopilotManager {
     std::shared_ptr<LandingManager> _landing_manager;
     std::shared_ptr<CollisionAvoidanceManager> _collision_avoidance_manager;
 
+    // Immutable configuration snapshots for the modules, published on every SetConfiguration()
+    std::shared_ptr<MissionManager::ConfigurationChannel> _mission_manager_config_channel{
+        std::make_shared<MissionManager::ConfigurationChannel>()};
+    std::shared_ptr<LandingManager::ConfigurationChannel> _landing_manager_config_channel{
+        std::make_shared<LandingManager::ConfigurationChannel>()};
+    std::shared_ptr<CollisionAvoidanceManager::ConfigurationChannel> _collision_avoidance_manager_config_channel{
+        std::make_shared<CollisionAvoidanceManager::ConfigurationChannel>()};
+
     std::mutex _config_mutex;
     std::mutex _distance_to_obstacle_mutex;
-    std::mutex _downsampled_depth_callback_mutex;
     std::mutex _landing_condition_state_mutex;
     std::mutex _height_above_obstacle_mutex;
 
@@ -133,10 +147,16 @@ class AutopilotManager {
     std::string _custom_action_config_path =
         "/usr/src/app/autopilot-manager/data/example/custom_action/custom_action.json";
 
+    std::shared_ptr<TelemetryHub> _telemetry_hub;
     std::shared_ptr<mavsdk::MavlinkPassthrough> _mavlink_passthrough;
 
     static constexpr uint8_t kDefaultSystemId = 1;
     static constexpr uint8_t kMavCompIDOnBoardComputer3 = 193;
 
     std::atomic<bool> _interrupt_received{false};
+
+    // run() sleeps until the next heartbeat, or until the obstacle avoidance status changed
+    std::mutex _run_mutex;
+    std::condition_variable _run_wakeup;
+    bool _run_wake_requested{false};
 };
@@ -42,6 +42,7 @@
 namespace {
 const auto METHOD_GET_CONFIG = "get_config";
 const auto METHOD_SET_CONFIG = "set_config";
+const auto telemetry_stats_interval = std::chrono::seconds(30);
 }  // namespace
 
 AutopilotManager::AutopilotManager(const std::string& mavlinkPort, const std::string& configPath = "",
@@ -57,11 +58,22 @@ AutopilotManager::AutopilotManager(const std::string& mavlinkPort, const std::st
 
 AutopilotManager::~AutopilotManager() {
     _interrupt_received.store(true, std::memory_order_relaxed);
+    _run_wakeup.notify_all();
 
     _sensor_manager_th.join();
     _collision_avoidance_manager_th.join();
     _landing_manager_th.join();
     _mission_manager_th.join();
+    _mission_manager_config_channel->setPublishListener(nullptr);
+
+    // MAVSDK must not call into the modules once they are destroyed. The modules share the hub, so it is shut down
+    // explicitly instead of relying on the last reference.
+    if (_telemetry_hub != nullptr) {
+        _telemetry_hub->shutdown();
+    }
+    _telemetry_hub.reset();
+    _mavlink_passthrough.reset();
+
     _mission_manager.reset();
     _sensor_manager.reset();
     _collision_avoidance_manager.reset();
@@ -90,7 +102,10 @@ auto AutopilotManager::HandleRequest(DBusMessage* request) -> DBusMessage* {
             ResponseCode response_code;
             if (config.InitFromMessage(request)) {
                 response_code = SetConfiguration(config);
-                config.WriteToFile(_config_path);
+                // A rejected configuration is not applied, so it is not stored either
+                if (response_code != ResponseCode::FAILED) {
+                    config.WriteToFile(_config_path);
+                }
             } else {
                 response_code = ResponseCode::FAILED;
             }
@@ -105,19 +120,51 @@ void AutopilotManager::initialProvisioning() {
     AutopilotManagerConfig config;
     if (config.InitFromFile(_config_path)) {
         config.Print();
-        ResponseCode response_code = SetConfiguration(config);
+        // A single bad field in the stored configuration must not leave the whole Autopilot Manager unconfigured
+        ResponseCode response_code = SetConfiguration(config, true);
         std::cout << "[Autopilot Manager] Initial provisioning finished with code " << response_code << std::endl;
     } else {
         std::cout << "[Autopilot Manager] Failed to init default config from " << _config_path << std::endl;
     }
 }
 
-auto AutopilotManager::SetConfiguration(AutopilotManagerConfig config) -> AutopilotManager::ResponseCode {
+auto AutopilotManager::SetConfiguration(AutopilotManagerConfig config, bool use_defaults_on_error)
+    -> AutopilotManager::ResponseCode {
+    // The decision maker input and the actions are parsed here once
+    auto decision_maker_input_type = parseDecisionMakerInputType(config.decision_maker_input_type);
+    auto safe_landing_on_no_safe_land = parseMissionAction(config.safe_landing_on_no_safe_land);
+    auto simple_collision_avoid_action_on_condition_true =
+        parseMissionAction(config.simple_collision_avoid_action_on_condition_true);
+
+    bool valid = true;
+    const auto check = [&](auto& parsed, const auto default_value, const char* field, const std::string& value) {
+        if (parsed) {
+            return;
+        }
+        if (use_defaults_on_error) {
+            std::cerr << "[Autopilot Manager] Unknown " << field << ": '" << value << "', using the default"
+                      << std::endl;
+            parsed = default_value;
+        } else {
+            std::cerr << "[Autopilot Manager] Unknown " << field << ": " << value << std::endl;
+            valid = false;
+        }
+    };
+    check(decision_maker_input_type, DecisionMakerInputType::NONE, "decision maker input type",
+          config.decision_maker_input_type);
+    check(safe_landing_on_no_safe_land, MissionAction::NONE, "safe landing action",
+          config.safe_landing_on_no_safe_land);
+    check(simple_collision_avoid_action_on_condition_true, MissionAction::NONE, "simple collision avoidance action",
+          config.simple_collision_avoid_action_on_condition_true);
+    if (!valid) {
+        return ResponseCode::FAILED;
+    }
+
     std::lock_guard<std::mutex> lock(_config_mutex);
 
     // General configurations
     _autopilot_manager_enabled = config.autopilot_manager_enabled;
-    _decision_maker_input_type = config.decision_maker_input_type;
+    _decision_maker_input_type = *decision_maker_input_type;
 
     // General configurations dependent on selected actions
     _script_to_call = config.script_to_call;
@@ -144,7 +191,7 @@ auto AutopilotManager::SetConfiguration(AutopilotManagerConfig config) -> Autopi
     _safe_landing_enabled = config.safe_landing_enabled;
     _safe_landing_area_square_size = config.safe_landing_area_square_size;
     _safe_landing_distance_to_ground = config.safe_landing_distance_to_ground;
-    _safe_landing_on_no_safe_land = config.safe_landing_on_no_safe_land;
+    _safe_landing_on_no_safe_land = *safe_landing_on_no_safe_land;
     _safe_landing_try_landing_after_action = config.safe_landing_try_landing_after_action;
 
     // Landing site search configurations
@@ -162,15 +209,17 @@ auto AutopilotManager::SetConfiguration(AutopilotManagerConfig config) -> Autopi
     // Simple collision avoidance configurations
     _simple_collision_avoid_enabled = config.simple_collision_avoid_enabled;
     _simple_collision_avoid_distance_threshold = config.simple_collision_avoid_distance_threshold;
-    _simple_collision_avoid_action_on_condition_true = config.simple_collision_avoid_action_on_condition_true;
+    _simple_collision_avoid_action_on_condition_true = *simple_collision_avoid_action_on_condition_true;
 
-    if (_decision_maker_input_type == "SAFE_LANDING") {
+    publish_module_configurations();
+
+    if (_decision_maker_input_type == DecisionMakerInputType::SAFE_LANDING) {
         if (!static_cast<bool>(_safe_landing_enabled)) {
             return ResponseCode::SUCCEED_WITH_SAFE_LANDING_OFF;
         } else {
             return ResponseCode::SUCCEED_WITH_SAFE_LANDING_ON;
         }
-    } else if (_decision_maker_input_type == "SIMPLE_COLLISION_AVOIDANCE") {
+    } else if (_decision_maker_input_type == DecisionMakerInputType::SIMPLE_COLLISION_AVOIDANCE) {
         if (!static_cast<bool>(_simple_collision_avoid_enabled)) {
             return ResponseCode::SUCCEED_WITH_COLL_AVOID_OFF;
         } else {
@@ -181,12 +230,62 @@ auto AutopilotManager::SetConfiguration(AutopilotManagerConfig config) -> Autopi
     return ResponseCode::UNKNOWN;
 }
 
+void AutopilotManager::publish_module_configurations() {
+    // Every module gets an immutable snapshot of its part of the configuration
+    CollisionAvoidanceManager::CollisionAvoidanceManagerConfiguration collision_avoidance_config;
+    collision_avoidance_config.autopilot_manager_enabled = _autopilot_manager_enabled;
+    collision_avoidance_config.simple_collision_avoid_enabled = _simple_collision_avoid_enabled;
+    _collision_avoidance_manager_config_channel->publish(std::move(collision_avoidance_config));
+
+    LandingManager::LandingManagerConfiguration landing_config;
+    landing_config.autopilot_manager_enabled = _autopilot_manager_enabled;
+    landing_config.safe_landing_enabled = _safe_landing_enabled;
+    landing_config.safe_landing_area_square_size = _safe_landing_area_square_size;
+    landing_config.safe_landing_distance_to_ground = _safe_landing_distance_to_ground;
+    _landing_manager_config_channel->publish(std::move(landing_config));
+
+    MissionManager::MissionManagerConfiguration mission_config;
+    mission_config.autopilot_manager_enabled = _autopilot_manager_enabled;
+    mission_config.decision_maker_input_type = _decision_maker_input_type;
+    mission_config.script_to_call = _script_to_call;
+    mission_config.api_call = _api_call;
+    mission_config.local_position_offset_x = _local_position_offset_x;
+    mission_config.local_position_offset_y = _local_position_offset_y;
+    mission_config.local_position_offset_z = _local_position_offset_z;
+    mission_config.local_position_waypoint_x = _local_position_waypoint_x;
+    mission_config.local_position_waypoint_y = _local_position_waypoint_y;
+    mission_config.local_position_waypoint_z = _local_position_waypoint_z;
+    mission_config.global_position_offset_lat = _global_position_offset_lat;
+    mission_config.global_position_offset_lon = _global_position_offset_lon;
+    mission_config.global_position_offset_alt_amsl = _global_position_offset_alt_amsl;
+    mission_config.global_position_waypoint_lat = _global_position_waypoint_lat;
+    mission_config.global_position_waypoint_lon = _global_position_waypoint_lon;
+    mission_config.global_position_waypoint_alt_amsl = _global_position_waypoint_alt_amsl;
+    mission_config.safe_landing_enabled = _safe_landing_enabled;
+    mission_config.safe_landing_distance_to_ground = _safe_landing_distance_to_ground;
+    mission_config.safe_landing_on_no_safe_land = _safe_landing_on_no_safe_land;
+    mission_config.safe_landing_try_landing_after_action = _safe_landing_try_landing_after_action;
+    mission_config.landing_site_search_speed = _landing_site_search_speed;
+    mission_config.landing_site_search_max_distance = _landing_site_search_max_distance;
+    mission_config.landing_site_search_min_height = _landing_site_search_min_height;
+    mission_config.landing_site_search_min_distance_after_abort = _landing_site_search_min_distance_after_abort;
+    mission_config.landing_site_search_arrival_radius = _landing_site_search_arrival_radius;
+    mission_config.landing_site_search_assess_time = _landing_site_search_assess_time;
+    mission_config.landing_site_search_strategy = _landing_site_search_strategy;
+    mission_config.landing_site_search_spiral_spacing = _landing_site_search_spiral_spacing;
+    mission_config.landing_site_search_spiral_points = _landing_site_search_spiral_points;
+    mission_config.simple_collision_avoid_enabled = _simple_collision_avoid_enabled;
+    mission_config.simple_collision_avoid_distance_threshold = _simple_collision_avoid_distance_threshold;
+    mission_config.simple_collision_avoid_action_on_condition_true = _simple_collision_avoid_action_on_condition_true;
+    _mission_manager_config_channel->publish(std::move(mission_config));
+}
+
 auto AutopilotManager::GetConfiguration(AutopilotManagerConfig config) -> AutopilotManager::ResponseCode {
     std::lock_guard<std::mutex> lock(_config_mutex);
 
     // General configurations
     config.autopilot_manager_enabled = _autopilot_manager_enabled;
-    config.decision_maker_input_type = _decision_maker_input_type;
+    config.decision_maker_input_type = toString(_decision_maker_input_type);
 
     // General configurations dependent on selected actions
     config.script_to_call = _script_to_call;
@@ -213,7 +312,7 @@ auto AutopilotManager::GetConfiguration(AutopilotManagerConfig config) -> Autopi
     config.safe_landing_enabled = _safe_landing_enabled;
     config.safe_landing_area_square_size = _safe_landing_area_square_size;
     config.safe_landing_distance_to_ground = _safe_landing_distance_to_ground;
-    config.safe_landing_on_no_safe_land = _safe_landing_on_no_safe_land;
+    config.safe_landing_on_no_safe_land = toString(_safe_landing_on_no_safe_land);
     config.safe_landing_try_landing_after_action = _safe_landing_try_landing_after_action;
 
     // Landing site search configurations
@@ -231,15 +330,15 @@ auto AutopilotManager::GetConfiguration(AutopilotManagerConfig config) -> Autopi
     // Simple collision avoidance configurations
     config.simple_collision_avoid_enabled = _simple_collision_avoid_enabled;
     config.simple_collision_avoid_distance_threshold = _simple_collision_avoid_distance_threshold;
-    config.simple_collision_avoid_action_on_condition_true = _simple_collision_avoid_action_on_condition_true;
+    config.simple_collision_avoid_action_on_condition_true = toString(_simple_collision_avoid_action_on_condition_true);
 
-    if (config.decision_maker_input_type == "SAFE_LANDING") {
+    if (_decision_maker_input_type == DecisionMakerInputType::SAFE_LANDING) {
         if (!config.safe_landing_enabled) {
             return ResponseCode::SUCCEED_WITH_SAFE_LANDING_OFF;
         } else {
             return ResponseCode::SUCCEED_WITH_SAFE_LANDING_ON;
         }
-    } else if (config.decision_maker_input_type == "SIMPLE_COLLISION_AVOIDANCE") {
+    } else if (_decision_maker_input_type == DecisionMakerInputType::SIMPLE_COLLISION_AVOIDANCE) {
         if (!config.simple_collision_avoid_enabled) {
             return ResponseCode::SUCCEED_WITH_COLL_AVOID_OFF;
         } else {
@@ -286,15 +385,16 @@ void AutopilotManager::start() {
         // Get discovered system now
         const auto system = fut.get();
 
+        // Telemetry and MAVLink passthrough, created first as the modules subscribe and send messages through them
+        _telemetry_hub = std::make_shared<TelemetryHub>(system);
+        _mavlink_passthrough = _telemetry_hub->mavlink_passthrough();
+
         // Start modules
         start_sensor_manager(system);
         start_collision_avoidance_manager();
         start_landing_manager(system);
         start_mission_manager(system);
 
-        // MAVLink passthrough
-        _mavlink_passthrough = std::make_shared<mavsdk::MavlinkPassthrough>(system);
-
         // Create reusable heartbeat message
         create_avoidance_mavlink_heartbeat_message();
 
@@ -309,6 +409,7 @@ void AutopilotManager::start() {
 
 void AutopilotManager::start_sensor_manager(std::shared_ptr<mavsdk::System> mavsdk_system) {
     _sensor_manager = std::make_shared<SensorManager>(mavsdk_system);
+    _sensor_manager->setTelemetryHub(_telemetry_hub);
     _sensor_manager->init();
     _sensor_manager->set_camera_static_tf(_camera_offset_x, _camera_offset_y, _camera_yaw);
     _sensor_manager_th = std::thread(&AutopilotManager::run_sensor_manager, this);
@@ -317,42 +418,43 @@ void AutopilotManager::start_sensor_manager(std::shared_ptr<mavsdk::System> mavs
 void AutopilotManager::start_collision_avoidance_manager() {
     _collision_avoidance_manager = std::make_shared<CollisionAvoidanceManager>();
 
-    _collision_avoidance_manager->setConfigUpdateCallback([this]() {
-        std::lock_guard<std::mutex> lock(_config_mutex);
+    _collision_avoidance_manager->setConfigChannel(_collision_avoidance_manager_config_channel);
 
-        CollisionAvoidanceManager::CollisionAvoidanceManagerConfiguration config;
-        config.autopilot_manager_enabled = _autopilot_manager_enabled;
-        config.simple_collision_avoid_enabled = _simple_collision_avoid_enabled;
-        return config;
-    });
+    _collision_avoidance_manager->setDepthFrameChannel(_sensor_manager->get_depth_frame_channel());
+    _collision_avoidance_manager->setDepthFrameConsumer(
+        _sensor_manager->get_depth_frame_demand()->registerConsumer("collision avoidance"));
 
-    _collision_avoidance_manager->getDownsampledDepthDataCallback([this]() {
-        std::lock_guard<std::mutex> lock(_downsampled_depth_callback_mutex);
-        return _sensor_manager->get_lastest_downsampled_depth();
-    });
+    // Forward the obstacle sectors to PX4 collision prevention
+    _collision_avoidance_manager->setObstacleSectorsCallback(
+        [this](const CollisionAvoidanceManager::ObstacleSectors& sectors) { send_obstacle_distance(sectors); });
 
     _collision_avoidance_manager->init();
+
+    // When collision avoidance is the only consumer of the depth frames, only its ROI needs to be downsampled
+    _sensor_manager->setRegionOfInterestCallback(
+        [collision_avoidance_config_channel = _collision_avoidance_manager_config_channel,
+         landing_config_channel = _landing_manager_config_channel,
+         collision_avoidance_manager = _collision_avoidance_manager]() {
+            const auto collision_avoidance_config = collision_avoidance_config_channel->latest();
+            const auto landing_config = landing_config_channel->latest();
+            const bool collision_avoidance_only =
+                collision_avoidance_config != nullptr && collision_avoidance_config->autopilot_manager_enabled &&
+                collision_avoidance_config->simple_collision_avoid_enabled &&
+                !(landing_config != nullptr && landing_config->safe_landing_enabled);
+            return collision_avoidance_only ? collision_avoidance_manager->get_region_of_interest()
+                                            : DepthRegionOfInterest{};
+        });
+
     _collision_avoidance_manager_th = std::thread(&AutopilotManager::run_collision_avoidance_manager, this);
 }
 
 void AutopilotManager::start_landing_manager(std::shared_ptr<mavsdk::System> mavsdk_system) {
     _landing_manager = std::make_shared<LandingManager>(mavsdk_system);
 
-    _landing_manager->setConfigUpdateCallback([this]() {
-        std::lock_guard<std::mutex> lock(_config_mutex);
-
-        LandingManager::LandingManagerConfiguration config;
-        config.autopilot_manager_enabled = _autopilot_manager_enabled;
-        config.safe_landing_enabled = _safe_landing_enabled;
-        config.safe_landing_area_square_size = _safe_landing_area_square_size;
-        config.safe_landing_distance_to_ground = _safe_landing_distance_to_ground;
-        return config;
-    });
+    _landing_manager->setConfigChannel(_landing_manager_config_channel);
 
-    _landing_manager->getDownsampledDepthDataCallback([this]() {
-        std::lock_guard<std::mutex> lock(_downsampled_depth_callback_mutex);
-        return _sensor_manager->get_lastest_downsampled_depth();
-    });
+    _landing_manager->setDepthFrameChannel(_sensor_manager->get_depth_frame_channel());
+    _landing_manager->setDepthFrameConsumer(_sensor_manager->get_depth_frame_demand()->registerConsumer("landing"));
 
     _landing_manager->init();
     _landing_manager_th = std::thread(&AutopilotManager::run_landing_manager, this);
@@ -360,46 +462,12 @@ void AutopilotManager::start_landing_manager(std::shared_ptr<mavsdk::System> mav
 
 void AutopilotManager::start_mission_manager(std::shared_ptr<mavsdk::System> mavsdk_system) {
     _mission_manager = std::make_shared<MissionManager>(mavsdk_system, _custom_action_config_path);
+    _mission_manager->setTelemetryHub(_telemetry_hub);
 
-    // Init the callback for setting the Mission Manager parameters
-    _mission_manager->setConfigUpdateCallback([this]() {
-        std::lock_guard<std::mutex> lock(_config_mutex);
-
-        MissionManager::MissionManagerConfiguration config;
-        config.autopilot_manager_enabled = _autopilot_manager_enabled;
-        config.decision_maker_input_type = _decision_maker_input_type;
-        config.script_to_call = _script_to_call;
-        config.api_call = _api_call;
-        config.local_position_offset_x = _local_position_offset_x;
-        config.local_position_offset_y = _local_position_offset_y;
-        config.local_position_offset_z = _local_position_offset_z;
-        config.local_position_waypoint_x = _local_position_waypoint_x;
-        config.local_position_waypoint_y = _local_position_waypoint_y;
-        config.local_position_waypoint_z = _local_position_waypoint_z;
-        config.global_position_offset_lat = _global_position_offset_lat;
-        config.global_position_offset_lon = _global_position_offset_lon;
-        config.global_position_offset_alt_amsl = _global_position_offset_alt_amsl;
-        config.global_position_waypoint_lat = _global_position_waypoint_lat;
-        config.global_position_waypoint_lon = _global_position_waypoint_lon;
-        config.global_position_waypoint_alt_amsl = _global_position_waypoint_alt_amsl;
-        config.safe_landing_enabled = _safe_landing_enabled;
-        config.safe_landing_distance_to_ground = _safe_landing_distance_to_ground;
-        config.safe_landing_on_no_safe_land = _safe_landing_on_no_safe_land;
-        config.safe_landing_try_landing_after_action = _safe_landing_try_landing_after_action;
-        config.landing_site_search_speed = _landing_site_search_speed;
-        config.landing_site_search_max_distance = _landing_site_search_max_distance;
-        config.landing_site_search_min_height = _landing_site_search_min_height;
-        config.landing_site_search_min_distance_after_abort = _landing_site_search_min_distance_after_abort;
-        config.landing_site_search_arrival_radius = _landing_site_search_arrival_radius;
-        config.landing_site_search_assess_time = _landing_site_search_assess_time;
-        config.landing_site_search_strategy = _landing_site_search_strategy;
-        config.landing_site_search_spiral_spacing = _landing_site_search_spiral_spacing;
-        config.landing_site_search_spiral_points = _landing_site_search_spiral_points;
-        config.simple_collision_avoid_enabled = _simple_collision_avoid_enabled;
-        config.simple_collision_avoid_distance_threshold = _simple_collision_avoid_distance_threshold;
-        config.simple_collision_avoid_action_on_condition_true = _simple_collision_avoid_action_on_condition_true;
-        return config;
-    });
+    // Configuration snapshots published by SetConfiguration(), each of them wakes up the decision maker
+    _mission_manager->setConfigChannel(_mission_manager_config_channel);
+    _mission_manager_config_channel->setPublishListener(
+        [mission_manager = _mission_manager]() { mission_manager->wake_decision_maker(); });
 
     // Init the callback for getting the latest distance to obstacle
     _mission_manager->getDistanceToObstacleCallback([this]() {
@@ -407,6 +475,29 @@ void AutopilotManager::start_mission_manager(std::shared_ptr<mavsdk::System> mav
         return _collision_avoidance_manager->get_latest_distance();
     });
 
+    // Obstacle distances are pushed to the decision maker as soon as a frame is processed
+    _collision_avoidance_manager->setObstacleDistanceCallback(
+        [mission_manager = _mission_manager](float distance_m, const Eigen::Vector3f& direction_ned,
+                                             std::chrono::steady_clock::time_point frame_received) {
+            mission_manager->handle_obstacle_distance(distance_m, direction_ned, frame_received);
+        });
+    _collision_avoidance_manager->setVehicleState(_mission_manager->get_vehicle_state());
+
+    // Landing state changes wake up the decision maker
+    _landing_manager->setLandingStateCallback(
+        [mission_manager = _mission_manager](landing_mapper::eLandingMapperState) {
+            mission_manager->wake_decision_maker();
+        });
+
+    // Obstacle avoidance status changes are forwarded to the other modules without waiting for the next heartbeat
+    _mission_manager->setObstacleAvoidanceStatusCallback([this](bool) {
+        {
+            std::lock_guard<std::mutex> lock(_run_mutex);
+            _run_wake_requested = true;
+        }
+        _run_wakeup.notify_one();
+    });
+
     // Init the callback for getting the latest landing condition state
     _mission_manager->getCanLandStateCallback([this]() {
         std::lock_guard<std::mutex> lock(_landing_condition_state_mutex);
@@ -451,23 +542,40 @@ void AutopilotManager::run_mission_manager() {
 }
 
 void AutopilotManager::run() {
+    auto next_heartbeat = std::chrono::steady_clock::now();
+    auto next_telemetry_stats = next_heartbeat + telemetry_stats_interval;
+
     while (!_interrupt_received) {
         // Check if obstacle avoidance is enabled
         update_obstacle_avoidance_enabled();
 
-        if (_safe_landing_enabled) {
-            // Send avoidance heartbeat
-            const bool sm_healthy = _sensor_manager->isHealthy();
-            const bool lm_healthy = _landing_manager->isHealthy();
-            const bool mm_healthy = _mission_manager->isHealthy();
+        // Send the avoidance heartbeat at 1Hz
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= next_heartbeat) {
+            next_heartbeat = now + std::chrono::seconds(1);
+
+            if (_safe_landing_enabled) {
+                const bool sm_healthy = _sensor_manager->isHealthy();
+                const bool lm_healthy = _landing_manager->isHealthy();
+                const bool mm_healthy = _mission_manager->isHealthy();
 
-            if (sm_healthy && lm_healthy && mm_healthy) {
-                _mavlink_passthrough->send_message(_avoidance_heartbeat_message);
+                if (sm_healthy && lm_healthy && mm_healthy) {
+                    _mavlink_passthrough->send_message(_avoidance_heartbeat_message);
+                }
             }
         }
 
-        // Update at 1Hz
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        if (now >= next_telemetry_stats) {
+            next_telemetry_stats = now + telemetry_stats_interval;
+            std::stringstream ss;
+            _telemetry_hub->printStats(ss);
+            _mission_manager->printTrajectoryLatency(ss);
+            std::cout << std::endl << ss.str() << std::endl;
+        }
+
+        std::unique_lock<std::mutex> lock(_run_mutex);
+        _run_wakeup.wait_until(lock, next_heartbeat, [this]() { return _run_wake_requested || _interrupt_received; });
+        _run_wake_requested = false;
     }
 }
 
@@ -488,6 +596,35 @@ void AutopilotManager::update_obstacle_avoidance_enabled() {
     _sensor_manager->set_obstacle_avoidance_enabled(_obstacle_avoidance_enabled);
 }
 
+void AutopilotManager::send_obstacle_distance(const CollisionAvoidanceManager::ObstacleSectors& sectors) {
+    mavlink_obstacle_distance_t obstacle_distance{};
+    obstacle_distance.time_usec = std::chrono::duration_cast<std::chrono::microseconds>(
+                                      std::chrono::steady_clock::now().time_since_epoch())
+                                      .count();
+    obstacle_distance.sensor_type = MAV_DISTANCE_SENSOR_UNKNOWN;
+    obstacle_distance.frame = MAV_FRAME_BODY_FRD;
+    obstacle_distance.increment_f = sectors.increment_deg;
+    obstacle_distance.angle_offset = sectors.angle_offset_deg + static_cast<float>(_camera_yaw);
+    obstacle_distance.min_distance = static_cast<uint16_t>(sectors.min_distance_m * 100.f);
+    obstacle_distance.max_distance = static_cast<uint16_t>(sectors.max_distance_m * 100.f);
+
+    // Sectors without a valid depth are unknown, obstacles beyond the maximum distance are reported as free
+    static constexpr size_t max_sectors = sizeof(obstacle_distance.distances) / sizeof(obstacle_distance.distances[0]);
+    std::fill(std::begin(obstacle_distance.distances), std::end(obstacle_distance.distances), UINT16_MAX);
+    for (size_t i = 0; i < std::min(sectors.distances_m.size(), max_sectors); ++i) {
+        const float distance_m = sectors.distances_m[i];
+        if (std::isfinite(distance_m)) {
+            obstacle_distance.distances[i] = distance_m > sectors.max_distance_m
+                                                 ? obstacle_distance.max_distance + 1
+                                                 : static_cast<uint16_t>(distance_m * 100.f);
+        }
+    }
+
+    mavlink_message_t message;
+    mavlink_msg_obstacle_distance_encode(1, MAV_COMP_ID_OBSTACLE_AVOIDANCE, &message, &obstacle_distance);
+    _mavlink_passthrough->send_message(message);
+}
+
 void AutopilotManager::create_avoidance_mavlink_heartbeat_message() {
     mavlink_heartbeat_t heartbeat;
     heartbeat.system_status = MAV_STATE_ACTIVE;
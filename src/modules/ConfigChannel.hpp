@@ -0,0 +1,104 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Versioned immutable configuration snapshots shared between the Autopilot Manager and the modules
+ * @file ConfigChannel.hpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+/**
+ * The Autopilot Manager publishes a new immutable configuration whenever it is set, and bumps the generation counter.
+ * Modules poll the generation with a single atomic load per tick and only fetch the snapshot, and re-derive their
+ * state from it, when the generation changed.
+ *
+ * The snapshot is stored before the generation is incremented, so a reader that sees a new generation always gets a
+ * configuration at least that recent. The owner of the channel can set a listener, e.g. to wake up a module that
+ * sleeps between ticks on every publish. Modules only get a read-only channel.
+ */
+template <typename T>
+class ConfigChannel {
+   public:
+    void publish(T config) {
+        std::atomic_store_explicit(&_config, std::make_shared<const T>(std::move(config)), std::memory_order_release);
+        _generation.fetch_add(1, std::memory_order_acq_rel);
+
+        std::lock_guard<std::mutex> lock(_listener_mutex);
+        if (_listener) {
+            _listener();
+        }
+    }
+
+    /**
+     * @brief Called from the publishing thread after every publish, replaces the previous listener. Pass nullptr to
+     * remove it.
+     */
+    void setPublishListener(std::function<void()> listener) {
+        std::lock_guard<std::mutex> lock(_listener_mutex);
+        _listener = std::move(listener);
+    }
+
+    /**
+     * @brief Generation of the latest configuration, 0 if none was published yet
+     */
+    uint64_t generation() const { return _generation.load(std::memory_order_acquire); }
+
+    std::shared_ptr<const T> latest() const { return std::atomic_load_explicit(&_config, std::memory_order_acquire); }
+
+    /**
+     * @brief Latest configuration if the generation changed since last_generation, which is then updated, or nullptr
+     */
+    std::shared_ptr<const T> poll(uint64_t& last_generation) const {
+        const uint64_t current = generation();
+        if (current == last_generation) {
+            return nullptr;
+        }
+        last_generation = current;
+        return latest();
+    }
+
+   private:
+    std::shared_ptr<const T> _config;
+    std::atomic<uint64_t> _generation{0};
+
+    std::mutex _listener_mutex;
+    std::function<void()> _listener;
+};
@@ -0,0 +1,185 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Lock-free single-producer/multi-consumer channel that always holds the latest frame
+ * @file FrameChannel.hpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+/**
+ * The producer publishes into one of a small set of slots and then advertises it as the latest one. A reader pins the
+ * latest slot with a per-slot reader count, copies the shared pointer out of it and unpins it again, so readers never
+ * take a lock and never block the producer. The producer only writes slots that are neither pinned nor the latest one,
+ * which with MaxReaders + 2 slots is always possible.
+ *
+ * Consumers that want to react to new frames instead of polling can block in wait_for_new(). The producer only takes
+ * the notification lock while somebody is waiting, so publishing stays lock-free otherwise.
+ */
+template <typename T, size_t MaxReaders = 4>
+class FrameChannel {
+   public:
+    struct Frame {
+        std::shared_ptr<const T> data;
+        uint64_t sequence{0};
+    };
+
+    // Frames referenced by the channel itself plus one frame per reader currently holding on to it
+    static constexpr size_t kMaxFramesInUse = 2 * MaxReaders + 2;
+
+    FrameChannel() = default;
+    FrameChannel(const FrameChannel&) = delete;
+    auto operator=(const FrameChannel&) -> const FrameChannel& = delete;
+
+    /**
+     * @brief Publish a new frame. Must only be called from one thread at a time.
+     * @return false if no slot was free, which can only happen with more than MaxReaders concurrent readers
+     */
+    bool publish(std::shared_ptr<const T> data) {
+        const uint32_t latest = _latest_slot.load(std::memory_order_relaxed);
+
+        for (uint32_t i = 0; i < kSlots; ++i) {
+            if (i == latest) {
+                continue;
+            }
+
+            Slot& slot = _slots[i];
+            uint32_t expected = 0;
+            if (!slot.readers.compare_exchange_strong(expected, kWriting, std::memory_order_acquire,
+                                                      std::memory_order_relaxed)) {
+                continue;
+            }
+
+            const uint64_t sequence = _sequence.load(std::memory_order_relaxed) + 1;
+            slot.data = std::move(data);
+            slot.sequence = sequence;
+            // Readers that bumped the count while we were writing back off again on their own
+            slot.readers.fetch_sub(kWriting, std::memory_order_release);
+
+            _latest_slot.store(i, std::memory_order_release);
+            _sequence.store(sequence, std::memory_order_seq_cst);
+
+            // Pairs with the waiter registration in wait_for_new(): either the waiter sees the new sequence, or we see
+            // the waiter and wake it up
+            if (_waiters.load(std::memory_order_seq_cst) > 0) {
+                std::lock_guard<std::mutex> lock(_wait_mutex);
+                _wait_condition.notify_all();
+            }
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Get the latest published frame, or an empty frame with sequence 0 if nothing was published yet
+     */
+    Frame latest() const {
+        while (true) {
+            const uint32_t index = _latest_slot.load(std::memory_order_acquire);
+            if (index == kNoSlot) {
+                return Frame{};
+            }
+
+            const Slot& slot = _slots[index];
+            const uint32_t readers = slot.readers.fetch_add(1, std::memory_order_acquire);
+            if ((readers & kWriting) != 0U || _latest_slot.load(std::memory_order_acquire) != index) {
+                // The producer lapped us and is rewriting or re-advertising this slot: try again
+                slot.readers.fetch_sub(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            Frame frame{slot.data, slot.sequence};
+            slot.readers.fetch_sub(1, std::memory_order_release);
+            return frame;
+        }
+    }
+
+    /**
+     * @brief Sequence number of the latest published frame (0 if none). Increases by one with every publication.
+     */
+    uint64_t sequence() const { return _sequence.load(std::memory_order_seq_cst); }
+
+    /**
+     * @brief Block until a frame newer than last_sequence is published or the timeout expires
+     * @return the latest sequence number, equal to last_sequence on timeout
+     */
+    template <typename Rep, typename Period>
+    uint64_t wait_for_new(uint64_t last_sequence, const std::chrono::duration<Rep, Period>& timeout) const {
+        uint64_t current = sequence();
+        if (current != last_sequence) {
+            return current;
+        }
+
+        _waiters.fetch_add(1, std::memory_order_seq_cst);
+        {
+            std::unique_lock<std::mutex> lock(_wait_mutex);
+            _wait_condition.wait_for(lock, timeout, [&]() {
+                current = sequence();
+                return current != last_sequence;
+            });
+        }
+        _waiters.fetch_sub(1, std::memory_order_relaxed);
+
+        return current;
+    }
+
+   private:
+    static constexpr uint32_t kSlots = MaxReaders + 2;
+    static constexpr uint32_t kNoSlot = UINT32_MAX;
+    static constexpr uint32_t kWriting = 1U << 31;
+
+    struct Slot {
+        mutable std::atomic<uint32_t> readers{0};
+        std::shared_ptr<const T> data;
+        uint64_t sequence{0};
+    };
+
+    std::array<Slot, kSlots> _slots;
+    std::atomic<uint32_t> _latest_slot{kNoSlot};
+    std::atomic<uint64_t> _sequence{0};
+
+    mutable std::atomic<uint32_t> _waiters{0};
+    mutable std::mutex _wait_mutex;
+    mutable std::condition_variable _wait_condition;
+};
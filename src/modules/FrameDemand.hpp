@@ -0,0 +1,175 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Consumer demand for the frames of a producer
+ * @file FrameDemand.hpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Lets the consumers of a FrameChannel tell the producer whether, and how often, they want new frames, so frames
+ * nobody is going to read are dropped before the producer spends any work on them.
+ *
+ * Each consumer registers once and then keeps its demand up to date from its own thread. The producer calls admit()
+ * for every incoming frame, which returns true if at least one active consumer is due for a new frame according to its
+ * maximum rate. Without any registered consumer every frame is admitted. Consumers reading the latest frame of the
+ * channel check it with wants(), so a frame left over from before they were activated is not taken for a new one.
+ */
+class FrameDemand {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    class Consumer {
+       public:
+        explicit Consumer(std::string name) : _name(std::move(name)) {}
+
+        const std::string& name() const { return _name; }
+
+        /**
+         * @brief Set whether frames are wanted at the moment, and at most how often (0 for every frame)
+         */
+        void setDemand(bool active, double max_rate_hz) {
+            const Clock::duration period =
+                max_rate_hz > 0.0
+                    ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / max_rate_hz))
+                    : Clock::duration::zero();
+            _period_ns.store(std::chrono::duration_cast<std::chrono::nanoseconds>(period).count(),
+                             std::memory_order_relaxed);
+            if (active && !this->active()) {
+                _activated_at = Clock::now();
+            }
+            _active.store(active, std::memory_order_relaxed);
+        }
+
+        bool active() const { return _active.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Whether a frame received at the given time is meant for the current demand. The latest frame of a
+         * channel can still be one from before the consumer was last activated, which is stale by now.
+         */
+        bool wants(Clock::time_point received_time) const { return active() && received_time >= _activated_at; }
+
+       private:
+        friend class FrameDemand;
+
+        const std::string _name;
+        std::atomic<bool> _active{false};
+        std::atomic<int64_t> _period_ns{0};
+
+        // Consumer side only
+        Clock::time_point _activated_at{};
+
+        // Producer side only
+        Clock::time_point _last_delivery{};
+        std::atomic<uint64_t> _delivered{0};
+        std::atomic<uint64_t> _dropped{0};
+        std::atomic<uint64_t> _inactive{0};
+    };
+
+    FrameDemand() = default;
+    FrameDemand(const FrameDemand&) = delete;
+    auto operator=(const FrameDemand&) -> FrameDemand& = delete;
+
+    /**
+     * @brief Register a consumer. It starts inactive, so it has to set its demand before receiving frames.
+     */
+    std::shared_ptr<Consumer> registerConsumer(std::string name) {
+        auto consumer = std::make_shared<Consumer>(std::move(name));
+        std::lock_guard<std::mutex> lock(_mutex);
+        _consumers.push_back(consumer);
+        return consumer;
+    }
+
+    /**
+     * @brief Decide whether an incoming frame is wanted, and count it for every consumer
+     */
+    bool admit(Clock::time_point now = Clock::now()) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_consumers.empty()) {
+            return true;
+        }
+
+        bool admitted = false;
+        for (const auto& consumer : _consumers) {
+            if (!consumer->active()) {
+                consumer->_inactive.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            // A frame arriving slightly early still counts as due, so camera jitter does not halve the rate
+            const auto period = std::chrono::nanoseconds(consumer->_period_ns.load(std::memory_order_relaxed));
+            if (now - consumer->_last_delivery >= period - period / kEarlyFraction) {
+                consumer->_last_delivery = now;
+                consumer->_delivered.fetch_add(1, std::memory_order_relaxed);
+                admitted = true;
+            } else {
+                consumer->_dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        return admitted;
+    }
+
+    /**
+     * @brief Print the frames delivered to, dropped for and skipped while inactive of every consumer
+     */
+    void printStats(std::ostream& os) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        os << std::left << std::setw(24) << "consumer" << std::right << std::setw(12) << "delivered" << std::setw(12)
+           << "dropped" << std::setw(12) << "inactive" << std::endl;
+        for (const auto& consumer : _consumers) {
+            os << std::left << std::setw(24) << consumer->name() << std::right << std::setw(12)
+               << consumer->_delivered.load(std::memory_order_relaxed) << std::setw(12)
+               << consumer->_dropped.load(std::memory_order_relaxed) << std::setw(12)
+               << consumer->_inactive.load(std::memory_order_relaxed) << std::endl;
+        }
+    }
+
+   private:
+    static constexpr int kEarlyFraction = 10;
+
+    mutable std::mutex _mutex;
+    std::vector<std::shared_ptr<Consumer>> _consumers;
+};
@@ -0,0 +1,112 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Fixed-capacity pool of reusable, reference-counted frames
+ * @file FramePool.hpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * All frames are allocated up front. A frame handed out by acquire() goes back to the pool as soon as the last
+ * consumer releases its reference, so frames can travel through a FrameChannel without any further heap allocation.
+ * Only the producer thread may call reset() and acquire().
+ */
+template <typename T>
+class FramePool {
+   public:
+    FramePool() = default;
+    FramePool(const FramePool&) = delete;
+    auto operator=(const FramePool&) -> const FramePool& = delete;
+
+    /**
+     * @brief (Re)allocate the pool with capacity frames, each prepared by the initializer
+     */
+    void reset(size_t capacity, const std::function<void(T&)>& initializer) {
+        _frames.clear();
+        _frames.reserve(capacity);
+        for (size_t i = 0; i < capacity; ++i) {
+            auto frame = std::make_shared<T>();
+            initializer(*frame);
+            _frames.push_back(std::move(frame));
+        }
+        _next = 0;
+        _allocations.fetch_add(capacity, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get a frame nobody else references anymore, or nullptr if all of them are still in use
+     */
+    std::shared_ptr<T> acquire() {
+        for (size_t i = 0; i < _frames.size(); ++i) {
+            const size_t index = (_next + i) % _frames.size();
+            // Only the pool holds a reference, and only this thread can hand out new ones
+            if (_frames[index].use_count() == 1) {
+                // Make sure the writes of the last consumer are visible before the frame is reused
+                std::atomic_thread_fence(std::memory_order_acquire);
+                _next = index + 1;
+                return _frames[index];
+            }
+        }
+
+        _exhausted.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    size_t capacity() const { return _frames.size(); }
+
+    /**
+     * @brief Number of frames allocated by the pool since it was created
+     */
+    uint64_t allocations() const { return _allocations.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Number of acquire() calls that found no free frame
+     */
+    uint64_t exhausted() const { return _exhausted.load(std::memory_order_relaxed); }
+
+   private:
+    std::vector<std::shared_ptr<T>> _frames;
+    size_t _next{0};
+
+    std::atomic<uint64_t> _allocations{0};
+    std::atomic<uint64_t> _exhausted{0};
+};
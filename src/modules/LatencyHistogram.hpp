@@ -0,0 +1,123 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Fixed-bucket latency histogram
+ * @file LatencyHistogram.hpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <string>
+
+/**
+ * Counts latencies into fixed buckets with lock-free counters, so it can be recorded from a real-time thread and
+ * printed from another one. take() returns the counts since the previous call and resets them.
+ */
+class LatencyHistogram {
+   public:
+    static constexpr std::array<uint32_t, 8> kBucketUpperBoundsUs{50, 100, 200, 500, 1000, 2000, 5000, 10000};
+    static constexpr size_t kBuckets = kBucketUpperBoundsUs.size() + 1;
+
+    struct Snapshot {
+        std::array<uint64_t, kBuckets> counts{};
+        uint64_t samples{0};
+        uint64_t sum_us{0};
+        uint64_t max_us{0};
+    };
+
+    explicit LatencyHistogram(std::string name) : _name(std::move(name)) {}
+
+    const std::string& name() const { return _name; }
+
+    void record(std::chrono::steady_clock::duration latency) {
+        const int64_t latency_count_us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+        const auto latency_us = static_cast<uint64_t>(std::max<int64_t>(0, latency_count_us));
+        const size_t bucket = std::upper_bound(kBucketUpperBoundsUs.begin(), kBucketUpperBoundsUs.end(), latency_us) -
+                              kBucketUpperBoundsUs.begin();
+        _counts[bucket].fetch_add(1, std::memory_order_relaxed);
+        _samples.fetch_add(1, std::memory_order_relaxed);
+        _sum_us.fetch_add(latency_us, std::memory_order_relaxed);
+        uint64_t max_us = _max_us.load(std::memory_order_relaxed);
+        while (latency_us > max_us && !_max_us.compare_exchange_weak(max_us, latency_us, std::memory_order_relaxed)) {
+        }
+    }
+
+    Snapshot take() {
+        Snapshot snapshot;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            snapshot.counts[i] = _counts[i].exchange(0, std::memory_order_relaxed);
+        }
+        snapshot.samples = _samples.exchange(0, std::memory_order_relaxed);
+        snapshot.sum_us = _sum_us.exchange(0, std::memory_order_relaxed);
+        snapshot.max_us = _max_us.exchange(0, std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    /**
+     * @brief Print the counts since the previous call and reset them
+     */
+    void print(std::ostream& os) {
+        const Snapshot snapshot = take();
+        os << "=== " << _name << " latency [us] ===" << std::endl;
+        if (snapshot.samples == 0) {
+            os << "no samples" << std::endl;
+            return;
+        }
+        for (size_t i = 0; i < kBuckets; ++i) {
+            if (i < kBucketUpperBoundsUs.size()) {
+                os << "<" << std::left << std::setw(9) << kBucketUpperBoundsUs[i];
+            } else {
+                os << ">=" << std::left << std::setw(8) << kBucketUpperBoundsUs.back();
+            }
+            os << std::right << std::setw(10) << snapshot.counts[i] << std::endl;
+        }
+        os << "samples " << snapshot.samples << "  mean " << snapshot.sum_us / snapshot.samples << "  max "
+           << snapshot.max_us << std::endl;
+    }
+
+   private:
+    const std::string _name;
+    std::array<std::atomic<uint64_t>, kBuckets> _counts{};
+    std::atomic<uint64_t> _samples{0};
+    std::atomic<uint64_t> _sum_us{0};
+    std::atomic<uint64_t> _max_us{0};
+};
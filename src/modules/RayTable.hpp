@@ -0,0 +1,109 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Per-pixel camera ray lookup table for the downsampled depth grid
+ * @file RayTable.hpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#pragma once
+
+#include <image_downsampler/DataTypes.h>
+
+#include <Eigen/Core>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Holds, for every pixel of the downsampled grid, the camera ray scaled to unit depth, i.e.
+ * (pixel - principal_point) * inverse_focal_length. A pixel at depth d is then (ray * d, d) in the camera frame. The
+ * table only depends on the adapted intrinsics, so it is built once and shared by every frame until they change.
+ */
+class RayTable {
+   public:
+    struct Ray {
+        Eigen::Vector2f direction;  // x and y of the ray at unit depth
+        float lateral_scale;        // distance from the optical axis at unit depth
+    };
+
+    explicit RayTable(const RectifiedIntrinsicsF& intrinsics)
+        : _width(intrinsics.rw),
+          _height(intrinsics.rh),
+          _principal_point(intrinsics.principal_point()),
+          _inverse_focal_length(intrinsics.inverse_focal_length()) {
+        _rays.resize(static_cast<size_t>(_width) * _height);
+        for (uint32_t y = 0; y < _height; ++y) {
+            for (uint32_t x = 0; x < _width; ++x) {
+                Ray& ray = _rays[y * _width + x];
+                ray.direction = (Eigen::Vector2f(static_cast<float>(x), static_cast<float>(y)) - _principal_point)
+                                    .cwiseProduct(_inverse_focal_length);
+                ray.lateral_scale = ray.direction.norm();
+            }
+        }
+    }
+
+    /**
+     * @brief Whether the table was built for these intrinsics and can be reused
+     */
+    bool matches(const RectifiedIntrinsicsF& intrinsics) const {
+        return intrinsics.rw == _width && intrinsics.rh == _height &&
+               intrinsics.principal_point() == _principal_point &&
+               intrinsics.inverse_focal_length() == _inverse_focal_length;
+    }
+
+    uint32_t width() const { return _width; }
+    uint32_t height() const { return _height; }
+
+    bool contains(uint32_t x, uint32_t y) const { return x < _width && y < _height; }
+
+    /**
+     * @brief Ray of a pixel on the downsampled grid. The pixel must be inside the grid.
+     */
+    const Ray& ray(uint32_t x, uint32_t y) const { return _rays[y * _width + x]; }
+
+    /**
+     * @brief Point in the camera frame of a pixel at the given depth
+     */
+    Eigen::Vector3f point(uint32_t x, uint32_t y, float depth) const {
+        const Ray& r = ray(x, y);
+        return Eigen::Vector3f(r.direction.x() * depth, r.direction.y() * depth, depth);
+    }
+
+   private:
+    uint32_t _width;
+    uint32_t _height;
+    Eigen::Vector2f _principal_point;
+    Eigen::Vector2f _inverse_focal_length;
+    std::vector<Ray> _rays;
+};
@@ -0,0 +1,135 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Sequence lock for small, frequently read values
+ * @file SeqLock.hpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+/**
+ * Writers bump the sequence to odd, store the value and bump it back to even. Readers copy the value and retry when
+ * the sequence was odd or changed meanwhile, so they never block a writer and always get a value written in one shot.
+ *
+ * The value is kept in relaxed atomic words rather than as a plain T, so the concurrent copies are well defined.
+ * Writers are serialized by a mutex; they are expected to be telemetry callbacks, far less frequent than reads.
+ */
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock values are copied word by word");
+
+   public:
+    explicit SeqLock(const T& value = T{}) { store_words(value); }
+
+    SeqLock(const SeqLock&) = delete;
+    auto operator=(const SeqLock&) -> SeqLock& = delete;
+
+    /**
+     * @brief Consistent copy of the value
+     */
+    T load() const {
+        T value;
+        uint64_t before;
+        uint64_t after;
+        do {
+            before = _sequence.load(std::memory_order_acquire);
+            while (before & 1U) {
+                std::this_thread::yield();
+                before = _sequence.load(std::memory_order_acquire);
+            }
+            load_words(value);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = _sequence.load(std::memory_order_relaxed);
+        } while (before != after);
+        return value;
+    }
+
+    /**
+     * @brief Modify the value in place, readers see either all or none of the changes
+     */
+    template <typename Update>
+    void update(Update&& update) {
+        std::lock_guard<std::mutex> lock(_writer_mutex);
+        T value;
+        load_words(value);
+        update(value);
+
+        const uint64_t sequence = _sequence.load(std::memory_order_relaxed);
+        _sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        store_words(value);
+        _sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    void store(const T& value) {
+        update([&value](T& current) { current = value; });
+    }
+
+    /**
+     * @brief Number of completed writes
+     */
+    uint64_t writes() const { return _sequence.load(std::memory_order_acquire) / 2; }
+
+   private:
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    void load_words(T& value) const {
+        std::array<uint64_t, kWords> words;
+        for (size_t i = 0; i < kWords; ++i) {
+            words[i] = _words[i].load(std::memory_order_relaxed);
+        }
+        std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+    }
+
+    void store_words(const T& value) {
+        std::array<uint64_t, kWords> words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+        for (size_t i = 0; i < kWords; ++i) {
+            _words[i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<uint64_t> _sequence{0};
+    std::array<std::atomic<uint64_t>, kWords> _words{};
+    std::mutex _writer_mutex;
+};
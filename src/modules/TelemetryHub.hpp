@@ -0,0 +1,399 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Single MAVSDK telemetry and MAVLink subscription point shared by the modules
+ * @file TelemetryHub.hpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// MAVSDK dependencies
+#include <mavsdk/mavsdk.h>
+#include <mavsdk/plugins/mavlink_passthrough/mavlink_passthrough.h>
+#include <mavsdk/plugins/telemetry/telemetry.h>
+
+/**
+ * @brief Message and callback time counters of one stream
+ */
+class TelemetryStreamStats {
+   public:
+    struct Stats {
+        uint64_t messages{0};
+        uint64_t callback_time_ns{0};
+        uint64_t callback_time_max_ns{0};
+    };
+
+    explicit TelemetryStreamStats(std::string name) : _name(std::move(name)) {}
+
+    const std::string& name() const { return _name; }
+
+    /**
+     * @brief Counters since the previous call
+     */
+    Stats take() {
+        Stats stats;
+        stats.messages = _messages.exchange(0, std::memory_order_relaxed);
+        stats.callback_time_ns = _callback_time_ns.exchange(0, std::memory_order_relaxed);
+        stats.callback_time_max_ns = _callback_time_max_ns.exchange(0, std::memory_order_relaxed);
+        return stats;
+    }
+
+   protected:
+    void record(uint64_t callback_time_ns) {
+        _messages.fetch_add(1, std::memory_order_relaxed);
+        _callback_time_ns.fetch_add(callback_time_ns, std::memory_order_relaxed);
+        uint64_t max = _callback_time_max_ns.load(std::memory_order_relaxed);
+        while (callback_time_ns > max &&
+               !_callback_time_max_ns.compare_exchange_weak(max, callback_time_ns, std::memory_order_relaxed)) {
+        }
+    }
+
+   private:
+    std::string _name;
+    std::atomic<uint64_t> _messages{0};
+    std::atomic<uint64_t> _callback_time_ns{0};
+    std::atomic<uint64_t> _callback_time_max_ns{0};
+};
+
+/**
+ * Fans one MAVSDK subscription out to any number of listeners. Every listener gets a const reference to the same
+ * message. The listener list is replaced copy-on-write, so dispatching never takes a lock.
+ */
+template <typename T>
+class TelemetryStream : public TelemetryStreamStats {
+   public:
+    using Listener = std::function<void(const T&)>;
+
+    using TelemetryStreamStats::TelemetryStreamStats;
+
+    /**
+     * @brief Add a listener
+     * @return id to remove the listener with
+     */
+    uint64_t addListener(Listener listener) {
+        std::lock_guard<std::mutex> lock(_listeners_mutex);
+        const auto current = std::atomic_load_explicit(&_listeners, std::memory_order_acquire);
+        auto listeners = current != nullptr ? std::make_shared<std::vector<Entry>>(*current)
+                                            : std::make_shared<std::vector<Entry>>();
+        const uint64_t id = ++_last_id;
+        listeners->push_back({id, std::move(listener)});
+        std::atomic_store_explicit(&_listeners, std::shared_ptr<const std::vector<Entry>>(std::move(listeners)),
+                                   std::memory_order_release);
+        return id;
+    }
+
+    /**
+     * @brief Remove a listener. A dispatch already in progress may still call it once.
+     */
+    void removeListener(uint64_t id) {
+        std::lock_guard<std::mutex> lock(_listeners_mutex);
+        const auto current = std::atomic_load_explicit(&_listeners, std::memory_order_acquire);
+        if (current == nullptr) {
+            return;
+        }
+        auto listeners = std::make_shared<std::vector<Entry>>();
+        std::copy_if(current->begin(), current->end(), std::back_inserter(*listeners),
+                     [id](const Entry& entry) { return entry.id != id; });
+        std::atomic_store_explicit(&_listeners, std::shared_ptr<const std::vector<Entry>>(std::move(listeners)),
+                                   std::memory_order_release);
+    }
+
+    /**
+     * @brief Mark the stream as subscribed to
+     * @return true the first time, the caller then has to subscribe to the MAVSDK stream
+     */
+    bool markSubscribed() { return !_subscribed.exchange(true); }
+
+    /**
+     * @brief Mark the stream as unsubscribed from
+     * @return true if it was subscribed to, the caller then has to unsubscribe from the MAVSDK stream
+     */
+    bool markUnsubscribed() { return _subscribed.exchange(false); }
+
+    void clearListeners() {
+        std::lock_guard<std::mutex> lock(_listeners_mutex);
+        std::atomic_store_explicit(&_listeners, std::shared_ptr<const std::vector<Entry>>(), std::memory_order_release);
+    }
+
+    void dispatch(const T& message) {
+        const auto start = std::chrono::steady_clock::now();
+        const auto listeners = std::atomic_load_explicit(&_listeners, std::memory_order_acquire);
+        if (listeners != nullptr) {
+            for (const Entry& entry : *listeners) {
+                entry.listener(message);
+            }
+        }
+        record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+
+   private:
+    struct Entry {
+        uint64_t id;
+        Listener listener;
+    };
+
+    std::mutex _listeners_mutex;
+    std::shared_ptr<const std::vector<Entry>> _listeners;
+    uint64_t _last_id{0};
+    std::atomic<bool> _subscribed{false};
+};
+
+/**
+ * Owns the only Telemetry and MavlinkPassthrough plugin instances of the vehicle. Each MAVSDK stream is subscribed to
+ * once, when its first listener is added, and every message is dispatched to all module listeners of that stream.
+ * Listeners run on the MAVSDK callback thread and should return quickly; the per-stream rate and callback time are
+ * reported by printStats().
+ */
+class TelemetryHub {
+   public:
+    using Telemetry = mavsdk::Telemetry;
+
+    /**
+     * Returned by the add*Listener() methods. Modules remove their listeners in deinit(), so the hub does not call into
+     * a module that is being destroyed.
+     */
+    class ListenerHandle {
+       public:
+        ListenerHandle() = default;
+
+        void remove() {
+            if (_remove) {
+                _remove();
+                _remove = nullptr;
+            }
+        }
+
+       private:
+        friend class TelemetryHub;
+
+        explicit ListenerHandle(std::function<void()> remove) : _remove(std::move(remove)) {}
+
+        std::function<void()> _remove;
+    };
+
+    explicit TelemetryHub(std::shared_ptr<mavsdk::System> mavsdk_system)
+        : _telemetry(std::make_shared<Telemetry>(mavsdk_system)),
+          _mavlink_passthrough(std::make_shared<mavsdk::MavlinkPassthrough>(mavsdk_system)),
+          _stats_time(std::chrono::steady_clock::now()) {}
+
+    ~TelemetryHub() { shutdown(); }
+
+    TelemetryHub(const TelemetryHub&) = delete;
+    auto operator=(const TelemetryHub&) -> TelemetryHub& = delete;
+
+    /**
+     * @brief Shared plugin for requests and polled values, subscribe through the hub instead
+     */
+    std::shared_ptr<Telemetry> telemetry() const { return _telemetry; }
+
+    /**
+     * @brief Shared plugin for sending messages, subscribe through the hub instead
+     */
+    std::shared_ptr<mavsdk::MavlinkPassthrough> mavlink_passthrough() const { return _mavlink_passthrough; }
+
+    ListenerHandle addOdometryListener(TelemetryStream<Telemetry::Odometry>::Listener listener) {
+        return addListener(_odometry, std::move(listener), [this]() {
+            _telemetry->subscribe_odometry([this](Telemetry::Odometry odometry) { _odometry.dispatch(odometry); });
+        });
+    }
+
+    ListenerHandle addArmedListener(TelemetryStream<bool>::Listener listener) {
+        return addListener(_armed, std::move(listener), [this]() {
+            _telemetry->subscribe_armed([this](bool armed) { _armed.dispatch(armed); });
+        });
+    }
+
+    ListenerHandle addPositionListener(TelemetryStream<Telemetry::Position>::Listener listener) {
+        return addListener(_position, std::move(listener), [this]() {
+            _telemetry->subscribe_position([this](Telemetry::Position position) { _position.dispatch(position); });
+        });
+    }
+
+    ListenerHandle addHealthListener(TelemetryStream<Telemetry::Health>::Listener listener) {
+        return addListener(_health, std::move(listener), [this]() {
+            _telemetry->subscribe_health([this](Telemetry::Health health) { _health.dispatch(health); });
+        });
+    }
+
+    ListenerHandle addPositionVelocityNedListener(TelemetryStream<Telemetry::PositionVelocityNed>::Listener listener) {
+        return addListener(_position_velocity_ned, std::move(listener), [this]() {
+            _telemetry->subscribe_position_velocity_ned([this](Telemetry::PositionVelocityNed position_velocity) {
+                _position_velocity_ned.dispatch(position_velocity);
+            });
+        });
+    }
+
+    ListenerHandle addAttitudeEulerListener(TelemetryStream<Telemetry::EulerAngle>::Listener listener) {
+        return addListener(_attitude_euler, std::move(listener), [this]() {
+            _telemetry->subscribe_attitude_euler(
+                [this](Telemetry::EulerAngle euler_angle) { _attitude_euler.dispatch(euler_angle); });
+        });
+    }
+
+    ListenerHandle addFlightModeListener(TelemetryStream<Telemetry::FlightMode>::Listener listener) {
+        return addListener(_flight_mode, std::move(listener), [this]() {
+            _telemetry->subscribe_flight_mode(
+                [this](Telemetry::FlightMode flight_mode) { _flight_mode.dispatch(flight_mode); });
+        });
+    }
+
+    ListenerHandle addLandedStateListener(TelemetryStream<Telemetry::LandedState>::Listener listener) {
+        return addListener(_landed_state, std::move(listener), [this]() {
+            _telemetry->subscribe_landed_state(
+                [this](Telemetry::LandedState landed_state) { _landed_state.dispatch(landed_state); });
+        });
+    }
+
+    ListenerHandle addMavlinkMessageListener(uint16_t message_id,
+                                             TelemetryStream<mavlink_message_t>::Listener listener) {
+        std::lock_guard<std::mutex> lock(_mavlink_streams_mutex);
+        auto& stream = _mavlink_streams[message_id];
+        if (stream == nullptr) {
+            stream = std::make_unique<TelemetryStream<mavlink_message_t>>("mavlink #" + std::to_string(message_id));
+        }
+        TelemetryStream<mavlink_message_t>* const mavlink_stream = stream.get();
+        return addListener(*mavlink_stream, std::move(listener), [this, message_id, mavlink_stream]() {
+            _mavlink_passthrough->subscribe_message_async(
+                message_id, [mavlink_stream](const mavlink_message_t& message) { mavlink_stream->dispatch(message); });
+        });
+    }
+
+    /**
+     * @brief Unsubscribe from every MAVSDK stream and drop all listeners
+     *
+     * The plugins are shared with the modules and can outlive the hub, so their callbacks into the hub are removed
+     * here. Called by the destructor, and by the owner before it destroys the modules the listeners call into.
+     */
+    void shutdown() {
+        unsubscribe(_odometry, [this]() { _telemetry->subscribe_odometry(nullptr); });
+        unsubscribe(_armed, [this]() { _telemetry->subscribe_armed(nullptr); });
+        unsubscribe(_position, [this]() { _telemetry->subscribe_position(nullptr); });
+        unsubscribe(_health, [this]() { _telemetry->subscribe_health(nullptr); });
+        unsubscribe(_position_velocity_ned, [this]() { _telemetry->subscribe_position_velocity_ned(nullptr); });
+        unsubscribe(_attitude_euler, [this]() { _telemetry->subscribe_attitude_euler(nullptr); });
+        unsubscribe(_flight_mode, [this]() { _telemetry->subscribe_flight_mode(nullptr); });
+        unsubscribe(_landed_state, [this]() { _telemetry->subscribe_landed_state(nullptr); });
+
+        std::lock_guard<std::mutex> lock(_mavlink_streams_mutex);
+        for (const auto& mavlink_stream : _mavlink_streams) {
+            const uint16_t message_id = mavlink_stream.first;
+            unsubscribe(*mavlink_stream.second,
+                        [this, message_id]() { _mavlink_passthrough->subscribe_message_async(message_id, nullptr); });
+        }
+    }
+
+    /**
+     * @brief Print the rate and callback time of every stream since the previous call
+     */
+    void printStats(std::ostream& os) {
+        const auto now = std::chrono::steady_clock::now();
+        const double elapsed_s = std::max(std::chrono::duration<double>(now - _stats_time).count(), 1e-3);
+        _stats_time = now;
+
+        std::vector<TelemetryStreamStats*> streams{
+            &_odometry, &_armed, &_position, &_health, &_position_velocity_ned, &_attitude_euler, &_flight_mode,
+            &_landed_state};
+        {
+            std::lock_guard<std::mutex> lock(_mavlink_streams_mutex);
+            for (const auto& mavlink_stream : _mavlink_streams) {
+                streams.push_back(mavlink_stream.second.get());
+            }
+        }
+
+        os << "=== Telemetry hub statistics ===" << std::endl;
+        os << std::left << std::setw(24) << "stream" << std::right << std::setw(10) << "rate [Hz]" << std::setw(14)
+           << "mean [us]" << std::setw(14) << "max [us]" << std::endl;
+        for (TelemetryStreamStats* stream : streams) {
+            const TelemetryStreamStats::Stats stats = stream->take();
+            if (stats.messages == 0) {
+                continue;
+            }
+            os << std::left << std::setw(24) << stream->name() << std::right << std::fixed << std::setprecision(1)
+               << std::setw(10) << stats.messages / elapsed_s << std::setprecision(2) << std::setw(14)
+               << stats.callback_time_ns * 1e-3 / stats.messages << std::setw(14) << stats.callback_time_max_ns * 1e-3
+               << std::endl;
+        }
+    }
+
+   private:
+    template <typename T, typename Subscribe>
+    static ListenerHandle addListener(TelemetryStream<T>& stream, typename TelemetryStream<T>::Listener listener,
+                                      Subscribe subscribe) {
+        const uint64_t id = stream.addListener(std::move(listener));
+        if (stream.markSubscribed()) {
+            subscribe();
+        }
+        return ListenerHandle([&stream, id]() { stream.removeListener(id); });
+    }
+
+    template <typename T, typename Unsubscribe>
+    static void unsubscribe(TelemetryStream<T>& stream, Unsubscribe unsubscribe) {
+        if (stream.markUnsubscribed()) {
+            unsubscribe();
+        }
+        stream.clearListeners();
+    }
+
+    TelemetryStream<Telemetry::Odometry> _odometry{"odometry"};
+    TelemetryStream<bool> _armed{"armed"};
+    TelemetryStream<Telemetry::Position> _position{"position"};
+    TelemetryStream<Telemetry::Health> _health{"health"};
+    TelemetryStream<Telemetry::PositionVelocityNed> _position_velocity_ned{"position velocity ned"};
+    TelemetryStream<Telemetry::EulerAngle> _attitude_euler{"attitude euler"};
+    TelemetryStream<Telemetry::FlightMode> _flight_mode{"flight mode"};
+    TelemetryStream<Telemetry::LandedState> _landed_state{"landed state"};
+
+    std::mutex _mavlink_streams_mutex;
+    std::map<uint16_t, std::unique_ptr<TelemetryStream<mavlink_message_t>>> _mavlink_streams;
+
+    // Declared after the streams, so the plugins go first if the hub is their last owner
+    std::shared_ptr<Telemetry> _telemetry;
+    std::shared_ptr<mavsdk::MavlinkPassthrough> _mavlink_passthrough;
+
+    std::chrono::steady_clock::time_point _stats_time;
+};
@@ -0,0 +1,83 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Vehicle state snapshot shared between the modules
+ * @file VehicleState.hpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#pragma once
+
+#include <Eigen/Core>
+#include <SeqLock.hpp>
+#include <chrono>
+#include <cmath>
+
+/**
+ * Latest vehicle telemetry, each group stamped with the time its source last updated it. Plain fields only, so a
+ * snapshot is copied out of the sequence lock in one go.
+ */
+struct VehicleState {
+    using Clock = std::chrono::steady_clock;
+
+    // Global position
+    double latitude_deg{0.0};
+    double longitude_deg{0.0};
+    double altitude_amsl_m{0.0};
+    Clock::time_point global_position_time{};
+
+    // Local position and velocity, NED
+    double x_m{NAN};
+    double y_m{NAN};
+    double z_m{NAN};
+    double vx_m_s{NAN};
+    double vy_m_s{NAN};
+    double vz_m_s{NAN};
+    Clock::time_point local_position_time{};
+
+    // Heading
+    double yaw_rad{NAN};
+    Clock::time_point attitude_time{};
+
+    // Estimator health
+    bool global_position_ok{false};
+    bool home_position_ok{false};
+    Clock::time_point health_time{};
+
+    Eigen::Vector3f velocity_ned() const {
+        return Eigen::Vector3f(static_cast<float>(vx_m_s), static_cast<float>(vy_m_s), static_cast<float>(vz_m_s));
+    }
+};
+
+using VehicleStateLock = SeqLock<VehicleState>;
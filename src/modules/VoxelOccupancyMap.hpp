@@ -0,0 +1,333 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Fixed-memory hashed voxel occupancy map with decay
+ * @file VoxelOccupancyMap.hpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#pragma once
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+/**
+ * Sparse occupancy of the space around the vehicle, so obstacles are remembered after they left the camera field of
+ * view. Voxels live in an open addressing hash table whose size is fixed by the memory budget; nothing is allocated
+ * after construction.
+ *
+ * Every voxel keeps an occupancy score that grows by one per insertion batch in which it was hit and halves every
+ * half_life_s without new hits. Voxels whose score has decayed away are reused by new voxels. When the probe window of
+ * a new voxel is full, the voxel with the lowest score in the window is evicted, so the map degrades gracefully when
+ * the budget is too small for the observed space.
+ *
+ * Stamps are whole milliseconds since the map was created, so their resolution does not degrade with the uptime. They
+ * wrap after 49 days, which only matters for voxels that were not seen for that long and have long expired.
+ *
+ * All methods are thread-safe. Insertions take the lock for the whole batch.
+ */
+class VoxelOccupancyMap {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Parameters {
+        float voxel_size_m{0.2f};
+        size_t memory_budget_bytes{8U << 20U};
+        float half_life_s{2.f};
+        float occupied_score{1.5f};  // a voxel needs to be seen in two batches before it counts as occupied
+        float max_score{8.f};
+    };
+
+    explicit VoxelOccupancyMap(const Parameters& parameters)
+        : _parameters(parameters), _inverse_voxel_size(1.f / parameters.voxel_size_m), _epoch(Clock::now()) {
+        // Largest power of two number of slots within the budget
+        size_t capacity = kProbeWindow;
+        while (capacity * 2 * sizeof(Slot) <= _parameters.memory_budget_bytes) {
+            capacity *= 2;
+        }
+        _slots.assign(capacity, Slot{});
+        _capacity_bits = 0;
+        while ((size_t{1} << _capacity_bits) < capacity) {
+            _capacity_bits++;
+        }
+
+        // Age after which even a voxel with the maximum score has decayed below a tenth of the occupied score
+        _expiry_age_ms = static_cast<uint32_t>(std::ceil(
+            1000.f * _parameters.half_life_s * std::log2(_parameters.max_score / (0.1f * _parameters.occupied_score))));
+        _inverse_half_life_ms = 1.f / (1000.f * _parameters.half_life_s);
+    }
+
+    /**
+     * @brief Add the points of one frame to the map, in the map frame
+     */
+    void insert(const std::vector<Eigen::Vector3f>& points, Clock::time_point time) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const uint32_t now_ms = milliseconds(time);
+
+        uint64_t previous_key = kEmpty;
+        for (const Eigen::Vector3f& point : points) {
+            const uint64_t key = voxelKey(point);
+            // Neighbouring points mostly fall into the same voxel
+            if (key == previous_key) {
+                continue;
+            }
+            previous_key = key;
+
+            Slot& slot = findOrInsert(key, now_ms);
+            if (slot.stamp_ms != now_ms) {
+                slot.score = std::min(_parameters.max_score, decayedScore(slot, now_ms) + 1.f);
+                slot.stamp_ms = now_ms;
+            }
+        }
+    }
+
+    bool isOccupied(const Eigen::Vector3f& point, Clock::time_point time) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return isOccupied(voxelKey(point), milliseconds(time));
+    }
+
+    /**
+     * @brief Distance along a ray to the closest occupied voxel that may reach into the corridor of radius_m around it
+     * @param direction unit vector
+     * @return distance to the voxel centre projected on the ray, infinity if there is none within max_distance_m
+     */
+    float nearestOccupiedAlongRay(const Eigen::Vector3f& origin, const Eigen::Vector3f& direction,
+                                  float max_distance_m, float radius_m, Clock::time_point time) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const uint32_t now_ms = milliseconds(time);
+        const float voxel_size = _parameters.voxel_size_m;
+        // A voxel can overlap the corridor if its centre is within half its diagonal of it
+        const float reach = radius_m + 0.5f * std::sqrt(3.f) * voxel_size;
+
+        // Sweep the voxel slices across the dominant axis of the ray in order of distance, so every voxel is checked
+        // once and the sweep can stop at the first slice beyond the nearest hit
+        int axis = 0;
+        direction.cwiseAbs().maxCoeff(&axis);
+        const int u = (axis + 1) % 3;
+        const int w = (axis + 2) % 3;
+        const float d_axis = direction[axis];
+        const int slice_step = d_axis > 0.f ? 1 : -1;
+        const Eigen::Vector3f end = origin + direction * max_distance_m;
+        const int slice_first = static_cast<int>(std::floor((origin[axis] - slice_step * reach) * _inverse_voxel_size));
+        const int slice_last = static_cast<int>(std::floor((end[axis] + slice_step * reach) * _inverse_voxel_size));
+
+        const auto index_range = [&](int coordinate, float t_min, float t_max, int& first, int& last) {
+            const float a = origin[coordinate] + direction[coordinate] * t_min;
+            const float b = origin[coordinate] + direction[coordinate] * t_max;
+            first = static_cast<int>(std::ceil((std::min(a, b) - reach) * _inverse_voxel_size - 0.5f));
+            last = static_cast<int>(std::floor((std::max(a, b) + reach) * _inverse_voxel_size - 0.5f));
+        };
+
+        float nearest = std::numeric_limits<float>::infinity();
+        for (int slice = slice_first; slice != slice_last + slice_step; slice += slice_step) {
+            // Range of the ray in which voxel centres of this slice can be within reach
+            const float centre = (slice + 0.5f) * voxel_size;
+            const float t_a = (centre - reach - origin[axis]) / d_axis;
+            const float t_b = (centre + reach - origin[axis]) / d_axis;
+            const float t_min = std::max(0.f, std::min(t_a, t_b));
+            const float t_max = std::min(max_distance_m, std::max(t_a, t_b));
+            if (t_min > nearest) {
+                break;
+            }
+            if (t_min > t_max) {
+                continue;
+            }
+
+            int u_first = 0, u_last = 0, w_first = 0, w_last = 0;
+            index_range(u, t_min, t_max, u_first, u_last);
+            index_range(w, t_min, t_max, w_first, w_last);
+
+            Eigen::Vector3i index;
+            index[axis] = slice;
+            for (index[u] = u_first; index[u] <= u_last; ++index[u]) {
+                for (index[w] = w_first; index[w] <= w_last; ++index[w]) {
+                    if (!isOccupied(packKey(index), now_ms)) {
+                        continue;
+                    }
+                    const Eigen::Vector3f offset =
+                        (index.cast<float>() + Eigen::Vector3f::Constant(0.5f)) * voxel_size - origin;
+                    const float along = offset.dot(direction);
+                    if (along >= 0.f && along < nearest && (offset - direction * along).norm() <= reach) {
+                        nearest = along;
+                    }
+                }
+            }
+        }
+
+        return nearest <= max_distance_m ? nearest : std::numeric_limits<float>::infinity();
+    }
+
+    size_t capacity() const { return _slots.size(); }
+    size_t memoryBytes() const { return _slots.size() * sizeof(Slot); }
+    float voxelSize() const { return _parameters.voxel_size_m; }
+
+    /**
+     * @brief Number of slots that hold a voxel which has not decayed away yet
+     */
+    size_t size(Clock::time_point time) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const uint32_t now_ms = milliseconds(time);
+        return std::count_if(_slots.begin(), _slots.end(),
+                             [&](const Slot& slot) { return slot.key != kEmpty && !isExpired(slot, now_ms); });
+    }
+
+    uint64_t evictions() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _evictions;
+    }
+
+   private:
+    struct Slot {
+        uint64_t key{kEmpty};
+        float score{0.f};
+        uint32_t stamp_ms{0};
+    };
+
+    static constexpr uint64_t kEmpty = std::numeric_limits<uint64_t>::max();
+    static constexpr size_t kProbeWindow = 16;
+    static constexpr int kKeyBits = 21;
+    static constexpr int kKeyOffset = 1 << (kKeyBits - 1);
+
+    // Wraps modulo 2^32, ages are computed from differences of stamps
+    uint32_t milliseconds(Clock::time_point time) const {
+        return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(time - _epoch).count());
+    }
+
+    // A batch inserted by another thread may be stamped slightly after the time of a query
+    static uint32_t age(const Slot& slot, uint32_t now_ms) {
+        const int32_t age_ms = static_cast<int32_t>(now_ms - slot.stamp_ms);
+        return age_ms > 0 ? static_cast<uint32_t>(age_ms) : 0;
+    }
+
+    Eigen::Vector3i voxelIndex(const Eigen::Vector3f& point) const {
+        return (point * _inverse_voxel_size).array().floor().cast<int>().matrix();
+    }
+
+    // 21 bits per axis cover +-2^20 voxels, i.e. +-200 km at 0.2 m
+    static uint64_t packKey(const Eigen::Vector3i& index) {
+        static constexpr uint64_t mask = (uint64_t{1} << kKeyBits) - 1;
+        return (static_cast<uint64_t>(index.x() + kKeyOffset) & mask) |
+               ((static_cast<uint64_t>(index.y() + kKeyOffset) & mask) << kKeyBits) |
+               ((static_cast<uint64_t>(index.z() + kKeyOffset) & mask) << (2 * kKeyBits));
+    }
+
+    uint64_t voxelKey(const Eigen::Vector3f& point) const { return packKey(voxelIndex(point)); }
+
+    size_t home(uint64_t key) const {
+        // Fibonacci hashing, the top bits of the product are well mixed
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> (64 - _capacity_bits));
+    }
+
+    float decayedScore(const Slot& slot, uint32_t now_ms) const {
+        return slot.score * std::exp2(-static_cast<float>(age(slot, now_ms)) * _inverse_half_life_ms);
+    }
+
+    bool isExpired(const Slot& slot, uint32_t now_ms) const { return age(slot, now_ms) > _expiry_age_ms; }
+
+    const Slot* find(uint64_t key) const {
+        const size_t mask = _slots.size() - 1;
+        for (size_t probe = 0, i = home(key); probe < kProbeWindow; ++probe, i = (i + 1) & mask) {
+            const Slot& slot = _slots[i];
+            if (slot.key == key) {
+                return &slot;
+            }
+            // Slots are never emptied again, so an empty slot ends the probe sequence
+            if (slot.key == kEmpty) {
+                return nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+    bool isOccupied(uint64_t key, uint32_t now_ms) const {
+        const Slot* slot = find(key);
+        return slot != nullptr && decayedScore(*slot, now_ms) >= _parameters.occupied_score;
+    }
+
+    Slot& findOrInsert(uint64_t key, uint32_t now_ms) {
+        const size_t mask = _slots.size() - 1;
+        Slot* free_slot = nullptr;
+        Slot* weakest_slot = nullptr;
+        float weakest_score = std::numeric_limits<float>::infinity();
+
+        // The whole window is searched for the key, as it may sit behind a reusable slot
+        for (size_t probe = 0, i = home(key); probe < kProbeWindow; ++probe, i = (i + 1) & mask) {
+            Slot& slot = _slots[i];
+            if (slot.key == key) {
+                return slot;
+            }
+            if (slot.key == kEmpty) {
+                if (free_slot == nullptr) {
+                    free_slot = &slot;
+                }
+                break;
+            }
+            if (free_slot == nullptr) {
+                if (isExpired(slot, now_ms)) {
+                    free_slot = &slot;
+                } else {
+                    const float score = decayedScore(slot, now_ms);
+                    if (score < weakest_score) {
+                        weakest_score = score;
+                        weakest_slot = &slot;
+                    }
+                }
+            }
+        }
+
+        if (free_slot == nullptr) {
+            free_slot = weakest_slot;
+            _evictions++;
+        }
+        *free_slot = Slot{key, 0.f, now_ms - _expiry_age_ms};
+        return *free_slot;
+    }
+
+    const Parameters _parameters;
+    const float _inverse_voxel_size;
+    const Clock::time_point _epoch;
+
+    mutable std::mutex _mutex;
+    std::vector<Slot> _slots;
+    int _capacity_bits{0};
+    uint32_t _expiry_age_ms{0};
+    float _inverse_half_life_ms{0.f};
+    uint64_t _evictions{0};
+};
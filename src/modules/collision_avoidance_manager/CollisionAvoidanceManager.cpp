@@ -39,95 +39,411 @@
  */
 
 #include <CollisionAvoidanceManager.hpp>
+#include <algorithm>
+#include <cmath>
 
 using namespace std::chrono_literals;
 
+static constexpr auto distance_check_interval = 100ms;
+
 CollisionAvoidanceManager::CollisionAvoidanceManager()
     : Node("collision_avoidance_manager"),
-      _config_update_callback([]() { return CollisionAvoidanceManagerConfiguration{}; }) {}
+      _config_channel(std::make_shared<ConfigurationChannel>()) {}
 
 CollisionAvoidanceManager::~CollisionAvoidanceManager() { deinit(); }
 
 void CollisionAvoidanceManager::init() {
     std::cout << collisionAvoidanceManagerOut << " Started!" << std::endl;
 
+    this->declare_parameter("corridor_radius_m");
+    this->declare_parameter("roi_width_fraction");
+    this->declare_parameter("roi_height_fraction");
+    this->declare_parameter("roi_width_center");
+    this->declare_parameter("roi_height_center");
+    // 'min' reduces the ROI to one distance, 'sectors' also reports the minimum per horizontal sector
+    this->declare_parameter("obstacle_distance_mode");
+    this->declare_parameter("obstacle_sectors");
+    this->declare_parameter("obstacle_max_distance_m");
+    // 'frame' checks every new depth frame as soon as it is published, 'timer' checks the latest frame at 10hz
+    this->declare_parameter("collision_check_trigger");
+    // Memory budget of the voxel occupancy map, 0 to disable it
+    this->declare_parameter("occupancy_map_memory_mb");
+    this->declare_parameter("occupancy_map_voxel_size_m");
+    this->declare_parameter("occupancy_map_half_life_s");
+    this->declare_parameter("occupancy_map_corridor_radius_m");
+    {
+        std::lock_guard<std::mutex> lock(_collision_avoidance_manager_mutex);
+        this->get_parameter_or("corridor_radius_m", _roi_settings.corridor_radius_m, 0.f);
+        this->get_parameter_or("roi_width_fraction", _roi_settings.width_fraction, 0.2f);
+        this->get_parameter_or("roi_height_fraction", _roi_settings.height_fraction, 0.2f);
+        this->get_parameter_or("roi_width_center", _roi_settings.width_center, 0.5f);
+        this->get_parameter_or("roi_height_center", _roi_settings.height_center, 0.5f);
+
+        std::string obstacle_distance_mode;
+        this->get_parameter_or("obstacle_distance_mode", obstacle_distance_mode, std::string("min"));
+        if (obstacle_distance_mode == "sectors") {
+            _sector_mode = true;
+        } else if (obstacle_distance_mode != "min") {
+            RCLCPP_ERROR(get_logger(), "Unknown obstacle_distance_mode '%s', using 'min'",
+                         obstacle_distance_mode.c_str());
+        }
+    }
+    // OBSTACLE_DISTANCE carries at most 72 sectors
+    this->get_parameter_or("obstacle_sectors", _sector_count, 72);
+    _sector_count = std::clamp(_sector_count, 1, 72);
+    this->get_parameter_or("obstacle_max_distance_m", _obstacle_sectors.max_distance_m, 20.f);
+    _obstacle_sectors.min_distance_m = 0.2f;
+
+    std::string collision_check_trigger;
+    this->get_parameter_or("collision_check_trigger", collision_check_trigger, std::string("timer"));
+    if (collision_check_trigger == "frame") {
+        _collision_check_trigger = CollisionCheckTrigger::FRAME;
+    } else if (collision_check_trigger != "timer") {
+        RCLCPP_ERROR(get_logger(), "Unknown collision_check_trigger '%s', using 'timer'",
+                     collision_check_trigger.c_str());
+    }
+
+    int occupancy_map_memory_mb = 0;
+    this->get_parameter_or("occupancy_map_memory_mb", occupancy_map_memory_mb, 0);
+    if (occupancy_map_memory_mb > 0) {
+        VoxelOccupancyMap::Parameters occupancy_parameters;
+        occupancy_parameters.memory_budget_bytes = static_cast<size_t>(occupancy_map_memory_mb) << 20U;
+        this->get_parameter_or("occupancy_map_voxel_size_m", occupancy_parameters.voxel_size_m, 0.2f);
+        this->get_parameter_or("occupancy_map_half_life_s", occupancy_parameters.half_life_s, 2.f);
+        this->get_parameter_or("occupancy_map_corridor_radius_m", _occupancy_corridor_radius_m, 0.5f);
+        _occupancy_map = std::make_shared<VoxelOccupancyMap>(occupancy_parameters);
+        std::cout << collisionAvoidanceManagerOut << " Occupancy map with " << _occupancy_map->capacity()
+                  << " voxels of " << occupancy_parameters.voxel_size_m << " m" << std::endl;
+    }
+
     _obstacle_distance_pub =
         this->create_publisher<std_msgs::msg::Float32>("/collision_avoidance_manager/distance_to_obstacle", 10);
+    if (_occupancy_map) {
+        _occupancy_distance_pub = this->create_publisher<std_msgs::msg::Float32>(
+            "/collision_avoidance_manager/distance_along_velocity", 10);
+    }
+    if (_sector_mode) {
+        _obstacle_sectors_pub = this->create_publisher<sensor_msgs::msg::LaserScan>(
+            "/collision_avoidance_manager/obstacle_sectors", 10);
+    }
 
-    // Distance to obstacle calculation runs at 10hz
-    _timer = this->create_wall_timer(100ms, std::bind(&CollisionAvoidanceManager::compute_distance_to_obstacle, this));
+    if (_collision_check_trigger == CollisionCheckTrigger::FRAME && _depth_frame_channel) {
+        // Distance to obstacle calculation runs whenever the Sensor Manager publishes a new frame
+        _collision_check_thread_stop = false;
+        _collision_check_thread = std::thread(&CollisionAvoidanceManager::collisionCheckLoop, this);
+    } else {
+        // Distance to obstacle calculation runs at 10hz
+        _timer =
+            this->create_wall_timer(distance_check_interval,
+                                    std::bind(&CollisionAvoidanceManager::compute_distance_to_obstacle, this));
+    }
 }
 
-auto CollisionAvoidanceManager::deinit() -> void { _obstacle_distance_pub.reset(); }
+auto CollisionAvoidanceManager::deinit() -> void {
+    _collision_check_thread_stop = true;
+    if (_collision_check_thread.joinable()) {
+        _collision_check_thread.join();
+    }
+    _obstacle_distance_pub.reset();
+    _obstacle_sectors_pub.reset();
+    _occupancy_distance_pub.reset();
+}
 
 auto CollisionAvoidanceManager::run() -> void { rclcpp::spin(shared_from_this()); }
 
-bool CollisionAvoidanceManager::is_pixel_valid(const DepthPixelF& pixel, uint32_t col_min, uint32_t col_max,
-                                               uint32_t row_min, uint32_t row_max) const {
-    if (pixel.x < col_min || pixel.x > col_max) {
-        return false;
+void CollisionAvoidanceManager::collisionCheckLoop() {
+    uint64_t last_sequence = _depth_frame_channel->sequence();
+
+    while (!_collision_check_thread_stop) {
+        // The timeout keeps the distance updated, and invalidated, when the camera stalls
+        last_sequence = _depth_frame_channel->wait_for_new(last_sequence, distance_check_interval);
+        if (_collision_check_thread_stop) {
+            break;
+        }
+        compute_distance_to_obstacle();
     }
-    if (pixel.y < row_min || pixel.y > row_max) {
-        return false;
+}
+
+float CollisionAvoidanceManager::min_depth_in_roi(const ExtendedDownsampledImageF& depth_image) {
+    ROISettings roi;
+    {
+        std::lock_guard<std::mutex> lock(_collision_avoidance_manager_mutex);
+        roi = _roi_settings;
+    }
+
+    const DepthPixelArrayF& depth_pixel_array = depth_image.downsampled_image.depth_pixel_array;
+    const RectifiedIntrinsicsF& intrinsics = depth_image.downsampled_image.intrinsics;
+    const uint32_t width = intrinsics.rw;
+    const uint32_t height = intrinsics.rh;
+    float min_depth = std::numeric_limits<float>::infinity();
+
+    // The frame is the full downsampled grid in row-major order, so the ROI is addressed directly
+    if (depth_pixel_array.size() < static_cast<size_t>(width) * height) {
+        return min_depth;
+    }
+
+    const auto to_index = [](float fraction, uint32_t size) {
+        return static_cast<uint32_t>(std::clamp(fraction * size, 0.f, static_cast<float>(size)));
+    };
+    const uint32_t col_min = to_index(roi.width_center - 0.5f * roi.width_fraction, width);
+    const uint32_t col_end = std::min(to_index(roi.width_center + 0.5f * roi.width_fraction, width) + 1, width);
+    const uint32_t row_min = to_index(roi.height_center - 0.5f * roi.height_fraction, height);
+    const uint32_t row_end = std::min(to_index(roi.height_center + 0.5f * roi.height_fraction, height) + 1, height);
+
+    // The corridor check needs the metric offset of each pixel from the optical axis, which the ray table provides
+    const RayTable* ray_table = roi.corridor_radius_m > 0.f ? depth_image.ray_table.get() : nullptr;
+    if (ray_table != nullptr && !ray_table->contains(width - 1, height - 1)) {
+        return min_depth;
+    }
+
+    // Reduce the ROI rows of the shared frame in place, it must not be modified or copied
+    for (uint32_t row = row_min; row < row_end; ++row) {
+        const DepthPixelF* row_pixels = depth_pixel_array.data() + static_cast<size_t>(row) * width;
+        if (ray_table == nullptr) {
+            // Branchless, so the compiler can vectorize the reduction
+            for (uint32_t col = col_min; col < col_end; ++col) {
+                min_depth = std::min(min_depth, row_pixels[col].depth);
+            }
+        } else {
+            for (uint32_t col = col_min; col < col_end; ++col) {
+                const float depth = row_pixels[col].depth;
+                if (depth < min_depth && ray_table->ray(col, row).lateral_scale * depth <= roi.corridor_radius_m) {
+                    min_depth = depth;
+                }
+            }
+        }
     }
 
-    return true;
+    return min_depth;
 }
 
-void CollisionAvoidanceManager::filter_pixels_to_roi(DepthPixelArrayF& depth_pixel_array,
-                                                     const RectifiedIntrinsicsF& intrinsics) {
+void CollisionAvoidanceManager::update_sector_table(const RayTable& ray_table) {
+    // The horizontal ray component only depends on the column
+    const uint32_t width = ray_table.width();
+    const float azimuth_first = std::atan(ray_table.ray(0, 0).direction.x());
+    const float azimuth_last = std::atan(ray_table.ray(width - 1, 0).direction.x());
+    const float increment = (azimuth_last - azimuth_first) / _sector_count;
+
+    _column_range_scale.resize(width);
+    _column_distance_min.resize(width);
+    _sector_first_column.assign(_sector_count + 1, width);
+    int sector = 0;
+    for (uint32_t col = 0; col < width; ++col) {
+        const float direction_x = ray_table.ray(col, 0).direction.x();
+        _column_range_scale[col] = std::sqrt(1.f + direction_x * direction_x);
+
+        // Columns are sorted by azimuth, so every sector is a contiguous range of columns
+        const int col_sector = std::min(
+            _sector_count - 1, static_cast<int>((std::atan(direction_x) - azimuth_first) / increment));
+        while (sector <= col_sector) {
+            _sector_first_column[sector++] = col;
+        }
+    }
+
+    _obstacle_sectors.increment_deg = increment * 180.f / M_PI;
+    _obstacle_sectors.angle_offset_deg = (azimuth_first + 0.5f * increment) * 180.f / M_PI;
+    _obstacle_sectors.distances_m.resize(_sector_count);
+}
+
+float CollisionAvoidanceManager::min_distance_in_sectors(const ExtendedDownsampledImageF& depth_image) {
+    const DepthPixelArrayF& depth_pixel_array = depth_image.downsampled_image.depth_pixel_array;
+    const RectifiedIntrinsicsF& intrinsics = depth_image.downsampled_image.intrinsics;
+    const uint32_t width = intrinsics.rw;
+    const uint32_t height = intrinsics.rh;
+    float min_distance = std::numeric_limits<float>::infinity();
+
+    if (depth_image.ray_table == nullptr || width < 2 || !depth_image.ray_table->contains(width - 1, height - 1) ||
+        depth_pixel_array.size() < static_cast<size_t>(width) * height) {
+        return min_distance;
+    }
+    if (depth_image.ray_table != _sector_ray_table) {
+        update_sector_table(*depth_image.ray_table);
+        _sector_ray_table = depth_image.ray_table;
+    }
+
     ROISettings roi;
     {
         std::lock_guard<std::mutex> lock(_collision_avoidance_manager_mutex);
         roi = _roi_settings;
     }
+    const auto to_index = [](float fraction, uint32_t size) {
+        return static_cast<uint32_t>(std::clamp(fraction * size, 0.f, static_cast<float>(size)));
+    };
+    const uint32_t row_min = to_index(roi.height_center - 0.5f * roi.height_fraction, height);
+    const uint32_t row_end = std::min(to_index(roi.height_center + 0.5f * roi.height_fraction, height) + 1, height);
 
-    const uint32_t col_min = static_cast<uint32_t>((roi.width_center - 0.5f * roi.width_fraction) * intrinsics.rw);
-    const uint32_t col_max = static_cast<uint32_t>((roi.width_center + 0.5f * roi.width_fraction) * intrinsics.rw);
-    const uint32_t row_min = static_cast<uint32_t>((roi.height_center - 0.5f * roi.height_fraction) * intrinsics.rh);
-    const uint32_t row_max = static_cast<uint32_t>((roi.height_center + 0.5f * roi.height_fraction) * intrinsics.rh);
+    // Column minima over the band, one branchless pass over the rows
+    std::fill(_column_distance_min.begin(), _column_distance_min.end(), std::numeric_limits<float>::infinity());
+    for (uint32_t row = row_min; row < row_end; ++row) {
+        const DepthPixelF* row_pixels = depth_pixel_array.data() + static_cast<size_t>(row) * width;
+        for (uint32_t col = 0; col < width; ++col) {
+            _column_distance_min[col] = std::min(_column_distance_min[col], row_pixels[col].depth);
+        }
+    }
 
-    for (auto pixel = depth_pixel_array.begin(); pixel != depth_pixel_array.end();) {
-        if (!is_pixel_valid(*pixel, col_min, col_max, row_min, row_max)) {
-            pixel = depth_pixel_array.erase(pixel);
-        } else {
-            ++pixel;
+    // Scaling is monotonic, so it is applied to the column minima only
+    for (int sector = 0; sector < _sector_count; ++sector) {
+        float sector_min = std::numeric_limits<float>::infinity();
+        for (uint32_t col = _sector_first_column[sector]; col < _sector_first_column[sector + 1]; ++col) {
+            sector_min = std::min(sector_min, _column_distance_min[col] * _column_range_scale[col]);
         }
+        _obstacle_sectors.distances_m[sector] = sector_min;
+        min_distance = std::min(min_distance, sector_min);
+    }
+    _obstacle_sectors.timestamp_ns = depth_image.timestamp_ns;
+
+    return min_distance;
+}
+
+void CollisionAvoidanceManager::update_occupancy_map(const ExtendedDownsampledImageF& depth_image) {
+    const RayTable* ray_table = depth_image.ray_table.get();
+    if (ray_table == nullptr) {
+        return;
+    }
+
+    // Same range as the obstacle distance, so the map only remembers what the collision check has seen
+    const Eigen::Matrix3f rotation = depth_image.orientation.toRotationMatrix();
+    _occupancy_points.clear();
+    for (const DepthPixelF& pixel : depth_image.downsampled_image.depth_pixel_array) {
+        const uint32_t x = static_cast<uint32_t>(pixel.x);
+        const uint32_t y = static_cast<uint32_t>(pixel.y);
+        if (pixel.depth >= _obstacle_sectors.min_distance_m && pixel.depth <= _obstacle_sectors.max_distance_m &&
+            ray_table->contains(x, y)) {
+            _occupancy_points.push_back(rotation * ray_table->point(x, y, pixel.depth) + depth_image.position);
+        }
+    }
+
+    _occupancy_map->insert(_occupancy_points, depth_image.received_time);
+}
+
+float CollisionAvoidanceManager::distance_along_velocity(const ExtendedDownsampledImageF& depth_image) {
+    static constexpr float min_speed_m_s = 0.5f;
+    static constexpr auto max_velocity_age = std::chrono::milliseconds(500);
+
+    std::shared_ptr<const VehicleStateLock> vehicle_state;
+    {
+        std::lock_guard<std::mutex> lock(_vehicle_state_mutex);
+        vehicle_state = _vehicle_state;
+    }
+    if (vehicle_state == nullptr) {
+        return std::numeric_limits<float>::infinity();
+    }
+
+    // A stale velocity would point the corridor in the wrong direction
+    const VehicleState vehicle = vehicle_state->load();
+    if (VehicleState::Clock::now() - vehicle.local_position_time > max_velocity_age) {
+        return std::numeric_limits<float>::infinity();
+    }
+    Eigen::Vector3f velocity = vehicle.velocity_ned();
+
+    // Only horizontal motion is checked, the map also holds the ground below the vehicle
+    velocity.z() = 0.f;
+    const float speed = velocity.norm();
+    if (!(speed >= min_speed_m_s)) {
+        return std::numeric_limits<float>::infinity();
+    }
+
+    return _occupancy_map->nearestOccupiedAlongRay(depth_image.position, velocity / speed,
+                                                   _obstacle_sectors.max_distance_m, _occupancy_corridor_radius_m,
+                                                   VoxelOccupancyMap::Clock::now());
+}
+
+void CollisionAvoidanceManager::publish_obstacle_sectors() {
+    if (_obstacle_sectors.distances_m.empty()) {
+        return;
+    }
+
+    if (_obstacle_sectors_callback) {
+        _obstacle_sectors_callback(_obstacle_sectors);
+    }
+
+    // Angles are the sector azimuths relative to the optical axis, increasing towards the right of the image
+    auto scan = sensor_msgs::msg::LaserScan();
+    scan.header.frame_id = CAMERA_LINK_FRAME;
+    scan.header.stamp = now();
+    scan.angle_increment = _obstacle_sectors.increment_deg * M_PI / 180.f;
+    scan.angle_min = _obstacle_sectors.angle_offset_deg * M_PI / 180.f;
+    scan.angle_max = scan.angle_min + scan.angle_increment * (_obstacle_sectors.distances_m.size() - 1);
+    scan.range_min = _obstacle_sectors.min_distance_m;
+    scan.range_max = _obstacle_sectors.max_distance_m;
+    scan.ranges = _obstacle_sectors.distances_m;
+    _obstacle_sectors_pub->publish(scan);
+}
+
+void CollisionAvoidanceManager::notify_obstacle_distance(float distance_m,
+                                                         const ExtendedDownsampledImageF& depth_image) {
+    std::lock_guard<std::mutex> lock(_obstacle_distance_callback_mutex);
+    if (_obstacle_distance_callback) {
+        const Eigen::Vector3f direction_ned = depth_image.orientation * Eigen::Vector3f::UnitZ();
+        _obstacle_distance_callback(distance_m, direction_ned, depth_image.received_time);
     }
 }
 
 void CollisionAvoidanceManager::compute_distance_to_obstacle() {
-    // update parameters
-    // TODO: make this call dependent on a dbus param update on the Autopilot Manager
-    // instead of running at every loop update
-    _collision_avoidance_manager_config = _config_update_callback();
+    // Update parameters, only copied when the Autopilot Manager published a new configuration
+    if (const auto config = _config_channel->poll(_config_generation)) {
+        _collision_avoidance_manager_config = *config;
+    }
+
+    // Every frame is wanted in both trigger modes. Limited to the timer rate, frames would be delivered out of phase
+    // with the timer ticks, and the latest one could be almost a whole interval old when it is checked.
+    if (_depth_frame_consumer) {
+        _depth_frame_consumer->setDemand(_collision_avoidance_manager_config.autopilot_manager_enabled &&
+                                             _collision_avoidance_manager_config.simple_collision_avoid_enabled,
+                                         0.0);
+    }
 
     // Only process the data when the Autopilot Manager is enabled and the Simple Collsion Avoidance
     // is set as the Decision Maker Input.
     if (_collision_avoidance_manager_config.autopilot_manager_enabled &&
         _collision_avoidance_manager_config.simple_collision_avoid_enabled) {
-        auto depth_msg = _downsampled_depth_update_callback();
+        DepthFrameChannel::Frame depth_frame =
+            _depth_frame_channel ? _depth_frame_channel->latest() : DepthFrameChannel::Frame{};
+
+        // A frame received before the check was last enabled shows obstacles where the vehicle was back then
+        if (depth_frame.data != nullptr && _depth_frame_consumer &&
+            !_depth_frame_consumer->wants(depth_frame.data->received_time)) {
+            depth_frame = DepthFrameChannel::Frame{};
+        }
+        const std::shared_ptr<const ExtendedDownsampledImageF>& depth_msg = depth_frame.data;
 
         if (depth_msg != nullptr && depth_msg->downsampled_image.depth_pixel_array.size() > 0) {
-            // Get min depth in ROI
-            DepthPixelArrayF depth_pixel_array = depth_msg->downsampled_image.depth_pixel_array;
-            filter_pixels_to_roi(depth_pixel_array, depth_msg->downsampled_image.intrinsics);
-            auto depth_pixel_compare = [](const DepthPixelF& lhs, const DepthPixelF& rhs) {
-                return lhs.depth < rhs.depth;
-            };
-            const auto min_depth_pixel =
-                std::min_element(depth_pixel_array.begin(), depth_pixel_array.end(), depth_pixel_compare);
+            // Get min depth in ROI, or the closest sector
+            float min_depth = _sector_mode ? min_distance_in_sectors(*depth_msg) : min_depth_in_roi(*depth_msg);
+
+            // Obstacles in the direction of motion count even when they are not in the current frame
+            if (_occupancy_map) {
+                if (depth_frame.sequence != _last_checked_sequence) {
+                    update_occupancy_map(*depth_msg);
+                }
+                const float occupancy_distance = distance_along_velocity(*depth_msg);
+                min_depth = std::min(min_depth, occupancy_distance);
+
+                auto occupancy_dist = std_msgs::msg::Float32();
+                occupancy_dist.data = occupancy_distance;
+                _occupancy_distance_pub->publish(occupancy_dist);
+            }
 
             // Make the obstacle distance available for the Mission Manager to access
             {
                 std::lock_guard<std::mutex> lock(_collision_avoidance_manager_mutex);
-                _depth = min_depth_pixel->depth;
+                _depth = min_depth;
             }
 
             // Publish obstacle distance back to ROS
             auto obstacle_dist = std_msgs::msg::Float32();
-            obstacle_dist.data = min_depth_pixel->depth;
+            obstacle_dist.data = min_depth;
             _obstacle_distance_pub->publish(obstacle_dist);
+
+            if (_sector_mode) {
+                publish_obstacle_sectors();
+            }
+
+            // Every frame is reported once, so the Mission Manager can react without polling
+            if (depth_frame.sequence != _last_checked_sequence) {
+                _last_checked_sequence = depth_frame.sequence;
+                notify_obstacle_distance(min_depth, *depth_msg);
+            }
         } else {
             {
                 std::lock_guard<std::mutex> lock(_collision_avoidance_manager_mutex);
@@ -42,15 +42,25 @@
 
 #include <common.h>
 
+#include <ConfigChannel.hpp>
 #include <Eigen/Core>
+#include <Eigen/Geometry>
 #include <ModuleBase.hpp>
+#include <VehicleState.hpp>
+#include <VoxelOccupancyMap.hpp>
+#include <atomic>
 #include <chrono>
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 // ROS dependencies
 #include <rclcpp/qos.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <sensor_msgs/msg/image.hpp>
+#include <sensor_msgs/msg/laser_scan.hpp>
 #include <std_msgs/msg/float32.hpp>
 
 static constexpr auto collisionAvoidanceManagerOut = "[Collision Avoidance Manager]";
@@ -66,11 +76,26 @@ class CollisionAvoidanceManager : public rclcpp::Node, ModuleBase {
     auto deinit() -> void override;
     auto run() -> void override;
 
+    // Fractions of the image. In sector mode only the vertical band is used and the sectors span the full width.
     struct ROISettings {
         float width_fraction{0.2f};
         float height_fraction{0.2f};
         float width_center{0.5f};
         float height_center{0.5f};
+        // Only pixels within this distance from the optical axis count as obstacles, 0 to disable
+        float corridor_radius_m{0.f};
+    };
+
+    /**
+     * @brief Minimum horizontal distance per sector across the camera field of view, as needed for OBSTACLE_DISTANCE
+     */
+    struct ObstacleSectors {
+        int64_t timestamp_ns{0};
+        float angle_offset_deg{0.f};  // centre of the first sector, positive to the right of the optical axis
+        float increment_deg{0.f};
+        float min_distance_m{0.f};
+        float max_distance_m{0.f};
+        std::vector<float> distances_m;  // infinity if the sector has no valid depth
     };
 
     struct CollisionAvoidanceManagerConfiguration {
@@ -78,40 +103,122 @@ class CollisionAvoidanceManager : public rclcpp::Node, ModuleBase {
         uint8_t simple_collision_avoid_enabled = 0U;
     };
 
+    using ConfigurationChannel = ConfigChannel<CollisionAvoidanceManagerConfiguration>;
+
     void RCPPUTILS_TSA_GUARDED_BY(_collision_avoidance_manager_mutex) set_roi(const ROISettings& settings) {
         std::lock_guard<std::mutex> lock(_collision_avoidance_manager_mutex);
         _roi_settings = settings;
     }
 
+    DepthRegionOfInterest RCPPUTILS_TSA_GUARDED_BY(_collision_avoidance_manager_mutex) get_region_of_interest() {
+        std::lock_guard<std::mutex> lock(_collision_avoidance_manager_mutex);
+        DepthRegionOfInterest region;
+        if (!_sector_mode) {
+            region.col_begin = _roi_settings.width_center - 0.5f * _roi_settings.width_fraction;
+            region.col_end = _roi_settings.width_center + 0.5f * _roi_settings.width_fraction;
+        }
+        region.row_begin = _roi_settings.height_center - 0.5f * _roi_settings.height_fraction;
+        region.row_end = _roi_settings.height_center + 0.5f * _roi_settings.height_fraction;
+        return region;
+    }
+
     float RCPPUTILS_TSA_GUARDED_BY(_collision_avoidance_manager_mutex) get_latest_distance() {
         std::lock_guard<std::mutex> lock(_collision_avoidance_manager_mutex);
         return _depth;
     }
 
-    void getDownsampledDepthDataCallback(std::function<std::shared_ptr<ExtendedDownsampledImageF>()> callback) {
-        _downsampled_depth_update_callback = callback;
+    void setDepthFrameChannel(std::shared_ptr<const DepthFrameChannel> channel) {
+        _depth_frame_channel = std::move(channel);
     }
 
-    void setConfigUpdateCallback(std::function<CollisionAvoidanceManagerConfiguration()> callback) {
-        _config_update_callback = callback;
+    /**
+     * @brief Demand for depth frames, kept active only while simple collision avoidance is enabled
+     */
+    void setDepthFrameConsumer(std::shared_ptr<FrameDemand::Consumer> consumer) {
+        _depth_frame_consumer = std::move(consumer);
+    }
+
+    void setConfigChannel(std::shared_ptr<const ConfigurationChannel> channel) { _config_channel = std::move(channel); }
+
+    void setObstacleSectorsCallback(std::function<void(const ObstacleSectors&)> callback) {
+        _obstacle_sectors_callback = callback;
+    }
+
+    /**
+     * @brief Called for every new depth frame with the distance to the closest obstacle, the camera optical axis in
+     * NED and the time the frame was received. Can be set while the module is running.
+     */
+    using ObstacleDistanceCallback = std::function<void(float distance_m, const Eigen::Vector3f& direction_ned,
+                                                        std::chrono::steady_clock::time_point frame_received)>;
+
+    void setObstacleDistanceCallback(ObstacleDistanceCallback callback) {
+        std::lock_guard<std::mutex> lock(_obstacle_distance_callback_mutex);
+        _obstacle_distance_callback = std::move(callback);
+    }
+
+    /**
+     * @brief Vehicle state shared by the Mission Manager, its velocity is used to look for remembered obstacles along
+     * the direction of motion
+     */
+    void setVehicleState(std::shared_ptr<const VehicleStateLock> vehicle_state) {
+        std::lock_guard<std::mutex> lock(_vehicle_state_mutex);
+        _vehicle_state = std::move(vehicle_state);
     }
 
    private:
-    void compute_distance_to_obstacle();
-    bool is_pixel_valid(const DepthPixelF& pixel, uint32_t col_min, uint32_t col_max, uint32_t row_min,
-                        uint32_t row_max) const;
-    void filter_pixels_to_roi(DepthPixelArrayF& pixel, const RectifiedIntrinsicsF& intrinsics);
+    enum class CollisionCheckTrigger { TIMER, FRAME };
 
-    std::function<std::shared_ptr<ExtendedDownsampledImageF>()> _downsampled_depth_update_callback;
-    std::function<CollisionAvoidanceManagerConfiguration()> _config_update_callback;
+    void collisionCheckLoop();
+    void compute_distance_to_obstacle();
+    void notify_obstacle_distance(float distance_m, const ExtendedDownsampledImageF& depth_image);
+    float min_depth_in_roi(const ExtendedDownsampledImageF& depth_image);
+    float min_distance_in_sectors(const ExtendedDownsampledImageF& depth_image);
+    void update_sector_table(const RayTable& ray_table);
+    void update_occupancy_map(const ExtendedDownsampledImageF& depth_image);
+    float distance_along_velocity(const ExtendedDownsampledImageF& depth_image);
+    void publish_obstacle_sectors();
+
+    std::shared_ptr<const DepthFrameChannel> _depth_frame_channel;
+    std::shared_ptr<FrameDemand::Consumer> _depth_frame_consumer;
+    std::shared_ptr<const ConfigurationChannel> _config_channel;
+    uint64_t _config_generation{0};
+    std::function<void(const ObstacleSectors&)> _obstacle_sectors_callback;
 
     CollisionAvoidanceManagerConfiguration _collision_avoidance_manager_config;
 
+    std::mutex _obstacle_distance_callback_mutex;
+    ObstacleDistanceCallback _obstacle_distance_callback;
+
+    std::mutex _vehicle_state_mutex;
+    std::shared_ptr<const VehicleStateLock> _vehicle_state;
+
+    // Obstacles that left the field of view are still found along the horizontal direction of motion
+    std::shared_ptr<VoxelOccupancyMap> _occupancy_map;
+    float _occupancy_corridor_radius_m{0.5f};
+    std::vector<Eigen::Vector3f> _occupancy_points;
+
     rclcpp::TimerBase::SharedPtr _timer{};
+
+    // In frame mode the distance is computed as soon as the Sensor Manager publishes a frame
+    CollisionCheckTrigger _collision_check_trigger{CollisionCheckTrigger::TIMER};
+    std::thread _collision_check_thread;
+    std::atomic<bool> _collision_check_thread_stop{false};
+    uint64_t _last_checked_sequence{0};
     rclcpp::Publisher<std_msgs::msg::Float32>::SharedPtr _obstacle_distance_pub{};
+    rclcpp::Publisher<sensor_msgs::msg::LaserScan>::SharedPtr _obstacle_sectors_pub{};
+    rclcpp::Publisher<std_msgs::msg::Float32>::SharedPtr _occupancy_distance_pub{};
 
     mutable std::mutex _collision_avoidance_manager_mutex;
 
     ROISettings _roi_settings{};
     float _depth{NAN};
+
+    // Sector mode: the columns of the downsampled grid are binned by azimuth into sectors of equal angle
+    bool _sector_mode{false};
+    int _sector_count{72};
+    ObstacleSectors _obstacle_sectors;
+    std::shared_ptr<const RayTable> _sector_ray_table;
+    std::vector<uint32_t> _sector_first_column;  // sector i covers columns [first[i], first[i + 1])
+    std::vector<float> _column_range_scale;      // depth to horizontal distance
+    std::vector<float> _column_distance_min;
 };
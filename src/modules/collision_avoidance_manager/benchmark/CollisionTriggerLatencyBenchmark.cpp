@@ -0,0 +1,257 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Benchmark of the frame-to-action latency of simple collision avoidance with the timer and frame triggers
+ * @file CollisionTriggerLatencyBenchmark.cpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#include <FrameChannel.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using namespace std::chrono_literals;
+
+// Same intervals as the Collision Avoidance Manager and the Mission Manager decision maker
+constexpr auto distance_check_interval = 100ms;
+constexpr auto decision_maker_run_interval = 50ms;
+
+constexpr float frame_rate_hz = 30.f;
+constexpr int events = 60;
+constexpr float distance_threshold_m = 5.f;
+
+// Downsampled 848x480 frame with 4x4 blocks and the default 20% ROI
+constexpr int frame_width = 212;
+constexpr int frame_height = 120;
+constexpr int roi_col_begin = 85;
+constexpr int roi_col_end = 128;
+constexpr int roi_row_begin = 48;
+constexpr int roi_row_end = 73;
+
+struct DepthFrame {
+    std::shared_ptr<const std::vector<float>> depths;
+    Clock::time_point received_time;
+};
+
+using Channel = FrameChannel<DepthFrame>;
+
+enum class Mode {
+    TIMER_POLLED,  // before frame triggering: 10 Hz distance check, decision maker polls the distance every 50 ms
+    TIMER,         // 10 Hz distance check, threshold crossings wake the decision maker
+    FRAME          // distance checked on every new frame, threshold crossings wake the decision maker
+};
+
+const char* modeName(Mode mode) {
+    switch (mode) {
+        case Mode::TIMER_POLLED:
+            return "timer, polled";
+        case Mode::TIMER:
+            return "timer";
+        default:
+            return "frame";
+    }
+}
+
+float minDepthInRoi(const std::vector<float>& depths) {
+    float min_depth = std::numeric_limits<float>::infinity();
+    for (int row = roi_row_begin; row < roi_row_end; ++row) {
+        const float* row_depths = depths.data() + row * frame_width;
+        min_depth = std::min(min_depth, *std::min_element(row_depths + roi_col_begin, row_depths + roi_col_end));
+    }
+    return min_depth;
+}
+
+class Scenario {
+   public:
+    explicit Scenario(Mode mode) : _mode(mode) {}
+
+    // Latencies in ms from the first frame showing the obstacle to the decision maker acting on it
+    std::vector<double> run() {
+        std::thread checker(&Scenario::checkerLoop, this);
+        std::thread decision_maker(&Scenario::decisionMakerLoop, this);
+        producerLoop();
+
+        _stop = true;
+        _wakeup.notify_one();
+        checker.join();
+        decision_maker.join();
+        return _latencies_ms;
+    }
+
+   private:
+    // Camera at a fixed rate, starting at a random phase. Each event is a few clear frames, then an obstacle inside
+    // the threshold until the decision maker acted on it.
+    void producerLoop() {
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<int> clear_frames(3, 8);
+        std::uniform_int_distribution<int> phase_us(0, static_cast<int>(1e6f / frame_rate_hz));
+        const auto frame_period =
+            std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(1.f / frame_rate_hz));
+
+        const auto clear = std::make_shared<const std::vector<float>>(frame_width * frame_height, 20.f);
+        auto blocked_depths = std::vector<float>(frame_width * frame_height, 20.f);
+        blocked_depths[60 * frame_width + 106] = distance_threshold_m - 1.f;
+        const auto blocked = std::make_shared<const std::vector<float>>(std::move(blocked_depths));
+
+        Clock::time_point next_frame = Clock::now() + std::chrono::microseconds(phase_us(generator));
+        const auto publish = [&](const std::shared_ptr<const std::vector<float>>& depths, bool obstacle_start) {
+            std::this_thread::sleep_until(next_frame);
+            next_frame += frame_period;
+            const Clock::time_point received_time = Clock::now();
+            if (obstacle_start) {
+                _obstacle_start_ns = received_time.time_since_epoch().count();
+            }
+            _channel.publish(std::make_shared<const DepthFrame>(DepthFrame{depths, received_time}));
+        };
+
+        for (int event = 0; event < events; ++event) {
+            for (int i = clear_frames(generator); i > 0; --i) {
+                publish(clear, false);
+            }
+
+            publish(blocked, true);
+            while (!_acted) {
+                publish(blocked, false);
+            }
+            _acted = false;
+            _obstacle_start_ns = 0;
+        }
+    }
+
+    void checkerLoop() {
+        uint64_t last_sequence = 0;
+        Clock::time_point next_check = Clock::now();
+        while (!_stop) {
+            if (_mode == Mode::FRAME) {
+                last_sequence = _channel.wait_for_new(last_sequence, distance_check_interval);
+            } else {
+                next_check += distance_check_interval;
+                std::this_thread::sleep_until(next_check);
+            }
+
+            const Channel::Frame frame = _channel.latest();
+            if (frame.data == nullptr) {
+                continue;
+            }
+            const float distance_m = minDepthInRoi(*frame.data->depths);
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _distance_m = distance_m;
+                _distance_received_time = frame.data->received_time;
+            }
+            if (_mode != Mode::TIMER_POLLED && distance_m <= distance_threshold_m) {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _event_received_time = frame.data->received_time;
+                }
+                _wakeup.notify_one();
+            }
+        }
+    }
+
+    void decisionMakerLoop() {
+        int64_t last_acted_ns = 0;
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (!_stop) {
+            _wakeup.wait_for(lock, decision_maker_run_interval,
+                             [this]() { return _stop || _event_received_time.has_value(); });
+            const Clock::time_point now = Clock::now();
+
+            // Crossings are pushed, the polled distance covers the frames the checker saw without pushing
+            std::optional<Clock::time_point> seen;
+            seen.swap(_event_received_time);
+            if (!seen && _distance_m <= distance_threshold_m) {
+                seen = _distance_received_time;
+            }
+
+            const int64_t obstacle_start_ns = _obstacle_start_ns;
+            if (seen && obstacle_start_ns != 0 && obstacle_start_ns != last_acted_ns &&
+                seen->time_since_epoch().count() >= obstacle_start_ns) {
+                last_acted_ns = obstacle_start_ns;
+                _latencies_ms.push_back((now.time_since_epoch().count() - obstacle_start_ns) * 1e-6);
+                _acted = true;
+            }
+        }
+    }
+
+    Mode _mode;
+    Channel _channel;
+    std::atomic<bool> _stop{false};
+    std::atomic<bool> _acted{false};
+    std::atomic<int64_t> _obstacle_start_ns{0};
+
+    std::mutex _mutex;
+    std::condition_variable _wakeup;
+    float _distance_m{std::numeric_limits<float>::infinity()};
+    Clock::time_point _distance_received_time;
+    std::optional<Clock::time_point> _event_received_time;
+    std::vector<double> _latencies_ms;
+};
+
+double percentile(const std::vector<double>& sorted, double fraction) {
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()))];
+}
+
+}  // namespace
+
+int main() {
+    std::printf("%d obstacle events per trigger, %.0f Hz camera, %d ms check timer, %d ms decision maker fallback\n\n",
+                events, frame_rate_hz, static_cast<int>(distance_check_interval.count()),
+                static_cast<int>(decision_maker_run_interval.count()));
+    std::printf("%14s %10s %10s %10s %10s\n", "trigger", "mean [ms]", "p50 [ms]", "p95 [ms]", "max [ms]");
+
+    for (const Mode mode : {Mode::TIMER_POLLED, Mode::TIMER, Mode::FRAME}) {
+        std::vector<double> latencies_ms = Scenario(mode).run();
+        std::sort(latencies_ms.begin(), latencies_ms.end());
+        double sum = 0.0;
+        for (const double latency_ms : latencies_ms) {
+            sum += latency_ms;
+        }
+        std::printf("%14s %10.2f %10.2f %10.2f %10.2f\n", modeName(mode), sum / latencies_ms.size(),
+                    percentile(latencies_ms, 0.5), percentile(latencies_ms, 0.95), latencies_ms.back());
+    }
+
+    return 0;
+}
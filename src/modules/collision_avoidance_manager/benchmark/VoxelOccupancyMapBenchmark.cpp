@@ -0,0 +1,136 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Benchmark of the voxel occupancy map insertion and ray query throughput
+ * @file VoxelOccupancyMapBenchmark.cpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#include <VoxelOccupancyMap.hpp>
+#include <cstdio>
+#include <random>
+
+namespace {
+
+constexpr int frame_rate_hz = 10;
+constexpr int points_per_frame = 10000;  // 100k points/s
+constexpr int frames = 600;
+constexpr int queries_per_frame = 100;
+constexpr float speed_m_s = 5.f;
+
+// Points on the floor and the two walls of a 10 m wide corridor, up to 20 m ahead of the vehicle
+void generateFrame(std::mt19937& generator, float vehicle_x, std::vector<Eigen::Vector3f>& points) {
+    std::uniform_real_distribution<float> ahead(0.f, 20.f);
+    std::uniform_real_distribution<float> across(-5.f, 5.f);
+    std::uniform_real_distribution<float> height(-5.f, 0.f);
+    std::uniform_int_distribution<int> surface(0, 2);
+    std::normal_distribution<float> noise(0.f, 0.03f);
+
+    points.clear();
+    for (int i = 0; i < points_per_frame; ++i) {
+        const float x = vehicle_x + ahead(generator);
+        switch (surface(generator)) {
+            case 0:
+                points.emplace_back(x, across(generator), noise(generator));
+                break;
+            case 1:
+                points.emplace_back(x, -5.f + noise(generator), height(generator));
+                break;
+            default:
+                points.emplace_back(x, 5.f + noise(generator), height(generator));
+                break;
+        }
+    }
+}
+
+}  // namespace
+
+int main() {
+    using Clock = std::chrono::steady_clock;
+
+    std::printf("%d points/frame at %d Hz, %d frames\n\n", points_per_frame, frame_rate_hz, frames);
+    std::printf("%10s %8s %12s %14s %12s %12s %10s\n", "budget", "slots", "insert [ms]", "insert [Mpt/s]",
+                "ray [us]", "corr. [us]", "evictions");
+
+    for (const size_t budget_mb : {1U, 4U, 16U}) {
+        VoxelOccupancyMap::Parameters parameters;
+        parameters.memory_budget_bytes = budget_mb << 20U;
+        VoxelOccupancyMap map(parameters);
+
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<float> heading(-0.5f, 0.5f);
+        std::vector<Eigen::Vector3f> points;
+        points.reserve(points_per_frame);
+
+        const Clock::time_point start = Clock::now();
+        double insert_s = 0.0;
+        double ray_s = 0.0;
+        double corridor_s = 0.0;
+        int hits = 0;
+        for (int frame = 0; frame < frames; ++frame) {
+            const float vehicle_x = speed_m_s * frame / frame_rate_hz;
+            const Clock::time_point time = start + std::chrono::milliseconds(1000 * frame / frame_rate_hz);
+            generateFrame(generator, vehicle_x, points);
+
+            const Clock::time_point insert_start = Clock::now();
+            map.insert(points, time);
+            insert_s += std::chrono::duration<double>(Clock::now() - insert_start).count();
+
+            const Eigen::Vector3f origin(vehicle_x, 0.f, -2.f);
+            for (int i = 0; i < queries_per_frame; ++i) {
+                const float angle = heading(generator);
+                const Eigen::Vector3f direction(std::cos(angle), std::sin(angle), 0.f);
+
+                const Clock::time_point ray_start = Clock::now();
+                hits += std::isfinite(map.nearestOccupiedAlongRay(origin, direction, 20.f, 0.f, time));
+                const Clock::time_point corridor_start = Clock::now();
+                hits += std::isfinite(map.nearestOccupiedAlongRay(origin, direction, 20.f, 0.5f, time));
+                const Clock::time_point corridor_end = Clock::now();
+
+                ray_s += std::chrono::duration<double>(corridor_start - ray_start).count();
+                corridor_s += std::chrono::duration<double>(corridor_end - corridor_start).count();
+            }
+        }
+
+        std::printf("%8zuMB %8zu %12.3f %14.2f %12.2f %12.2f %10lu\n", budget_mb, map.capacity(),
+                    insert_s * 1e3 / frames, static_cast<double>(points_per_frame) * frames / insert_s * 1e-6,
+                    ray_s * 1e6 / (frames * queries_per_frame), corridor_s * 1e6 / (frames * queries_per_frame),
+                    static_cast<unsigned long>(map.evictions()));
+        if (hits == 0) {
+            std::printf("no obstacle found\n");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,222 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Tests of the hashed voxel occupancy map
+ * @file VoxelOccupancyMapTest.cpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#include <gtest/gtest.h>
+
+#include <VoxelOccupancyMap.hpp>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+using Clock = VoxelOccupancyMap::Clock;
+
+constexpr float kVoxelSize = 0.2f;
+constexpr float kHalfLife = 2.f;
+
+VoxelOccupancyMap::Parameters testParameters() {
+    VoxelOccupancyMap::Parameters parameters;
+    parameters.voxel_size_m = kVoxelSize;
+    parameters.memory_budget_bytes = 1U << 20U;
+    parameters.half_life_s = kHalfLife;
+    return parameters;
+}
+
+// Reference for nearestOccupiedAlongRay(): every occupied voxel centre within reach of the ray
+float bruteForceNearest(const std::vector<Eigen::Vector3f>& centres, const Eigen::Vector3f& origin,
+                        const Eigen::Vector3f& direction, float max_distance_m, float radius_m) {
+    const float reach = radius_m + 0.5f * std::sqrt(3.f) * kVoxelSize;
+    float nearest = std::numeric_limits<float>::infinity();
+    for (const Eigen::Vector3f& centre : centres) {
+        const Eigen::Vector3f offset = centre - origin;
+        const float along = offset.dot(direction);
+        if (along >= 0.f && along <= max_distance_m && (offset - direction * along).norm() <= reach) {
+            nearest = std::min(nearest, along);
+        }
+    }
+    return nearest;
+}
+
+}  // namespace
+
+TEST(VoxelOccupancyMapTest, OccupiedAfterTwoBatches) {
+    VoxelOccupancyMap map(testParameters());
+    const Clock::time_point start = Clock::now();
+    const std::vector<Eigen::Vector3f> points{{1.1f, 2.1f, -0.9f}};
+
+    map.insert(points, start);
+    EXPECT_FALSE(map.isOccupied(points[0], start));
+
+    // Hits within the same batch, i.e. with the same stamp, only count once
+    map.insert(points, start);
+    EXPECT_FALSE(map.isOccupied(points[0], start));
+
+    map.insert(points, start + 100ms);
+    EXPECT_TRUE(map.isOccupied(points[0], start + 100ms));
+    // Any point of the same voxel
+    EXPECT_TRUE(map.isOccupied(Eigen::Vector3f(1.19f, 2.01f, -0.81f), start + 100ms));
+    EXPECT_FALSE(map.isOccupied(Eigen::Vector3f(1.21f, 2.1f, -0.9f), start + 100ms));
+}
+
+TEST(VoxelOccupancyMapTest, ScoreDecaysWithHalfLife) {
+    VoxelOccupancyMap map(testParameters());
+    const Clock::time_point start = Clock::now();
+    const std::vector<Eigen::Vector3f> points{{0.f, 0.f, 0.f}};
+    map.insert(points, start);
+    map.insert(points, start + 1ms);
+
+    // A score of 2 drops below the occupied score of 1.5 after log2(2 / 1.5) = 0.415 half lives
+    EXPECT_TRUE(map.isOccupied(points[0], start + 1ms + 700ms));
+    EXPECT_FALSE(map.isOccupied(points[0], start + 1ms + 900ms));
+
+    // Expired voxels no longer count towards the size
+    EXPECT_EQ(map.size(start + 1ms), 1U);
+    EXPECT_EQ(map.size(start + 60s), 0U);
+}
+
+TEST(VoxelOccupancyMapTest, StampsKeepMillisecondResolutionAfterLongUptime) {
+    VoxelOccupancyMap map(testParameters());
+    // Float seconds since the start only resolve 0.25 s after a month
+    const Clock::time_point late = Clock::now() + 24h * 30;
+    const std::vector<Eigen::Vector3f> points{{5.f, 5.f, -2.f}};
+
+    map.insert(points, late);
+    map.insert(points, late + 1ms);
+    EXPECT_TRUE(map.isOccupied(points[0], late + 1ms));
+    EXPECT_FALSE(map.isOccupied(points[0], late + 1ms + 1s));
+}
+
+TEST(VoxelOccupancyMapTest, QueryBeforeInsertStampDoesNotGrowTheScore) {
+    VoxelOccupancyMap map(testParameters());
+    const Clock::time_point start = Clock::now();
+    const std::vector<Eigen::Vector3f> points{{0.f, 0.f, 0.f}};
+    map.insert(points, start + 1s);
+    map.insert(points, start + 2s);
+
+    // A query stamped before the last insertion, e.g. from another thread, sees the score as inserted
+    EXPECT_TRUE(map.isOccupied(points[0], start));
+}
+
+TEST(VoxelOccupancyMapTest, RayQueryMatchesBruteForce) {
+    VoxelOccupancyMap map(testParameters());
+    const Clock::time_point time = Clock::now();
+
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<float> coordinate(-6.f, 6.f);
+    std::vector<Eigen::Vector3f> points;
+    for (int i = 0; i < 300; ++i) {
+        points.emplace_back(coordinate(generator), coordinate(generator), coordinate(generator));
+    }
+    map.insert(points, time);
+    map.insert(points, time + 1ms);
+
+    std::vector<Eigen::Vector3f> centres;
+    for (const Eigen::Vector3f& point : points) {
+        centres.push_back(((point / kVoxelSize).array().floor() + 0.5f).matrix() * kVoxelSize);
+    }
+
+    std::uniform_real_distribution<float> component(-1.f, 1.f);
+    std::uniform_real_distribution<float> radius(0.f, 1.f);
+    int hits = 0;
+    for (int i = 0; i < 500; ++i) {
+        const Eigen::Vector3f origin(coordinate(generator), coordinate(generator), coordinate(generator));
+        Eigen::Vector3f direction(component(generator), component(generator), component(generator));
+        if (direction.norm() < 1e-3f) {
+            continue;
+        }
+        direction.normalize();
+        const float radius_m = i % 4 == 0 ? 0.f : radius(generator);
+
+        const float expected = bruteForceNearest(centres, origin, direction, 10.f, radius_m);
+        const float nearest = map.nearestOccupiedAlongRay(origin, direction, 10.f, radius_m, time + 1ms);
+        if (std::isinf(expected)) {
+            EXPECT_TRUE(std::isinf(nearest)) << "ray " << i;
+        } else {
+            EXPECT_NEAR(nearest, expected, 1e-4f) << "ray " << i;
+            hits++;
+        }
+    }
+    EXPECT_GT(hits, 100);
+}
+
+TEST(VoxelOccupancyMapTest, RayQueryIgnoresDecayedVoxels) {
+    VoxelOccupancyMap map(testParameters());
+    const Clock::time_point start = Clock::now();
+    const std::vector<Eigen::Vector3f> points{{3.f, 0.1f, 0.1f}};
+    map.insert(points, start);
+    map.insert(points, start + 1ms);
+
+    const Eigen::Vector3f origin(0.f, 0.f, 0.f);
+    const Eigen::Vector3f direction(1.f, 0.f, 0.f);
+    EXPECT_NEAR(map.nearestOccupiedAlongRay(origin, direction, 10.f, 0.f, start + 1ms), 3.1f, 1e-5f);
+    EXPECT_TRUE(std::isinf(map.nearestOccupiedAlongRay(origin, direction, 10.f, 0.f, start + 10s)));
+    // Behind the origin or beyond the maximum distance
+    EXPECT_TRUE(std::isinf(map.nearestOccupiedAlongRay(origin, -direction, 10.f, 0.f, start + 1ms)));
+    EXPECT_TRUE(std::isinf(map.nearestOccupiedAlongRay(origin, direction, 2.f, 0.f, start + 1ms)));
+}
+
+TEST(VoxelOccupancyMapTest, MemoryStaysWithinBudgetAndWeakVoxelsAreEvicted) {
+    VoxelOccupancyMap::Parameters parameters = testParameters();
+    parameters.memory_budget_bytes = 1024;
+    VoxelOccupancyMap map(parameters);
+    EXPECT_LE(map.memoryBytes(), parameters.memory_budget_bytes);
+    const size_t capacity = map.capacity();
+
+    // A strong voxel seen in many batches, then far more new voxels than there are slots
+    const Clock::time_point start = Clock::now();
+    const std::vector<Eigen::Vector3f> strong{{0.f, 0.f, 0.f}};
+    for (int i = 0; i < 8; ++i) {
+        map.insert(strong, start + i * 1ms);
+    }
+    std::vector<Eigen::Vector3f> points;
+    for (int i = 1; i <= 4 * static_cast<int>(capacity); ++i) {
+        points.emplace_back(i * kVoxelSize, 0.f, 0.f);
+    }
+    map.insert(points, start + 10ms);
+
+    EXPECT_EQ(map.capacity(), capacity);
+    EXPECT_GT(map.evictions(), 0U);
+    EXPECT_LE(map.size(start + 10ms), capacity);
+    EXPECT_TRUE(map.isOccupied(strong[0], start + 10ms));
+}
@@ -40,6 +40,7 @@
 #pragma once
 
 #include <Eigen/Dense>
+#include <chrono>
 #include <iostream>
 
 inline static const std::string NED_FRAME = "ned";
@@ -49,6 +50,10 @@ inline static const std::string CAMERA_LINK_FRAME = "camera_link";
 #include <image_downsampler/DataTypes.h>
 #include <image_downsampler/ImageDownsampler.h>
 
+#include <FrameChannel.hpp>
+#include <FrameDemand.hpp>
+#include <RayTable.hpp>
+
 template <typename T>
 struct ExtendedDownsampledImage {
     DownsampledImage<T> downsampled_image;
@@ -57,6 +62,23 @@ struct ExtendedDownsampledImage {
     Eigen::Quaternionf orientation;
 
     int64_t timestamp_ns;
+
+    // Time the depth image arrived at the Sensor Manager, to measure the latency of the consumers
+    std::chrono::steady_clock::time_point received_time;
+
+    // Rays of the downsampled grid for the intrinsics of this image, shared between frames
+    std::shared_ptr<const RayTable> ray_table;
 };
 
 using ExtendedDownsampledImageF = ExtendedDownsampledImage<float>;
+
+// Part of the depth frame the consumers need, as fractions of the image width and height. Bounds are inclusive.
+struct DepthRegionOfInterest {
+    float col_begin{0.f};
+    float col_end{1.f};
+    float row_begin{0.f};
+    float row_end{1.f};
+};
+
+// Downsampled depth frames are published by the Sensor Manager and consumed lock-free by the other modules
+using DepthFrameChannel = FrameChannel<ExtendedDownsampledImageF>;
@@ -0,0 +1,275 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Summed-area tables over the landing mapper height map
+ * @file HeightMapIntegral.hpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#pragma once
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <landing_mapper/HeightMap.hpp>
+#include <limits>
+#include <vector>
+
+/**
+ * Keeps summed-area tables of the plane fit moments (count, Σx, Σy, Σz, Σx², Σxy, Σy², Σxz, Σyz, Σz²) of the valid
+ * height map cells. The least squares plane and the spread of the cells around it can then be computed for any square
+ * window from four lookups per table, independent of the window size.
+ *
+ * Cell coordinates are map indices and heights are taken relative to a reference height, so the sums stay small enough
+ * for double precision. The tables are stored column by column, matching the Eigen height matrix. Every table entry
+ * sums all cells before it, so an update recomputes the tables from the first changed column to the last one. For a
+ * map updated across its whole width that is close to a full rebuild. A moved, resized or rescaled map is always
+ * rebuilt completely.
+ *
+ * The maximum deviations above and below the plane are not decomposable into sums and are left at NaN.
+ */
+template <typename T>
+class HeightMapIntegral {
+   public:
+    using Heights = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+    using Position = Eigen::Matrix<T, 2, 1>;
+
+    /**
+     * @brief Plane fit moments of a set of cells
+     */
+    struct Moments {
+        double n{0.0}, x{0.0}, y{0.0}, z{0.0}, xx{0.0}, xy{0.0}, yy{0.0}, xz{0.0}, yz{0.0}, zz{0.0};
+
+        void add(double cx, double cy, double cz) {
+            n += 1.0;
+            x += cx;
+            y += cy;
+            z += cz;
+            xx += cx * cx;
+            xy += cx * cy;
+            yy += cy * cy;
+            xz += cx * cz;
+            yz += cy * cz;
+            zz += cz * cz;
+        }
+
+        Moments& operator+=(const Moments& o) {
+            n += o.n;
+            x += o.x;
+            y += o.y;
+            z += o.z;
+            xx += o.xx;
+            xy += o.xy;
+            yy += o.yy;
+            xz += o.xz;
+            yz += o.yz;
+            zz += o.zz;
+            return *this;
+        }
+
+        Moments& operator-=(const Moments& o) {
+            n -= o.n;
+            x -= o.x;
+            y -= o.y;
+            z -= o.z;
+            xx -= o.xx;
+            xy -= o.xy;
+            yy -= o.yy;
+            xz -= o.xz;
+            yz -= o.yz;
+            zz -= o.zz;
+            return *this;
+        }
+    };
+
+    static bool isValid(T height) { return height != std::numeric_limits<T>::max(); }
+
+    /**
+     * @brief Update the tables from the current height map
+     * @return index of the first rebuilt column, or the number of columns if nothing changed
+     */
+    int update(const height_map::HeightMap<T>& height_map) {
+        return update(height_map.heights(), height_map.getCentrePosition(), height_map.getBinEdgeWidth());
+    }
+
+    int update(const Heights& heights, const Position& centre, T cell_size) {
+        const int rows = heights.rows();
+        const int cols = heights.cols();
+
+        int first_changed_col = 0;
+        if (rows == _heights.rows() && cols == _heights.cols() && centre == _centre && cell_size == _cell_size) {
+            first_changed_col = cols;
+            for (int c = 0; c < cols; ++c) {
+                if (heights.col(c) != _heights.col(c)) {
+                    first_changed_col = c;
+                    break;
+                }
+            }
+        } else {
+            _table.assign(static_cast<size_t>(rows + 1) * (cols + 1), Moments{});
+            _centre = centre;
+            _cell_size = cell_size;
+            _reference_height = 0.0;
+            for (int i = 0; i < heights.size(); ++i) {
+                if (isValid(heights.data()[i])) {
+                    _reference_height = heights.data()[i];
+                    break;
+                }
+            }
+        }
+        _heights = heights;
+
+        for (int c = first_changed_col; c < cols; ++c) {
+            // Running sum down the column, added to the table column on the left
+            Moments column_sum;
+            for (int r = 0; r < rows; ++r) {
+                const T height = heights(r, c);
+                if (isValid(height)) {
+                    column_sum.add(r, c, height - _reference_height);
+                }
+                Moments& entry = at(r + 1, c + 1);
+                entry = at(r + 1, c);
+                entry += column_sum;
+            }
+        }
+
+        return first_changed_col;
+    }
+
+    int rows() const { return _heights.rows(); }
+    int cols() const { return _heights.cols(); }
+    T cellSize() const { return _cell_size; }
+    const Heights& heights() const { return _heights; }
+    const Position& centre() const { return _centre; }
+
+    /**
+     * @brief Map index of the cell corner nearest to a position, may lie outside of the map. A window of 2 h cells
+     * centred on the position spans the indices [index - h, index + h).
+     */
+    Eigen::Vector2i cellIndex(const Position& position) const {
+        const Position index =
+            (position - _centre) / _cell_size + Position(T(_heights.rows()), T(_heights.cols())) * T(0.5);
+        return Eigen::Vector2i(std::lround(index.x()), std::lround(index.y()));
+    }
+
+    /**
+     * @brief Moments of the valid cells in rows [r0, r1) and columns [c0, c1), clipped to the map
+     */
+    Moments windowMoments(int r0, int c0, int r1, int c1) const {
+        if (_table.empty()) {
+            return Moments{};
+        }
+        r0 = std::clamp(r0, 0, rows());
+        r1 = std::clamp(r1, r0, rows());
+        c0 = std::clamp(c0, 0, cols());
+        c1 = std::clamp(c1, c0, cols());
+
+        Moments m = at(r1, c1);
+        m -= at(r0, c1);
+        m -= at(r1, c0);
+        m += at(r0, c0);
+        return m;
+    }
+
+    /**
+     * @brief Statistics of the square window of the given edge length centred on a position
+     */
+    height_map::HeightMapStats windowStats(const Position& position, T window_size_m) const {
+        const int half_window = std::max(1, static_cast<int>(std::lround(window_size_m / _cell_size * 0.5)));
+        const Eigen::Vector2i centre = cellIndex(position);
+        const int r0 = centre.x() - half_window;
+        const int c0 = centre.y() - half_window;
+        const int r1 = centre.x() + half_window;
+        const int c1 = centre.y() + half_window;
+        return statsFromMoments(windowMoments(r0, c0, r1, c1), (r1 - r0) * (c1 - c0), _cell_size);
+    }
+
+    /**
+     * @brief Plane fit statistics of a window, from its moments. Coordinates are in cells of the given size.
+     */
+    static height_map::HeightMapStats statsFromMoments(const Moments& m, int samples, T cell_size) {
+        static constexpr T nan = std::numeric_limits<T>::quiet_NaN();
+
+        height_map::HeightMapStats stats;
+        stats.samples = samples;
+        stats.valid_samples = static_cast<int>(std::lround(m.n));
+        stats.slope_deg = nan;
+        stats.slope_normal = Eigen::Matrix<T, 3, 1>(nan, nan, nan);
+        stats.above_plane_max_deviation_m = nan;
+        stats.below_plane_max_deviation_m = nan;
+        stats.std_dev_from_plane_m = nan;
+
+        if (m.n < 3.0) {
+            return stats;
+        }
+
+        // Central moments of the window
+        const double mean_x = m.x / m.n;
+        const double mean_y = m.y / m.n;
+        const double mean_z = m.z / m.n;
+        const double cxx = m.xx / m.n - mean_x * mean_x;
+        const double cxy = m.xy / m.n - mean_x * mean_y;
+        const double cyy = m.yy / m.n - mean_y * mean_y;
+        const double cxz = m.xz / m.n - mean_x * mean_z;
+        const double cyz = m.yz / m.n - mean_y * mean_z;
+        const double czz = m.zz / m.n - mean_z * mean_z;
+
+        // Least squares plane z = a * x + b * y + c
+        const double det = cxx * cyy - cxy * cxy;
+        if (det <= 1e-9) {
+            // All valid cells on one line, the plane is undetermined
+            return stats;
+        }
+        const double a = (cxz * cyy - cyz * cxy) / det;
+        const double b = (cyz * cxx - cxz * cxy) / det;
+        const double vertical_variance = std::max(0.0, czz - a * cxz - b * cyz);
+
+        const Eigen::Vector3d normal = Eigen::Vector3d(-a / cell_size, -b / cell_size, 1.0).normalized();
+        stats.slope_normal = normal.cast<T>();
+        stats.slope_deg = static_cast<T>(std::acos(normal.z()) * 180.0 / M_PI);
+        // Vertical residuals scaled to distances perpendicular to the plane
+        stats.std_dev_from_plane_m = static_cast<T>(std::sqrt(vertical_variance) * normal.z());
+        return stats;
+    }
+
+   private:
+    Moments& at(int r, int c) { return _table[static_cast<size_t>(c) * (_heights.rows() + 1) + r]; }
+    const Moments& at(int r, int c) const { return _table[static_cast<size_t>(c) * (_heights.rows() + 1) + r]; }
+
+    Heights _heights;
+    Position _centre{Position::Zero()};
+    T _cell_size{1};
+    double _reference_height{0.0};
+    std::vector<Moments> _table;
+};
@@ -0,0 +1,79 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Immutable height map snapshot handed from the landing mapper to its readers
+ * @file HeightMapSnapshot.hpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#pragma once
+
+#include <Eigen/Core>
+#include <HeightMapIntegral.hpp>
+#include <cmath>
+#include <landing_mapper/HeightMap.hpp>
+
+/**
+ * Height map snapshots are published by the mapper after every map update and read without blocking it. They carry the
+ * window size and thresholds of the mapper that built them, so readers never touch the mapper parameters.
+ */
+struct HeightMapSnapshot {
+    struct WindowParameters {
+        float window_size_m{0.f};
+        float slope_threshold_deg{0.f};
+        float std_dev_from_plane_thresh_m{0.f};
+        float percentage_of_valid_samples_in_window{0.f};
+    };
+
+    HeightMapIntegral<float> map;
+    WindowParameters window;
+
+    height_map::HeightMapStats windowStats(const Eigen::Vector2f& position) const {
+        return map.windowStats(position, window.window_size_m);
+    }
+
+    /**
+     * @brief Whether the window at a position already fails the slope or plane deviation thresholds
+     */
+    bool failsWindowThresholds(const Eigen::Vector2f& position) const {
+        const height_map::HeightMapStats stats = windowStats(position);
+        // Only trust the plane fit when the window holds enough valid samples, the mapper decides otherwise
+        if (stats.samples == 0 || std::isnan(stats.slope_deg) ||
+            stats.valid_samples < window.percentage_of_valid_samples_in_window * stats.samples) {
+            return false;
+        }
+        return stats.slope_deg > window.slope_threshold_deg ||
+               stats.std_dev_from_plane_m > window.std_dev_from_plane_thresh_m;
+    }
+};
@@ -39,6 +39,8 @@
  */
 
 #include <LandingManager.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 
 using namespace std::chrono_literals;
 using namespace std::placeholders;
@@ -47,10 +49,13 @@ static constexpr auto mapper_interval = 100ms;
 static constexpr auto visualisation_interval = 1s;
 static constexpr auto print_stats_interval = 30s;
 
+// Candidate batches from this size on are pre-checked in parallel
+static constexpr size_t parallel_query_batch_size = 64;
+
 LandingManager::LandingManager(std::shared_ptr<mavsdk::System> mavsdk_system)
     : Node("landing_manager"),
       _mavsdk_system{std::move(mavsdk_system)},
-      _config_update_callback([]() { return LandingManagerConfiguration{}; }),
+      _config_channel(std::make_shared<ConfigurationChannel>()),
       _visualize(true),
       _visualizer(std::make_shared<viz::MapVisualizer>(this)),
       _frequency_mapper("mapper"),
@@ -67,9 +72,6 @@ LandingManager::LandingManager(std::shared_ptr<mavsdk::System> mavsdk_system)
 LandingManager::~LandingManager() { deinit(); }
 
 void LandingManager::initParameters() {
-    std::unique_lock<std::mutex> lock(landing_manager_config_mtx);
-    _landing_manager_config = _config_update_callback();
-
     _mapper_parameter.search_altitude_m = 7.5f;
     _mapper_parameter.window_size_m = 2.0f;
 
@@ -86,6 +88,21 @@ void LandingManager::initParameters() {
     this->declare_parameter("percentage_of_valid_samples_in_window");
     // Enable debug logging
     this->declare_parameter("debug_mapper");
+    // Mapper scheduling
+    this->declare_parameter("mapper_trigger");
+    this->declare_parameter("mapper_max_rate_hz");
+    this->declare_parameter("mapper_skip_policy");
+    // Pixels per parallel projection chunk, 0 to project serially
+    this->declare_parameter("projection_grain_size");
+    // Number of frames batched into one map update, their points are merged per height map cell column. Only lowers
+    // the map update rate, keep it at 1 unless the mapper cannot keep up.
+    this->declare_parameter("mapper_accumulate_frames");
+    // Height of the point handed to the mapper per column: off, mean, min_z or max_z. Keep it off until the mapper
+    // time saved and the landing state agreement have been measured against the landing_mapper with
+    // voxel-prefilter-benchmark.
+    this->declare_parameter("mapper_voxel_prefilter");
+    // Reject landing positions from the height map snapshot before querying the mapper
+    this->declare_parameter("landing_state_snapshot_precheck");
 
     // Get ROS parameters with defaults
     // Map config
@@ -101,11 +118,61 @@ void LandingManager::initParameters() {
                            _mapper_parameter.percentage_of_valid_samples_in_window, 0.7f);
     // Enable debug logging
     this->get_parameter_or("debug_mapper", _mapper_parameter.debug_print, false);
+    // Mapper scheduling
+    std::string mapper_trigger;
+    std::string mapper_skip_policy;
+    this->get_parameter_or("mapper_trigger", mapper_trigger, std::string("timer"));
+    this->get_parameter_or("mapper_max_rate_hz", _mapper_max_rate_hz, 15.0);
+    this->get_parameter_or("mapper_skip_policy", mapper_skip_policy, std::string("latest"));
+    int projection_grain_size;
+    this->get_parameter_or("projection_grain_size", projection_grain_size, 2048);
+    _projector_parameters.grain_size = static_cast<size_t>(std::max(projection_grain_size, 0));
+    int mapper_accumulate_frames;
+    this->get_parameter_or("mapper_accumulate_frames", mapper_accumulate_frames, 1);
+    _mapper_accumulate_frames = static_cast<size_t>(std::max(mapper_accumulate_frames, 1));
+    _point_accumulator.setVoxelSize(_mapper_parameter.voxel_size_m);
+    std::string mapper_voxel_prefilter;
+    this->get_parameter_or("mapper_voxel_prefilter", mapper_voxel_prefilter, std::string("off"));
+    this->get_parameter_or("landing_state_snapshot_precheck", _landing_state_snapshot_precheck, false);
+
+    if (mapper_trigger == "frame") {
+        _mapper_trigger = MapperTrigger::FRAME;
+    } else if (mapper_trigger != "timer") {
+        RCLCPP_ERROR(get_logger(), "Unknown mapper_trigger '%s', using 'timer'", mapper_trigger.c_str());
+    }
+
+    if (mapper_skip_policy == "drop") {
+        _mapper_skip_policy = MapperSkipPolicy::DROP;
+    } else if (mapper_skip_policy != "latest") {
+        RCLCPP_ERROR(get_logger(), "Unknown mapper_skip_policy '%s', using 'latest'", mapper_skip_policy.c_str());
+    }
+
+    _mapper_voxel_prefilter = true;
+    if (mapper_voxel_prefilter == "min_z") {
+        _mapper_voxel_representative = VoxelPointAccumulator::Representative::MIN_Z;
+    } else if (mapper_voxel_prefilter == "max_z") {
+        _mapper_voxel_representative = VoxelPointAccumulator::Representative::MAX_Z;
+    } else if (mapper_voxel_prefilter != "mean") {
+        _mapper_voxel_prefilter = false;
+        if (mapper_voxel_prefilter != "off") {
+            RCLCPP_ERROR(get_logger(), "Unknown mapper_voxel_prefilter '%s', using 'off'",
+                         mapper_voxel_prefilter.c_str());
+        }
+    }
 }
 
-void LandingManager::updateParameters() {
+bool LandingManager::updateParameters() {
+    // Nothing to do until the Autopilot Manager publishes a new configuration
+    const std::shared_ptr<const LandingManagerConfiguration> config = _config_channel->poll(_config_generation);
+    if (config == nullptr) {
+        return false;
+    }
+
     std::unique_lock<std::mutex> lock(landing_manager_config_mtx);
-    _landing_manager_config = _config_update_callback();
+    _landing_manager_config = *config;
+
+    const auto search_altitude_m = _mapper_parameter.search_altitude_m;
+    const auto window_size_m = _mapper_parameter.window_size_m;
 
     // These are the only parameters configurable through AMC
     if (_landing_manager_config.safe_landing_distance_to_ground == 0 ||
@@ -116,6 +183,8 @@ void LandingManager::updateParameters() {
         !setSearchWindow_m(_landing_manager_config.safe_landing_area_square_size)) {
         _mapper_parameter.window_size_m = 2.0f;
     }
+
+    return _mapper_parameter.search_altitude_m != search_altitude_m || _mapper_parameter.window_size_m != window_size_m;
 }
 
 void LandingManager::init() {
@@ -125,6 +194,8 @@ void LandingManager::init() {
     updateParameters();
 
     _mapper = std::make_unique<landing_mapper::LandingMapper<float>>(_mapper_parameter);
+    _projector = std::make_unique<PointCloudProjector>(_projector_parameters);
+    _height_map_pool.reset(HeightMapChannel::kMaxFramesInUse + 1, [](HeightMapSnapshot&) {});
 
     // Setup ROS stuff
     _callback_group_mapper = this->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
@@ -134,9 +205,24 @@ void LandingManager::init() {
     auto telemetry_opt = rclcpp::SubscriptionOptions();
     telemetry_opt.callback_group = _callback_group_telemetry;
 
-    // Mapper runs at 10hz
-    _timer_mapper =
-        this->create_wall_timer(mapper_interval, std::bind(&LandingManager::mapper, this), _callback_group_mapper);
+    if (_mapper_trigger == MapperTrigger::FRAME && _depth_frame_channel) {
+        // Mapper runs whenever the Sensor Manager publishes a new frame
+        std::cout << landingManagerOut << "Mapper triggered by new frames, max rate " << _mapper_max_rate_hz << " Hz"
+                  << std::endl;
+        _mapper_thread_stop = false;
+        _mapper_thread = std::thread(&LandingManager::mapperLoop, this);
+    } else {
+        // Mapper runs at 10hz
+        _timer_mapper = this->create_wall_timer(
+            mapper_interval,
+            [this]() {
+                const DepthFrameChannel::Frame depth_frame =
+                    _depth_frame_channel ? _depth_frame_channel->latest() : DepthFrameChannel::Frame{};
+                countMappedFrame(depth_frame.sequence);
+                mapper(depth_frame);
+            },
+            _callback_group_mapper);
+    }
 
     // Vizualizaion runs at 1hz
     _timer_map_visualizer =
@@ -161,7 +247,12 @@ void LandingManager::init() {
         this->create_publisher<std_msgs::msg::Float32>("landing_manager/stats/std_dev_from_plane", 10);
 }
 
-auto LandingManager::deinit() -> void {}
+auto LandingManager::deinit() -> void {
+    _mapper_thread_stop = true;
+    if (_mapper_thread.joinable()) {
+        _mapper_thread.join();
+    }
+}
 
 auto LandingManager::run() -> void { rclcpp::spin(shared_from_this()); }
 
@@ -189,7 +280,7 @@ bool LandingManager::setSearchWindow_m(const double window_size) {
     return true;
 }
 
-bool LandingManager::healthCheck(const std::shared_ptr<ExtendedDownsampledImageF>& depth_msg) {
+bool LandingManager::healthCheck(const DepthFrameChannel::Frame& depth_frame) {
     static constexpr int16_t MAX_NULL_IMAGE = 5;
     static constexpr int16_t MAX_OLD_TIMESTAMP = 50;
 
@@ -197,17 +288,18 @@ bool LandingManager::healthCheck(const std::shared_ptr<ExtendedDownsampledImageF
         int16_t count_image_null{0};
         int16_t count_timestamp_old{0};
 
-        int64_t last_timestamp{0};
+        uint64_t last_sequence{0};
     };
     static HealthHandly health;
 
-    if (depth_msg == nullptr) {
+    if (depth_frame.data == nullptr) {
         health.count_image_null++;
     } else {
         health.count_image_null = 0;
 
-        const bool is_timestamp_old = health.last_timestamp >= depth_msg->timestamp_ns;
-        health.last_timestamp = depth_msg->timestamp_ns;
+        // The frame sequence number only increases when the Sensor Manager publishes a new frame
+        const bool is_timestamp_old = health.last_sequence >= depth_frame.sequence;
+        health.last_sequence = depth_frame.sequence;
         if (is_timestamp_old) {
             health.count_timestamp_old++;
         } else {
@@ -244,32 +336,108 @@ bool LandingManager::healthCheck(const std::shared_ptr<ExtendedDownsampledImageF
     return isHealthy();
 }
 
-void LandingManager::mapper() {
-    _frequency_mapper.tic();
+void LandingManager::mapperLoop() {
+    using Clock = std::chrono::steady_clock;
+    const Clock::duration min_period =
+        _mapper_max_rate_hz > 0.0
+            ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / _mapper_max_rate_hz))
+            : Clock::duration::zero();
+
+    uint64_t last_sequence = _depth_frame_channel->sequence();
+    Clock::time_point last_run = Clock::now() - min_period;
+
+    while (!_mapper_thread_stop) {
+        // The timeout keeps the health check running when the camera stalls
+        const uint64_t sequence = _depth_frame_channel->wait_for_new(last_sequence, mapper_interval);
+        if (_mapper_thread_stop) {
+            break;
+        }
 
-    // check for parameter updates
-    // TODO: make this call dependent on a dbus param update on the Autopilot Manager
-    // instead of running at every loop update
-    updateParameters();
+        if (sequence != last_sequence) {
+            const Clock::time_point next_run = last_run + min_period;
+            if (Clock::now() < next_run) {
+                if (_mapper_skip_policy == MapperSkipPolicy::DROP) {
+                    _frames_skipped += sequence - last_sequence;
+                    last_sequence = sequence;
+                    _last_mapped_sequence = sequence;
+                    continue;
+                }
+                std::this_thread::sleep_until(next_run);
+            }
+            last_run = Clock::now();
+        }
+
+        const DepthFrameChannel::Frame depth_frame = _depth_frame_channel->latest();
+        countMappedFrame(depth_frame.sequence);
+        last_sequence = depth_frame.sequence;
+        mapper(depth_frame);
+    }
+}
 
-    // TODO: reinstantiate _mapper a after parameter update
+void LandingManager::countMappedFrame(uint64_t sequence) {
+    const uint64_t last_mapped_sequence = _last_mapped_sequence;
+    if (sequence > last_mapped_sequence) {
+        _frames_processed++;
+        _frames_coalesced += sequence - last_mapped_sequence - 1;
+        _last_mapped_sequence = sequence;
+    }
+}
+
+void LandingManager::mapper(const DepthFrameChannel::Frame& depth_frame) {
+    _frequency_mapper.tic();
+
+    // Check for parameter updates, the mapper is rebuilt when its parameters changed
+    if (updateParameters()) {
+        std::lock_guard<std::mutex> lock(_map_mutex);
+        _mapper = std::make_unique<landing_mapper::LandingMapper<float>>(_mapper_parameter);
+        // Points binned and snapshots published for the old mapper must not leak into the new one. Readers fall back
+        // to the mapper until it publishes its first snapshot.
+        _point_accumulator.clear();
+        if (!_height_map_channel.publish(nullptr)) {
+            _height_map_snapshots_dropped++;
+        }
+        std::cout << landingManagerOut << "Landing mapper updated, search altitude "
+                  << _mapper_parameter.search_altitude_m << " m, window " << _mapper_parameter.window_size_m << " m"
+                  << std::endl;
+    }
 
     // Only process the data to build a landing map when the Autopilot Manager is enabled, Safe Landing is set as the
     // decision maker, and the OA interface is enabled (i.e. the user has activated Safe Landing).
     const bool should_build_landing_map = isEnabledInConfig() && is_obstacle_avoidance_enabled();
 
+    // Frames are only downsampled for us while we build the map. Triggered by frames, at most as often as the mapper
+    // runs. The timer takes every frame, limited to its rate they would arrive out of phase with its ticks.
+    if (_depth_frame_consumer) {
+        const double mapper_rate_hz = _mapper_trigger == MapperTrigger::FRAME ? _mapper_max_rate_hz : 0.0;
+        _depth_frame_consumer->setDemand(should_build_landing_map, mapper_rate_hz);
+    }
+
+    // The latest frame can be one from before mapping was last enabled, taken where the vehicle was back then
+    const bool is_frame_stale = depth_frame.data != nullptr && _depth_frame_consumer &&
+                                !_depth_frame_consumer->wants(depth_frame.data->received_time);
+
+    // Points of an interrupted batch are stale by the time mapping resumes
+    if (!should_build_landing_map) {
+        _point_accumulator.clear();
+    }
+
     if (should_build_landing_map) {
         timing_tools::Timer timer_mapper("mapper: total", true);
 
-        // Here we capture the downsampled depth data computed in the SensorManager
-        std::shared_ptr<ExtendedDownsampledImageF> depth_msg = _downsampled_depth_update_callback();
+        // Here we use the downsampled depth data computed in the SensorManager
+        const std::shared_ptr<const ExtendedDownsampledImageF>& depth_msg = depth_frame.data;
 
-        const bool is_landing_mapper_healthy = healthCheck(depth_msg);
+        const bool is_landing_mapper_healthy = healthCheck(depth_frame);
+
+        // A stale frame leaves the landing state unknown, like a missing one
+        if (is_frame_stale) {
+            _frames_stale++;
+        }
 
-        if (depth_msg != nullptr && is_landing_mapper_healthy &&
+        if (!is_frame_stale && depth_msg != nullptr && is_landing_mapper_healthy && depth_msg->ray_table != nullptr &&
             depth_msg->downsampled_image.depth_pixel_array.size() > 0) {
-            const RectifiedIntrinsicsF intrinsics = depth_msg->downsampled_image.intrinsics;
-            const DepthPixelArrayF depth_pixel_array = depth_msg->downsampled_image.depth_pixel_array;
+            const RectifiedIntrinsicsF& intrinsics = depth_msg->downsampled_image.intrinsics;
+            const DepthPixelArrayF& depth_pixel_array = depth_msg->downsampled_image.depth_pixel_array;
             const rclcpp::Time timestamp(depth_msg->timestamp_ns);
             const Eigen::Vector3f position = depth_msg->position;
             const Eigen::Quaternionf orientation = depth_msg->orientation;
@@ -280,46 +448,46 @@ void LandingManager::mapper() {
             timing_tools::Timer timer_pointcloud("point cloud: total     ", true);
             {
                 std::lock_guard<std::mutex> lock(_map_mutex);
-                _pointcloud_for_mapper.clear();
-                _visualizer->prepare_point_cloud_msg(depth_msg->timestamp_ns, intrinsics.rw, intrinsics.rh, _visualize);
-
-                const Eigen::Vector2f principal_point = intrinsics.principal_point();
-                const Eigen::Vector2f inverse_focal_length = intrinsics.inverse_focal_length();
 
                 timing_tools::Timer timer_pointcloud_depth_to_3D("point cloud: depth->3D ", true);
-                float point_height_min = std::numeric_limits<float>::max();
-                for (const DepthPixelF& depth_pixel : depth_pixel_array) {
-                    const float depth = depth_pixel.depth;
-
-                    // TODO those ROS2 paramters
-                    const float min_depth_to_use = 0.7f;
-                    const float max_depth_to_use = 16.f;
-                    if (std::isfinite(depth) && (depth > min_depth_to_use)) {
-                        Eigen::Matrix<float, 3, 1> point(0.0, 0.0, depth);
-                        point.head<2>() = (Eigen::Matrix<float, 2, 1>(depth_pixel.x, depth_pixel.y) - principal_point)
-                                              .cwiseProduct(inverse_focal_length) *
-                                          depth;
-                        point = orientation * point + position;
-
-                        if (depth < max_depth_to_use) {
-                            _pointcloud_for_mapper.push_back(point);
-                            _visualizer->add_point_to_point_cloud(point, _visualize);
-                        }
-
-                        const float point_height = point(2) - position(2);
-                        if (point_height < point_height_min) {
-                            point_height_min = point_height;
-                        }
-                    }
-                }
+                const float point_height_min =
+                    _projector->project(depth_pixel_array, *depth_msg->ray_table, position, orientation,
+                                        _pointcloud_for_mapper);
                 timer_pointcloud_depth_to_3D.stop();
 
+                // With accumulation, the map is updated once per batch of frames. Binning and recentering are paid
+                // once for all of them, at the price of up to mapper_accumulate_frames - 1 frames of extra map
+                // latency. The batch is merged into one point per cell column, the same as a single frame covering
+                // those cells would give, so batching only lowers the update rate and does not densify the map. The
+                // voxel prefilter alone merges the points of each frame, which at low altitude mostly land in the
+                // same few cells. The columns follow the cells of the current map, so no column straddles two cells.
                 timing_tools::Timer timer_pointcloud_map_update("point cloud: map update", true);
-                _mapper->updateCloud(_pointcloud_for_mapper);
+                bool map_updated = false;
+                if (_mapper_accumulate_frames > 1 || _mapper_voxel_prefilter) {
+                    _point_accumulator.alignToHeightMap(_mapper->getHeightMap());
+                    _point_accumulator.add(_pointcloud_for_mapper.points());
+                    if (_point_accumulator.frames() >= _mapper_accumulate_frames) {
+                        _points_accumulated += _point_accumulator.pointsIn();
+                        _point_accumulator.flush(_pointcloud_batch, _mapper_voxel_representative);
+                        _points_batched += _pointcloud_batch.size();
+                        _mapper->updateCloud(_pointcloud_batch.points());
+                        map_updated = true;
+                    }
+                } else {
+                    _mapper->updateCloud(_pointcloud_for_mapper.points());
+                    map_updated = true;
+                }
                 _mapper->setImageHeightEstimate(point_height_min);
                 timer_pointcloud_map_update.stop();
 
-                _visualizer->visualizePointCloud(_visualize);
+                if (map_updated) {
+                    _map_updates++;
+                    timing_tools::Timer timer_pointcloud_map_snapshot("point cloud: map snapshot", true);
+                    publishHeightMapSnapshot();
+                    timer_pointcloud_map_snapshot.stop();
+                }
+
+                _visualizer->visualizePointCloud(_pointcloud_for_mapper, depth_msg->timestamp_ns, _visualize);
             }
             timer_pointcloud.stop();
 
@@ -367,19 +535,72 @@ void LandingManager::mapper() {
         // std::cout << landingManagerOut << " state " << landing_mapper::string_state(_state) << std::endl;
 
         // Always publish the landing state to the ROS side
+        landing_mapper::eLandingMapperState latest_state;
         {
             auto landing_state_msg = std_msgs::msg::String();
 
             std::lock_guard<std::mutex> lock(_landing_manager_mutex);
+            latest_state = _state;
             landing_state_msg.data = landing_mapper::string_state(_state);
 
             _landing_state_pub->publish(landing_state_msg);
         }
 
+        // Push state changes, so the decision maker reacts without waiting for its next tick
+        if (latest_state != _notified_state) {
+            _notified_state = latest_state;
+            std::lock_guard<std::mutex> lock(_landing_state_callback_mutex);
+            if (_landing_state_callback) {
+                _landing_state_callback(latest_state);
+            }
+        }
+
         timer_mapper.stop();
     }
 }
 
+std::vector<landing_mapper::eLandingMapperState> LandingManager::get_landing_condition_states_at_positions(
+    const std::vector<Eigen::Vector2f>& positions) {
+    std::vector<landing_mapper::eLandingMapperState> states(positions.size(),
+                                                            landing_mapper::eLandingMapperState::CAN_NOT_LAND);
+    std::vector<uint8_t> rejected(positions.size(), 0U);
+
+    // With the snapshot precheck enabled, all candidates are pre-checked against the same snapshot. It is immutable,
+    // so this needs no lock and can run concurrently.
+    const HeightMapChannel::Frame snapshot =
+        _landing_state_snapshot_precheck ? _height_map_channel.latest() : HeightMapChannel::Frame{};
+    if (snapshot.data != nullptr) {
+        const auto check_windows = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                rejected[i] = snapshot.data->failsWindowThresholds(positions[i]);
+            }
+        };
+        if (positions.size() >= parallel_query_batch_size) {
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(0, positions.size(), parallel_query_batch_size / 4),
+                [&](const tbb::blocked_range<size_t>& range) { check_windows(range.begin(), range.end()); });
+        } else {
+            check_windows(0, positions.size());
+        }
+    }
+
+    if (std::all_of(rejected.begin(), rejected.end(), [](uint8_t r) { return r != 0U; })) {
+        return states;
+    }
+
+    std::lock_guard<std::mutex> lock_manager(_landing_manager_mutex);
+    std::lock_guard<std::mutex> lock_map(_map_mutex);
+
+    // The mapper is not safe for concurrent queries, the remaining candidates are evaluated in order
+    for (size_t i = 0; i < positions.size(); ++i) {
+        if (!rejected[i]) {
+            states[i] = _mapper->computeLandingStateAtPositionXY(positions[i].x(), positions[i].y());
+        }
+    }
+
+    return states;
+}
+
 void LandingManager::publishHeightStats(const height_map::HeightMapStats& height_stats) const {
     auto stats_msg = std_msgs::msg::Float32();
 
@@ -422,10 +643,33 @@ void LandingManager::visualizeMap() {
     }
     _frequency_visualise_map.tic();
     timing_tools::Timer timer_visualise_map("visualise map", true);
-    _visualizer->visualizeHeightMap(_mapper->getHeightMap(), now(), _visualize);
+    const HeightMapChannel::Frame snapshot = _height_map_channel.latest();
+    if (snapshot.data != nullptr) {
+        _visualizer->visualizeHeightMap(snapshot.data->map, now(), _visualize);
+    }
     timer_visualise_map.stop();
 }
 
+void LandingManager::publishHeightMapSnapshot() {
+    // Called by the mapper with _map_mutex held, after the map was updated
+    std::shared_ptr<HeightMapSnapshot> snapshot = _height_map_pool.acquire();
+    if (snapshot == nullptr) {
+        // Readers keep the previous snapshot until a pooled one is released
+        _height_map_snapshots_dropped++;
+        return;
+    }
+
+    snapshot->map.update(_mapper->getHeightMap());
+    snapshot->window.window_size_m = _mapper_parameter.window_size_m;
+    snapshot->window.slope_threshold_deg = _mapper_parameter.slope_threshold_deg;
+    snapshot->window.std_dev_from_plane_thresh_m = _mapper_parameter.std_dev_from_plane_thresh_m;
+    snapshot->window.percentage_of_valid_samples_in_window = _mapper_parameter.percentage_of_valid_samples_in_window;
+    if (!_height_map_channel.publish(std::move(snapshot))) {
+        // Every other slot is still being read, readers keep the previous snapshot
+        _height_map_snapshots_dropped++;
+    }
+}
+
 void LandingManager::printStats() {
     // Only produce log output if the autopilot manager and safe landing are enabled
     if (isEnabledInConfig()) {
@@ -449,6 +693,20 @@ void LandingManager::printStats() {
         ss << "Images processed" << std::setw(width) << _images_processed << std::endl;
         ss << "Points processed" << std::setw(width) << _points_processed << std::endl;
         ss << "Points / image  " << std::setw(width) << points_per_image << " (" << percent_points << "%)" << std::endl;
+        ss << "Frames processed" << std::setw(width) << _frames_processed << std::endl;
+        ss << "Frames skipped  " << std::setw(width) << _frames_skipped << std::endl;
+        ss << "Frames coalesced" << std::setw(width) << _frames_coalesced << std::endl;
+        ss << "Frames stale    " << std::setw(width) << _frames_stale << std::endl;
+        ss << "Map version     " << std::setw(width) << _height_map_channel.sequence() << std::endl;
+        ss << "Maps dropped    " << std::setw(width) << _height_map_snapshots_dropped << std::endl;
+        ss << "Map updates     " << std::setw(width) << _map_updates << std::endl;
+        if (_mapper_accumulate_frames > 1 || _mapper_voxel_prefilter) {
+            // Points left after merging per voxel, the mapper only bins these
+            const int percent_batched = _points_accumulated ? (int)(100. * _points_batched / _points_accumulated) : 0;
+            ss << "Voxel points in " << std::setw(width) << _points_accumulated << std::endl;
+            ss << "Voxel points out" << std::setw(width) << _points_batched << " (" << percent_batched << "%)"
+               << std::endl;
+        }
 
         std::cout << std::endl << ss.str() << std::endl;
     }
@@ -459,6 +717,13 @@ void LandingManager::printStats() {
     _images_processed = 0;
     _points_processed = 0;
     _points_received = 0;
+    _frames_processed = 0;
+    _frames_skipped = 0;
+    _frames_coalesced = 0;
+    _frames_stale = 0;
+    _map_updates = 0;
+    _points_accumulated = 0;
+    _points_batched = 0;
 }
 
 bool LandingManager::isEnabledInConfig() const {
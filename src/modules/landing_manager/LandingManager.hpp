@@ -43,14 +43,26 @@
 #include <common.h>
 #include <timing_tools/timing_tools.h>
 
+#include <ConfigChannel.hpp>
 #include <Eigen/Core>
+#include <FrameChannel.hpp>
+#include <FramePool.hpp>
 #include <ModuleBase.hpp>
 #include <ObstacleAvoidanceModule.hpp>
+#include <atomic>
 #include <chrono>
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 // ROS dependencies
+#include <HeightMapIntegral.hpp>
+#include <HeightMapSnapshot.hpp>
 #include <MapVisualizer.hpp>
+#include <PointCloudProjector.hpp>
+#include <VoxelPointAccumulator.hpp>
 #include <landing_mapper/LandingMapper.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <sensor_msgs/msg/image.hpp>
@@ -61,12 +73,7 @@
 #include <mavsdk/mavsdk.h>
 #include <mavsdk/plugins/server_utility/server_utility.h>
 
-struct VehicleState {
-    bool valid{false};
-    Eigen::Vector3f position{NAN, NAN, NAN}, velocity{NAN, NAN, NAN}, acceleration{NAN, NAN, NAN};
-    Eigen::Quaternionf orientation{NAN, NAN, NAN, NAN};
-    Eigen::Vector3f angular_velocity{NAN, NAN, NAN};
-};
+using HeightMapChannel = FrameChannel<HeightMapSnapshot>;
 
 static constexpr auto landingManagerOut = "[Landing Manager] ";
 
@@ -88,6 +95,8 @@ class LandingManager : public rclcpp::Node, public ObstacleAvoidanceModule, Modu
         double safe_landing_distance_to_ground = 0.0;
     };
 
+    using ConfigurationChannel = ConfigChannel<LandingManagerConfiguration>;
+
     landing_mapper::eLandingMapperState RCPPUTILS_TSA_GUARDED_BY(_landing_manager_mutex)
         get_latest_landing_condition_state() {
         std::lock_guard<std::mutex> lock(_landing_manager_mutex);
@@ -96,22 +105,65 @@ class LandingManager : public rclcpp::Node, public ObstacleAvoidanceModule, Modu
 
     landing_mapper::eLandingMapperState RCPPUTILS_TSA_GUARDED_BY(_landing_manager_mutex)
         get_landing_condition_state_at_position(float x, float y) {
+        // Optionally, windows that already fail the plane fit thresholds are rejected from the snapshot, without
+        // blocking the mapper. Off by default, the mapper decides until the agreement of both has been measured.
+        if (_landing_state_snapshot_precheck) {
+            const HeightMapChannel::Frame snapshot = _height_map_channel.latest();
+            if (snapshot.data != nullptr && snapshot.data->failsWindowThresholds(Eigen::Vector2f(x, y))) {
+                return landing_mapper::eLandingMapperState::CAN_NOT_LAND;
+            }
+        }
+
         std::lock_guard<std::mutex> lock_manager(_landing_manager_mutex);
         std::lock_guard<std::mutex> lock_map(_map_mutex);
         return _mapper->computeLandingStateAtPositionXY(x, y);
     }
 
+    /**
+     * @brief Landing states of a batch of candidate positions, evaluated against one map snapshot under a single
+     * lock acquisition. The spiral search cannot use it yet, the LandingPlanner only takes a per-position callback.
+     */
+    std::vector<landing_mapper::eLandingMapperState> RCPPUTILS_TSA_GUARDED_BY(_landing_manager_mutex)
+        get_landing_condition_states_at_positions(const std::vector<Eigen::Vector2f>& positions);
+
+    height_map::HeightMapStats get_height_stats_at_position(float x, float y) const {
+        const HeightMapChannel::Frame snapshot = _height_map_channel.latest();
+        if (snapshot.data == nullptr) {
+            return HeightMapIntegral<float>::statsFromMoments({}, 0, 1.f);
+        }
+        return snapshot.data->windowStats(Eigen::Vector2f(x, y));
+    }
+
+    /**
+     * @brief Latest immutable height map snapshot and its version, the sequence number of the map update. The data is
+     * null until the mapper published its first update, also after the mapper was rebuilt.
+     */
+    HeightMapChannel::Frame get_height_map_snapshot() const { return _height_map_channel.latest(); }
+
     float RCPPUTILS_TSA_GUARDED_BY(_landing_manager_mutex) get_latest_height_above_obstacle() {
         std::lock_guard<std::mutex> lock(_landing_manager_mutex);
         return _height_above_obstacle;
     }
 
-    void getDownsampledDepthDataCallback(std::function<std::shared_ptr<ExtendedDownsampledImageF>()> callback) {
-        _downsampled_depth_update_callback = callback;
+    void setDepthFrameChannel(std::shared_ptr<const DepthFrameChannel> channel) {
+        _depth_frame_channel = std::move(channel);
+    }
+
+    /**
+     * @brief Demand for depth frames, kept active only while the landing map is being built
+     */
+    void setDepthFrameConsumer(std::shared_ptr<FrameDemand::Consumer> consumer) {
+        _depth_frame_consumer = std::move(consumer);
     }
 
-    void setConfigUpdateCallback(std::function<LandingManagerConfiguration()> callback) {
-        _config_update_callback = callback;
+    void setConfigChannel(std::shared_ptr<const ConfigurationChannel> channel) { _config_channel = std::move(channel); }
+
+    /**
+     * @brief Called from the mapper thread whenever the landing condition state changes
+     */
+    void setLandingStateCallback(std::function<void(landing_mapper::eLandingMapperState)> callback) {
+        std::lock_guard<std::mutex> lock(_landing_state_callback_mutex);
+        _landing_state_callback = std::move(callback);
     }
 
     bool setSearchAltitude_m(double altitude_m);
@@ -127,10 +179,22 @@ class LandingManager : public rclcpp::Node, public ObstacleAvoidanceModule, Modu
         UNHEALTHY_NULL_IMAGES_AND_OLD_TIMESTAMPS = 3
     };
 
+    enum class MapperTrigger {
+        TIMER,  // map the latest frame at a fixed interval
+        FRAME   // map every new frame as soon as it is published, limited by the max rate
+    };
+
+    enum class MapperSkipPolicy {
+        LATEST,  // frames arriving faster than the max rate are held back and the newest one is mapped
+        DROP     // frames arriving faster than the max rate are dropped, mapped frames are never delayed
+    };
+
     void initParameters();
-    void updateParameters();
-    void mapper();
-    bool healthCheck(const std::shared_ptr<ExtendedDownsampledImageF>& depth_msg);
+    bool updateParameters();
+    void mapper(const DepthFrameChannel::Frame& depth_frame);
+    void mapperLoop();
+    void countMappedFrame(uint64_t sequence);
+    bool healthCheck(const DepthFrameChannel::Frame& depth_frame);
 
     void publishHeightStats(const height_map::HeightMapStats& height_stats) const;
 
@@ -139,6 +203,7 @@ class LandingManager : public rclcpp::Node, public ObstacleAvoidanceModule, Modu
     void visualizeGroundPlane(const Eigen::Vector3f& normal, const Eigen::Vector3f& position,
                               const rclcpp::Time& timestamp);
     void visualizeMap();
+    void publishHeightMapSnapshot();
 
     void printStats();
 
@@ -147,10 +212,13 @@ class LandingManager : public rclcpp::Node, public ObstacleAvoidanceModule, Modu
     std::shared_ptr<mavsdk::System> _mavsdk_system;
     std::shared_ptr<mavsdk::ServerUtility> _server_utility;
 
-    std::function<LandingManagerConfiguration()> _config_update_callback;
+    std::shared_ptr<const ConfigurationChannel> _config_channel;
+    uint64_t _config_generation{0};
 
     std::unique_ptr<landing_mapper::LandingMapper<float>> _mapper;
     landing_mapper::LandingMapperParameter _mapper_parameter;
+    std::unique_ptr<PointCloudProjector> _projector;
+    PointCloudProjector::Parameters _projector_parameters;
     bool _visualize;
 
     LandingManagerConfiguration _landing_manager_config;
@@ -166,11 +234,34 @@ class LandingManager : public rclcpp::Node, public ObstacleAvoidanceModule, Modu
     rclcpp::TimerBase::SharedPtr _timer_mapper;
     rclcpp::TimerBase::SharedPtr _timer_map_visualizer;
 
+    MapperTrigger _mapper_trigger{MapperTrigger::TIMER};
+    MapperSkipPolicy _mapper_skip_policy{MapperSkipPolicy::LATEST};
+    double _mapper_max_rate_hz{0.0};
+    // Frames whose points are batched into one map update, 1 updates the map with every frame. A batch is merged
+    // into one point per height map cell, so larger batches lower the map update rate without adding coverage.
+    size_t _mapper_accumulate_frames{1};
+    // Merge the points of a frame per height map cell column before the mapper, always done when batching frames
+    bool _mapper_voxel_prefilter{false};
+    // Reject landing positions whose window fails the thresholds on the height map snapshot before asking the mapper
+    bool _landing_state_snapshot_precheck{false};
+    VoxelPointAccumulator::Representative _mapper_voxel_representative{VoxelPointAccumulator::Representative::MEAN};
+    std::thread _mapper_thread;
+    std::atomic<bool> _mapper_thread_stop{false};
+
     HealthStatus _health_status;
 
-    int _images_processed = 0;
-    int _points_processed = 0;
-    int _points_received = 0;
+    // Written by the mapper, which may run on its own thread, and read by the stats timer
+    std::atomic<int> _images_processed{0};
+    std::atomic<int> _points_processed{0};
+    std::atomic<int> _points_received{0};
+
+    // Depth frame accounting: coalesced frames were superseded before the mapper got to them, skipped frames were
+    // dropped by the skip policy, stale frames were received before mapping was last enabled
+    std::atomic<uint64_t> _last_mapped_sequence{0};
+    std::atomic<uint64_t> _frames_processed{0};
+    std::atomic<uint64_t> _frames_skipped{0};
+    std::atomic<uint64_t> _frames_coalesced{0};
+    std::atomic<uint64_t> _frames_stale{0};
 
     rclcpp::CallbackGroup::SharedPtr _callback_group_mapper;
     rclcpp::CallbackGroup::SharedPtr _callback_group_telemetry;
@@ -184,13 +275,33 @@ class LandingManager : public rclcpp::Node, public ObstacleAvoidanceModule, Modu
     rclcpp::Publisher<std_msgs::msg::Float32>::SharedPtr _below_plane_max_deviation_pub;
     rclcpp::Publisher<std_msgs::msg::Float32>::SharedPtr _std_dev_from_plane_pub;
 
-    std::function<std::shared_ptr<ExtendedDownsampledImageF>()> _downsampled_depth_update_callback;
+    std::shared_ptr<const DepthFrameChannel> _depth_frame_channel;
+    std::shared_ptr<FrameDemand::Consumer> _depth_frame_consumer;
 
     mutable std::mutex _landing_manager_mutex;
     mutable std::mutex _map_mutex;
 
-    std::vector<Eigen::Vector3f> _pointcloud_for_mapper;
+    PointCloudBuffer _pointcloud_for_mapper;
+
+    // Column filtered map updates: points of the frames since the last update, merged per height map cell, and the
+    // merged points handed to the mapper
+    VoxelPointAccumulator _point_accumulator;
+    PointCloudBuffer _pointcloud_batch;
+    std::atomic<uint64_t> _map_updates{0};
+    std::atomic<uint64_t> _points_accumulated{0};
+    std::atomic<uint64_t> _points_batched{0};
+
+    // Released snapshots go back to the pool, and their tables are recomputed from the first height map column that
+    // changed since they were built
+    HeightMapChannel _height_map_channel;
+    FramePool<HeightMapSnapshot> _height_map_pool;
+    // Snapshots not published because the pool or the channel had no free slot
+    std::atomic<uint64_t> _height_map_snapshots_dropped{0};
 
     landing_mapper::eLandingMapperState _state;
     float _height_above_obstacle;
+
+    std::mutex _landing_state_callback_mutex;
+    std::function<void(landing_mapper::eLandingMapperState)> _landing_state_callback;
+    landing_mapper::eLandingMapperState _notified_state{landing_mapper::eLandingMapperState::UNKNOWN};
 };
@@ -38,6 +38,8 @@
 
 #include <MapVisualizer.hpp>
 
+#include <cstring>
+
 namespace viz {
 
 MapVisualizer::MapVisualizer(rclcpp::Node* node)
@@ -46,7 +48,7 @@ MapVisualizer::MapVisualizer(rclcpp::Node* node)
       marker_map_pub_(_node->create_publisher<visualization_msgs::msg::MarkerArray>("map_marker", 1)),
       point_cloud_pub_(_node->create_publisher<sensor_msgs::msg::PointCloud2>("point_cloud", 1)) {}
 
-void MapVisualizer::prepare_point_cloud_msg(int64_t timestamp_ns, size_t width, size_t height, bool enabled) {
+void MapVisualizer::visualizePointCloud(const PointCloudBuffer& cloud, int64_t timestamp_ns, bool enabled) {
     if (!enabled) {
         return;
     }
@@ -55,29 +57,29 @@ void MapVisualizer::prepare_point_cloud_msg(int64_t timestamp_ns, size_t width,
         _cloud_ros2_msg = std::make_shared<sensor_msgs::msg::PointCloud2>();
 
         _cloud_ros2_msg->header.frame_id = NED_FRAME;
-        _cloud_ros2_msg->header.stamp = rclcpp::Time(timestamp_ns);
 
-        _cloud_ros2_msg->is_dense = false;
+        _cloud_ros2_msg->is_dense = true;
         _cloud_ros2_msg->is_bigendian = false;
-    }
-
-    _cloud_ros2_msg->height = height;
-    _cloud_ros2_msg->width = width;
-    _cloud_ros2_msg->fields.clear();
-    _cloud_ros2_msg->fields.reserve(1);
-    _cloud_ros2_msg->data.clear();
-
-    sensor_msgs::PointCloud2Modifier pcd_modifier(*_cloud_ros2_msg);
-    pcd_modifier.setPointCloud2FieldsByString(1, "xyz");
 
-    _pc_iter_x = std::make_shared<sensor_msgs::PointCloud2Iterator<float>>(*_cloud_ros2_msg, "x");
-    _pc_iter_y = std::make_shared<sensor_msgs::PointCloud2Iterator<float>>(*_cloud_ros2_msg, "y");
-    _pc_iter_z = std::make_shared<sensor_msgs::PointCloud2Iterator<float>>(*_cloud_ros2_msg, "z");
-}
+        // Same packed x/y/z layout as the point cloud buffer
+        _cloud_ros2_msg->fields.resize(3);
+        const char* field_names[] = {"x", "y", "z"};
+        for (size_t i = 0; i < 3; ++i) {
+            _cloud_ros2_msg->fields[i].name = field_names[i];
+            _cloud_ros2_msg->fields[i].offset = i * sizeof(float);
+            _cloud_ros2_msg->fields[i].datatype = sensor_msgs::msg::PointField::FLOAT32;
+            _cloud_ros2_msg->fields[i].count = 1;
+        }
+        _cloud_ros2_msg->point_step = 3 * sizeof(float);
+    }
 
-void MapVisualizer::visualizePointCloud(bool enabled) {
-    if (!enabled) {
-        return;
+    _cloud_ros2_msg->header.stamp = rclcpp::Time(timestamp_ns);
+    _cloud_ros2_msg->height = 1;
+    _cloud_ros2_msg->width = cloud.size();
+    _cloud_ros2_msg->row_step = cloud.size_bytes();
+    _cloud_ros2_msg->data.resize(cloud.size_bytes());
+    if (!cloud.empty()) {
+        std::memcpy(_cloud_ros2_msg->data.data(), cloud.data(), cloud.size_bytes());
     }
 
     point_cloud_pub_->publish(*_cloud_ros2_msg);
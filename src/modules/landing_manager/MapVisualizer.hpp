@@ -41,6 +41,8 @@
 #include <common.h>
 
 #include <Eigen/Core>
+#include <HeightMapIntegral.hpp>
+#include <PointCloudBuffer.hpp>
 #include <landing_mapper/HeightMap.hpp>
 
 // ROS dependencies
@@ -48,7 +50,7 @@
 #include <rclcpp/rclcpp.hpp>
 #include <sensor_msgs/msg/image.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
-#include <sensor_msgs/point_cloud2_iterator.hpp>
+#include <sensor_msgs/msg/point_field.hpp>
 #include <visualization_msgs/msg/marker.hpp>
 #include <visualization_msgs/msg/marker_array.hpp>
 
@@ -85,17 +87,13 @@ class MapVisualizer {
                        bool enabled) const;
 
     template <typename T>
-    void visualizeHeightMap(const height_map::HeightMap<T>& height_map, const rclcpp::Time& timestamp, bool enabled);
+    void visualizeHeightMap(const HeightMapIntegral<T>& height_map, const rclcpp::Time& timestamp, bool enabled);
 
     template <class Derived>
     void visualizeGroundPlane(const Eigen::MatrixBase<Derived>& normal, const Eigen::MatrixBase<Derived>& position,
                               const rclcpp::Time& timestamp, float size, bool enabled) const;
 
-    void prepare_point_cloud_msg(int64_t timestamp_ns, size_t width, size_t height, bool enabled = true);
-
-    template <typename T>
-    void add_point_to_point_cloud(const Eigen::Matrix<T, 3, 1>& point, bool enabled = true);
-    void visualizePointCloud(bool enabled = true);
+    void visualizePointCloud(const PointCloudBuffer& cloud, int64_t timestamp_ns, bool enabled = true);
 
     void publishVehicle(double safety_radius, const rclcpp::Time& timestamp, bool enabled = true);
 
@@ -111,9 +109,6 @@ class MapVisualizer {
     rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr point_cloud_pub_;
 
     sensor_msgs::msg::PointCloud2::SharedPtr _cloud_ros2_msg;
-    std::shared_ptr<sensor_msgs::PointCloud2Iterator<float>> _pc_iter_x;
-    std::shared_ptr<sensor_msgs::PointCloud2Iterator<float>> _pc_iter_y;
-    std::shared_ptr<sensor_msgs::PointCloud2Iterator<float>> _pc_iter_z;
 
     std::tuple<float, float, float> HSVtoRGB(std::tuple<float, float, float> hsv);
     int path_length_ = 0;
@@ -185,7 +180,7 @@ void MapVisualizer::publishGround(const Eigen::MatrixBase<Derived>& point, const
 }
 
 template <typename T>
-void MapVisualizer::visualizeHeightMap(const height_map::HeightMap<T>& height_map, const rclcpp::Time& timestamp,
+void MapVisualizer::visualizeHeightMap(const HeightMapIntegral<T>& height_map, const rclcpp::Time& timestamp,
                                        bool enabled) {
     if (!enabled) {
         return;
@@ -202,7 +197,7 @@ void MapVisualizer::visualizeHeightMap(const height_map::HeightMap<T>& height_ma
     map_marker.action = visualization_msgs::msg::Marker::DELETE;
     marker_array.markers.push_back(map_marker);
 
-    const double cell_size = height_map.getBinEdgeWidth();
+    const double cell_size = height_map.cellSize();
     map_marker.header.frame_id = NED_FRAME;
     map_marker.header.stamp = timestamp;
     map_marker.ns = "height_map";
@@ -221,8 +216,8 @@ void MapVisualizer::visualizeHeightMap(const height_map::HeightMap<T>& height_ma
     map_marker.color.g = 0.0;
     map_marker.color.b = 0.0;
 
-    const Eigen::Matrix<T, 2, 1> map_centre = height_map.getCentrePosition();
-    const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> heights = height_map.heights();
+    const Eigen::Matrix<T, 2, 1>& map_centre = height_map.centre();
+    const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& heights = height_map.heights();
     const int map_size_x = heights.rows();
     const int map_size_y = heights.cols();
 
@@ -297,18 +292,4 @@ void MapVisualizer::visualizeGroundPlane(const Eigen::MatrixBase<Derived>& norma
     marker_map_pub_->publish(marker_array);
 }
 
-template <typename T>
-void MapVisualizer::add_point_to_point_cloud(const Eigen::Matrix<T, 3, 1>& point, bool enabled) {
-    if (!enabled) {
-        return;
-    }
-
-    **_pc_iter_x = static_cast<float>(point.x());
-    **_pc_iter_y = static_cast<float>(point.y());
-    **_pc_iter_z = static_cast<float>(point.z());
-    ++(*_pc_iter_x);
-    ++(*_pc_iter_y);
-    ++(*_pc_iter_z);
-}
-
 }  // namespace viz
@@ -0,0 +1,78 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Reusable point cloud buffer shared by the projection, the mapper and the visualizer
+ * @file PointCloudBuffer.hpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#pragma once
+
+#include <Eigen/Core>
+#include <vector>
+
+/**
+ * Points are stored as packed x/y/z float triplets, which is both the layout LandingMapper::updateCloud() consumes and
+ * the payload of a PointCloud2 message with a 12 byte point step. The buffer can therefore be handed to the mapper
+ * without conversion and copied into a ROS message in one go. Clearing keeps the capacity, so after the first frames
+ * filling the buffer does not allocate.
+ */
+class PointCloudBuffer {
+   public:
+    static_assert(sizeof(Eigen::Vector3f) == 3 * sizeof(float), "Eigen::Vector3f must be packed");
+
+    void clear() { _points.clear(); }
+    void reserve(size_t capacity) { _points.reserve(capacity); }
+    void push_back(const Eigen::Vector3f& point) { _points.push_back(point); }
+    void append(const PointCloudBuffer& other) {
+        _points.insert(_points.end(), other._points.begin(), other._points.end());
+    }
+
+    size_t size() const { return _points.size(); }
+    bool empty() const { return _points.empty(); }
+
+    /**
+     * @brief Packed x/y/z floats of all points, size() * 3 values
+     */
+    const float* data() const { return _points.empty() ? nullptr : _points.front().data(); }
+    size_t size_bytes() const { return _points.size() * sizeof(Eigen::Vector3f); }
+
+    /**
+     * @brief Points as expected by LandingMapper::updateCloud()
+     */
+    const std::vector<Eigen::Vector3f>& points() const { return _points; }
+
+   private:
+    std::vector<Eigen::Vector3f> _points;
+};
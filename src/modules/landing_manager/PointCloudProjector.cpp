@@ -0,0 +1,115 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Depth image to point cloud projection for the landing mapper
+ * @file PointCloudProjector.cpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#include <PointCloudProjector.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+float PointCloudProjector::project(const DepthPixelArrayF& depth_pixel_array, const RayTable& ray_table,
+                                   const Eigen::Vector3f& position, const Eigen::Quaternionf& orientation,
+                                   PointCloudBuffer& cloud) {
+    const Eigen::Matrix3f rotation = orientation.toRotationMatrix();
+    const size_t pixels = depth_pixel_array.size();
+
+    // At most one point per pixel, so the cloud never grows while projecting
+    cloud.clear();
+    cloud.reserve(pixels);
+    float point_height_min = std::numeric_limits<float>::max();
+
+    if (_parameters.grain_size == 0 || pixels <= _parameters.grain_size) {
+        projectRange(depth_pixel_array, 0, pixels, ray_table, position, rotation, cloud, point_height_min);
+        return point_height_min;
+    }
+
+    const size_t grain_size = _parameters.grain_size;
+    const size_t chunk_count = (pixels + grain_size - 1) / grain_size;
+    if (_chunks.size() < chunk_count) {
+        _chunks.resize(chunk_count);
+    }
+
+    // Chunk boundaries only depend on the grain size, so every chunk produces the same points whichever thread runs it
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, chunk_count), [&](const tbb::blocked_range<size_t>& range) {
+        for (size_t i = range.begin(); i != range.end(); ++i) {
+            Chunk& chunk = _chunks[i];
+            chunk.cloud.clear();
+            chunk.cloud.reserve(grain_size);
+            chunk.point_height_min = std::numeric_limits<float>::max();
+            projectRange(depth_pixel_array, i * grain_size, std::min(pixels, (i + 1) * grain_size), ray_table, position,
+                         rotation, chunk.cloud, chunk.point_height_min);
+        }
+    });
+
+    for (size_t i = 0; i < chunk_count; ++i) {
+        const Chunk& chunk = _chunks[i];
+        cloud.append(chunk.cloud);
+        point_height_min = std::min(point_height_min, chunk.point_height_min);
+    }
+
+    return point_height_min;
+}
+
+void PointCloudProjector::projectRange(const DepthPixelArrayF& depth_pixel_array, size_t begin, size_t end,
+                                       const RayTable& ray_table, const Eigen::Vector3f& position,
+                                       const Eigen::Matrix3f& rotation, PointCloudBuffer& cloud,
+                                       float& point_height_min) const {
+    for (size_t i = begin; i < end; ++i) {
+        const DepthPixelF& depth_pixel = depth_pixel_array[i];
+        const float depth = depth_pixel.depth;
+        const uint32_t x = static_cast<uint32_t>(depth_pixel.x);
+        const uint32_t y = static_cast<uint32_t>(depth_pixel.y);
+
+        if (std::isfinite(depth) && (depth > _parameters.min_depth_m) && ray_table.contains(x, y)) {
+            const Eigen::Vector3f point = rotation * ray_table.point(x, y, depth) + position;
+
+            if (depth < _parameters.max_depth_m) {
+                cloud.push_back(point);
+            }
+
+            const float point_height = point(2) - position(2);
+            if (point_height < point_height_min) {
+                point_height_min = point_height;
+            }
+        }
+    }
+}
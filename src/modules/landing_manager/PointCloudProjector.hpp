@@ -0,0 +1,89 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Depth image to point cloud projection for the landing mapper
+ * @file PointCloudProjector.hpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#pragma once
+
+#include <common.h>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <PointCloudBuffer.hpp>
+#include <vector>
+
+/**
+ * Back-projects downsampled depth pixels into world frame points and finds the lowest point below the vehicle. The
+ * camera rays come from the precomputed ray table, so each pixel only costs a scale by its depth and the rigid
+ * transform into the world frame.
+ *
+ * The pixels are split into fixed chunks of grain_size pixels which are projected in parallel into per-chunk buffers
+ * and concatenated in chunk order. The output is therefore identical to the serial projection, independent of how
+ * the chunks are scheduled. A grain size of 0 selects the serial path.
+ */
+class PointCloudProjector {
+   public:
+    struct Parameters {
+        float min_depth_m{0.7f};  // pixels closer than this are ignored
+        float max_depth_m{16.f};  // pixels further away only contribute to the minimum height
+        size_t grain_size{2048};  // pixels per parallel chunk, 0 to project serially
+    };
+
+    explicit PointCloudProjector(const Parameters& parameters) : _parameters(parameters) {}
+
+    /**
+     * @brief Project the pixels, replacing the content of the cloud
+     * @return the minimum height of any valid point relative to the vehicle position, or float max if there is none
+     */
+    float project(const DepthPixelArrayF& depth_pixel_array, const RayTable& ray_table, const Eigen::Vector3f& position,
+                  const Eigen::Quaternionf& orientation, PointCloudBuffer& cloud);
+
+   private:
+    struct Chunk {
+        PointCloudBuffer cloud;
+        float point_height_min;
+    };
+
+    void projectRange(const DepthPixelArrayF& depth_pixel_array, size_t begin, size_t end, const RayTable& ray_table,
+                      const Eigen::Vector3f& position, const Eigen::Matrix3f& rotation, PointCloudBuffer& cloud,
+                      float& point_height_min) const;
+
+    Parameters _parameters;
+
+    // Kept between frames so that the chunk buffers keep their capacity
+    std::vector<Chunk> _chunks;
+};
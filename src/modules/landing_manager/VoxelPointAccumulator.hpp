@@ -0,0 +1,229 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Voxel grid filter accumulating projected points of one or more frames, one point per voxel
+ * @file VoxelPointAccumulator.hpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#pragma once
+
+#include <Eigen/Core>
+#include <PointCloudBuffer.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * Collects the points of one or more consecutive frames so the landing mapper can be updated with all of them at once.
+ * Points falling into the same voxel are merged into one representative, so neither dense frames nor overlapping frames
+ * multiply the binning work of the mapper. Voxels are vertical columns with the footprint of a height map cell, since
+ * the map only keeps one height per cell anyway, and depth noise on flat ground does not split them. Each voxel keeps
+ * the centroid and the minimum and maximum z of its points, the representative takes the centroid x/y and the z
+ * selected by the caller. Points are expected in a fixed world frame. The columns are aligned to the grid set with
+ * setGridOrigin(), so that each of them falls into exactly one height map cell.
+ *
+ * Voxels are looked up in an open addressing hash table that is invalidated by bumping a generation counter, so
+ * clearing is O(1) and keeps the allocated voxels and buckets. Steady state accumulation does not allocate.
+ */
+class VoxelPointAccumulator {
+   public:
+    // Height of the representative point of a voxel. In NED, MIN_Z is the highest point and MAX_Z the lowest.
+    enum class Representative { MEAN, MIN_Z, MAX_Z };
+
+    explicit VoxelPointAccumulator(float voxel_size_m = 0.1f) { setVoxelSize(voxel_size_m); }
+
+    /**
+     * @brief Change the voxel edge length, drops the accumulated points
+     */
+    void setVoxelSize(float voxel_size_m) {
+        _inverse_voxel_size = 1.f / voxel_size_m;
+        clear();
+    }
+
+    /**
+     * @brief Align the columns to a grid with a cell corner at origin. Takes effect with the next batch, so the columns
+     * of a batch are never split between two grids.
+     */
+    void setGridOrigin(const Eigen::Vector2f& origin) { _next_origin = origin; }
+
+    /**
+     * @brief Align the columns to the cells of a landing mapper height map, see setGridOrigin()
+     */
+    template <typename HeightMap>
+    void alignToHeightMap(const HeightMap& height_map) {
+        // The map is centred on its centre position, cell (0, 0) starts half the map extent before it
+        const Eigen::Vector2f extent(height_map.heights().rows(), height_map.heights().cols());
+        setGridOrigin(height_map.getCentrePosition() - extent * (0.5f * height_map.getBinEdgeWidth()));
+    }
+
+    /**
+     * @brief Add the points of one frame
+     */
+    void add(const std::vector<Eigen::Vector3f>& points) {
+        if (_frames == 0) {
+            _origin = _next_origin;
+        }
+
+        // Neighbouring pixels mostly fall into the same voxel, those skip the hash table lookup
+        uint64_t last_key = 0;
+        uint32_t last_voxel = kNoVoxel;
+        for (const Eigen::Vector3f& point : points) {
+            const uint64_t voxel_key = key(point);
+            if (last_voxel == kNoVoxel || voxel_key != last_key) {
+                last_key = voxel_key;
+                last_voxel = findOrInsert(voxel_key);
+            }
+
+            Voxel& voxel = _voxels[last_voxel];
+            voxel.sum += point;
+            voxel.count++;
+            voxel.min_z = std::min(voxel.min_z, point.z());
+            voxel.max_z = std::max(voxel.max_z, point.z());
+        }
+        _points_in += points.size();
+        _frames++;
+    }
+
+    /**
+     * @brief Write one representative point per occupied voxel and start a new batch
+     */
+    void flush(PointCloudBuffer& out, Representative representative = Representative::MEAN) {
+        out.clear();
+        out.reserve(_voxels.size());
+        for (const Voxel& voxel : _voxels) {
+            Eigen::Vector3f point = voxel.sum / static_cast<float>(voxel.count);
+            if (representative == Representative::MIN_Z) {
+                point.z() = voxel.min_z;
+            } else if (representative == Representative::MAX_Z) {
+                point.z() = voxel.max_z;
+            }
+            out.push_back(point);
+        }
+        clear();
+    }
+
+    void clear() {
+        if (++_generation == 0) {
+            // Generation counter wrapped around, stale buckets could look valid again
+            std::fill(_buckets.begin(), _buckets.end(), Bucket{});
+            _generation = 1;
+        }
+        _voxels.clear();
+        _points_in = 0;
+        _frames = 0;
+    }
+
+    size_t frames() const { return _frames; }
+    size_t pointsIn() const { return _points_in; }
+    size_t voxels() const { return _voxels.size(); }
+
+   private:
+    static constexpr uint32_t kNoVoxel = UINT32_MAX;
+
+    struct Voxel {
+        uint64_t key;
+        Eigen::Vector3f sum;
+        uint32_t count;
+        float min_z;
+        float max_z;
+    };
+
+    // A bucket is occupied if its generation is the current one
+    struct Bucket {
+        uint64_t key{0};
+        uint32_t generation{0};
+        uint32_t voxel{0};
+    };
+
+    uint32_t findOrInsert(uint64_t voxel_key) {
+        // Keep the load factor at or below one half
+        if (2 * (_voxels.size() + 1) > _buckets.size()) {
+            rehash(std::max<size_t>(2 * _buckets.size(), 4096));
+        }
+
+        size_t index = hash(voxel_key);
+        while (_buckets[index].generation == _generation) {
+            if (_buckets[index].key == voxel_key) {
+                return _buckets[index].voxel;
+            }
+            index = (index + 1) & (_buckets.size() - 1);
+        }
+
+        const auto voxel = static_cast<uint32_t>(_voxels.size());
+        _buckets[index] = Bucket{voxel_key, _generation, voxel};
+        _voxels.push_back(Voxel{voxel_key, Eigen::Vector3f::Zero(), 0, std::numeric_limits<float>::max(),
+                                std::numeric_limits<float>::lowest()});
+        return voxel;
+    }
+
+    void rehash(size_t buckets) {
+        _buckets.assign(buckets, Bucket{});
+        _hash_shift = 64 - static_cast<int>(std::log2(buckets));
+        _generation = 1;
+        for (uint32_t i = 0; i < _voxels.size(); ++i) {
+            size_t index = hash(_voxels[i].key);
+            while (_buckets[index].generation == _generation) {
+                index = (index + 1) & (_buckets.size() - 1);
+            }
+            _buckets[index] = Bucket{_voxels[i].key, _generation, i};
+        }
+    }
+
+    // Fibonacci hashing, the top bits of the product index the power of two table
+    size_t hash(uint64_t voxel_key) const { return (voxel_key * 0x9E3779B97F4A7C15ULL) >> _hash_shift; }
+
+    // Column of the point, x and y cell indices in the low and high 32 bits
+    uint64_t key(const Eigen::Vector3f& point) const {
+        const auto index = [this](float coordinate, float origin) {
+            // Truncation rounds towards zero, step down for negative fractions
+            const float scaled = (coordinate - origin) * _inverse_voxel_size;
+            const auto truncated = static_cast<int32_t>(scaled);
+            return static_cast<uint32_t>(truncated - (static_cast<float>(truncated) > scaled));
+        };
+        return index(point.x(), _origin.x()) | (static_cast<uint64_t>(index(point.y(), _origin.y())) << 32);
+    }
+
+    float _inverse_voxel_size{10.f};
+    Eigen::Vector2f _origin{Eigen::Vector2f::Zero()};
+    Eigen::Vector2f _next_origin{Eigen::Vector2f::Zero()};
+    std::vector<Bucket> _buckets;
+    int _hash_shift{64};
+    uint32_t _generation{1};
+    std::vector<Voxel> _voxels;
+    size_t _points_in{0};
+    size_t _frames{0};
+};
@@ -0,0 +1,265 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Benchmark of the landing window statistics: summed-area tables against a full window scan, and the snapshot
+ * precheck against the landing mapper window evaluation
+ * @file HeightMapIntegralBenchmark.cpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#include <HeightMapIntegral.hpp>
+#include <HeightMapSnapshot.hpp>
+#include <chrono>
+#include <cstdio>
+#include <landing_mapper/LandingMapper.hpp>
+#include <random>
+
+#include "SyntheticGround.hpp"
+
+using Integral = HeightMapIntegral<float>;
+
+namespace {
+
+constexpr int map_cells = 160;
+constexpr float cell_size = 0.1f;
+constexpr int queries = 2000;
+
+// Reference path: accumulate the moments of every cell in the window
+height_map::HeightMapStats scanWindow(const Integral::Heights& heights, const Eigen::Vector2i& centre, int half_window,
+                                      float reference_height) {
+    Integral::Moments moments;
+    for (int c = std::max(0, centre.y() - half_window); c < std::min<int>(heights.cols(), centre.y() + half_window);
+         ++c) {
+        for (int r = std::max(0, centre.x() - half_window); r < std::min<int>(heights.rows(), centre.x() + half_window);
+             ++r) {
+            if (Integral::isValid(heights(r, c))) {
+                moments.add(r, c, heights(r, c) - reference_height);
+            }
+        }
+    }
+    return Integral::statsFromMoments(moments, 4 * half_window * half_window, cell_size);
+}
+
+void benchmarkTables() {
+    using Clock = std::chrono::steady_clock;
+
+    // Tilted, noisy ground with some unobserved cells
+    std::mt19937 generator(42);
+    std::normal_distribution<float> noise(0.f, 0.05f);
+    std::uniform_int_distribution<int> cell(0, map_cells - 1);
+    Integral::Heights heights(map_cells, map_cells);
+    for (int c = 0; c < map_cells; ++c) {
+        for (int r = 0; r < map_cells; ++r) {
+            heights(r, c) = -20.f + 0.05f * r * cell_size - 0.1f * c * cell_size + noise(generator);
+        }
+    }
+    for (int i = 0; i < map_cells * map_cells / 10; ++i) {
+        heights(cell(generator), cell(generator)) = std::numeric_limits<float>::max();
+    }
+
+    Integral integral;
+    const Clock::time_point build_start = Clock::now();
+    integral.update(heights, Integral::Position::Zero(), cell_size);
+    const double build_us = std::chrono::duration<double, std::micro>(Clock::now() - build_start).count();
+    std::printf("Map %dx%d cells, table build %.1f us\n\n", map_cells, map_cells, build_us);
+
+    std::vector<Integral::Position> positions(queries);
+    const float extent = map_cells * cell_size * 0.5f;
+    std::uniform_real_distribution<float> coordinate(-extent, extent);
+    for (Integral::Position& position : positions) {
+        position = Integral::Position(coordinate(generator), coordinate(generator));
+    }
+
+    // The table error only checks the summed-area lookups against summing the same moments directly. How well the
+    // plane fit matches the landing mapper is checked by benchmarkMapperAgreement().
+    std::printf("%8s %12s %12s %10s %14s\n", "window", "scan [us]", "table [us]", "speedup", "table err [m]");
+    for (const float window_size_m : {0.5f, 1.f, 2.f, 4.f, 8.f}) {
+        const int half_window = std::max(1, static_cast<int>(std::lround(window_size_m / cell_size * 0.5)));
+
+        std::vector<height_map::HeightMapStats> scanned(queries);
+        const Clock::time_point scan_start = Clock::now();
+        for (int i = 0; i < queries; ++i) {
+            scanned[i] = scanWindow(heights, integral.cellIndex(positions[i]), half_window, heights(0, 0));
+        }
+        const double scan_us = std::chrono::duration<double, std::micro>(Clock::now() - scan_start).count() / queries;
+
+        std::vector<height_map::HeightMapStats> looked_up(queries);
+        const Clock::time_point table_start = Clock::now();
+        for (int i = 0; i < queries; ++i) {
+            looked_up[i] = integral.windowStats(positions[i], window_size_m);
+        }
+        const double table_us =
+            std::chrono::duration<double, std::micro>(Clock::now() - table_start).count() / queries;
+
+        float max_difference = 0.f;
+        for (int i = 0; i < queries; ++i) {
+            if (!std::isnan(scanned[i].std_dev_from_plane_m)) {
+                max_difference = std::max(
+                    max_difference, std::abs(scanned[i].std_dev_from_plane_m - looked_up[i].std_dev_from_plane_m));
+            }
+        }
+
+        std::printf("%7.1fm %12.3f %12.3f %9.1fx %14.2e\n", window_size_m, scan_us, table_us, scan_us / table_us,
+                    max_difference);
+    }
+}
+
+/*
+ * Flies the landing mapper over the synthetic terrain and compares the snapshot statistics and precheck with the
+ * mapper's own window evaluation:
+ * - below the vehicle, the snapshot window statistics against checkLandingArea() and getHeightStats()
+ * - around the vehicle, the precheck against computeLandingStateAtPositionXY(). The precheck may only reject windows
+ *   the mapper does not accept either, a rejected CAN_LAND window is a false rejection.
+ */
+void benchmarkMapperAgreement() {
+    constexpr float altitude_m = 6.f;
+    constexpr int frames = 450;
+    constexpr int compare_every = 3;
+    constexpr int positions_per_comparison = 50;
+
+    landing_mapper::LandingMapperParameter parameter;
+    parameter.search_altitude_m = 7.5f;
+    parameter.max_search_altitude_m = 8.f;
+    parameter.window_size_m = 2.f;
+    parameter.max_window_size_m = 8.f;
+    parameter.voxel_size_m = cell_size;
+    parameter.slope_threshold_deg = 10.f;
+    parameter.below_plane_deviation_thresh_m = 0.3f;
+    parameter.above_plane_deviation_thresh_m = 0.3f;
+    parameter.std_dev_from_plane_thresh_m = 0.1f;
+    parameter.percentage_of_valid_samples_in_window = 0.7f;
+    parameter.debug_print = false;
+    landing_mapper::LandingMapper<float> mapper(parameter);
+
+    HeightMapSnapshot snapshot;
+    snapshot.window.window_size_m = parameter.window_size_m;
+    snapshot.window.slope_threshold_deg = parameter.slope_threshold_deg;
+    snapshot.window.std_dev_from_plane_thresh_m = parameter.std_dev_from_plane_thresh_m;
+    snapshot.window.percentage_of_valid_samples_in_window = parameter.percentage_of_valid_samples_in_window;
+
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> offset(-3.f, 3.f);
+
+    int windows = 0;
+    int sample_mismatches = 0;
+    int fitted_windows = 0;
+    float max_slope_difference_deg = 0.f;
+    float max_std_dev_difference_m = 0.f;
+    int vehicle_false_rejections = 0;
+    int positions = 0;
+    int position_rejections = 0;
+    int position_false_rejections = 0;
+    long rebuilt_columns = 0;
+    long map_columns = 0;
+
+    for (int i = 0; i < frames; ++i) {
+        const Eigen::Vector3f position = synthetic_ground::position(i, altitude_m);
+        const std::vector<Eigen::Vector3f> points =
+            synthetic_ground::frame(position, generator, synthetic_ground::terrain);
+        float point_height_min = std::numeric_limits<float>::max();
+        for (const Eigen::Vector3f& point : points) {
+            point_height_min = std::min(point_height_min, point.z());
+        }
+
+        mapper.updateVehiclePosition(position);
+        mapper.updateVehicleOrientation(Eigen::Quaternionf::Identity());
+        mapper.updateCloud(points);
+        mapper.setImageHeightEstimate(point_height_min);
+
+        // Snapshots are updated after every map update, as in the landing manager
+        const int first_rebuilt_column = snapshot.map.update(mapper.getHeightMap());
+        rebuilt_columns += snapshot.map.cols() - first_rebuilt_column;
+        map_columns += snapshot.map.cols();
+
+        if (i % compare_every != 0) {
+            continue;
+        }
+
+        Eigen::Vector3f ground_position;
+        const landing_mapper::eLandingMapperState state = mapper.checkLandingArea(ground_position);
+        const height_map::HeightMapStats mapper_stats = mapper.getHeightStats();
+        const height_map::HeightMapStats snapshot_stats = snapshot.windowStats(ground_position.head<2>());
+        windows++;
+        if (mapper_stats.samples != snapshot_stats.samples ||
+            mapper_stats.valid_samples != snapshot_stats.valid_samples) {
+            sample_mismatches++;
+        }
+        if (!std::isnan(mapper_stats.slope_deg) && !std::isnan(snapshot_stats.slope_deg)) {
+            fitted_windows++;
+            max_slope_difference_deg =
+                std::max(max_slope_difference_deg, std::abs(mapper_stats.slope_deg - snapshot_stats.slope_deg));
+            max_std_dev_difference_m =
+                std::max(max_std_dev_difference_m,
+                         std::abs(mapper_stats.std_dev_from_plane_m - snapshot_stats.std_dev_from_plane_m));
+        }
+        if (state == landing_mapper::eLandingMapperState::CAN_LAND &&
+            snapshot.failsWindowThresholds(ground_position.head<2>())) {
+            vehicle_false_rejections++;
+        }
+
+        for (int j = 0; j < positions_per_comparison; ++j) {
+            const Eigen::Vector2f candidate =
+                position.head<2>() + Eigen::Vector2f(offset(generator), offset(generator));
+            positions++;
+            if (snapshot.failsWindowThresholds(candidate)) {
+                position_rejections++;
+                if (mapper.computeLandingStateAtPositionXY(candidate.x(), candidate.y()) ==
+                    landing_mapper::eLandingMapperState::CAN_LAND) {
+                    position_false_rejections++;
+                }
+            }
+        }
+    }
+
+    std::printf("\nLanding mapper agreement, %d frames at %.0f m over flat ground, a 15 deg ramp and rubble\n", frames,
+                altitude_m);
+    std::printf("Windows below the vehicle     %8d\n", windows);
+    std::printf("  sample count mismatches     %8d\n", sample_mismatches);
+    std::printf("  max slope difference [deg]  %8.3f (%d windows with a plane fit)\n", max_slope_difference_deg,
+                fitted_windows);
+    std::printf("  max std dev difference [m]  %8.4f\n", max_std_dev_difference_m);
+    std::printf("  CAN_LAND rejected           %8d\n", vehicle_false_rejections);
+    std::printf("Positions around the vehicle  %8d\n", positions);
+    std::printf("  rejected by the precheck    %8d\n", position_rejections);
+    std::printf("  CAN_LAND rejected           %8d\n", position_false_rejections);
+    std::printf("Table columns rebuilt         %7.1f%% per map update\n", 100.0 * rebuilt_columns / map_columns);
+}
+
+}  // namespace
+
+int main() {
+    benchmarkTables();
+    benchmarkMapperAgreement();
+    return 0;
+}
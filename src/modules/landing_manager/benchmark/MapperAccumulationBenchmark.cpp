@@ -0,0 +1,119 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Benchmark of batched landing map updates, per-frame updates against batches of K frames merged per height
+ * map cell column
+ * @file MapperAccumulationBenchmark.cpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#include <VoxelPointAccumulator.hpp>
+#include <chrono>
+#include <cstdio>
+#include <landing_mapper/LandingMapper.hpp>
+#include <random>
+#include <vector>
+
+#include "SyntheticGround.hpp"
+
+using namespace synthetic_ground;
+
+namespace {
+
+constexpr int frames = 240;
+constexpr float voxel_size_m = 0.1f;
+
+}  // namespace
+
+int main() {
+    using Clock = std::chrono::steady_clock;
+    std::mt19937 generator(42);
+
+    std::printf("%d frames of %dx%d points at %.0f Hz, %.1f m/s, %.2f m columns\n\n", frames, image_width, image_height,
+                frame_rate_hz, speed_m_s, voxel_size_m);
+    std::printf("%9s %3s %14s %14s %14s %16s\n", "altitude", "K", "frame [us]", "update [us]", "points/update",
+                "max latency [ms]");
+
+    for (const float altitude_m : {2.f, 5.f, 10.f}) {
+        std::vector<Eigen::Vector3f> positions;
+        std::vector<std::vector<Eigen::Vector3f>> clouds;
+        for (int i = 0; i < frames; ++i) {
+            positions.push_back(position(i, altitude_m));
+            clouds.push_back(frame(positions.back(), generator));
+        }
+
+        for (const size_t accumulate_frames : {1, 2, 4, 8}) {
+            landing_mapper::LandingMapperParameter parameter;
+            parameter.voxel_size_m = voxel_size_m;
+            landing_mapper::LandingMapper<float> mapper(parameter);
+            VoxelPointAccumulator accumulator(voxel_size_m);
+            PointCloudBuffer batch;
+
+            size_t updates = 0;
+            size_t points_to_mapper = 0;
+            double update_us = 0.0;
+            const Clock::time_point start = Clock::now();
+            for (int i = 0; i < frames; ++i) {
+                mapper.updateVehiclePosition(positions[i]);
+                if (accumulate_frames == 1) {
+                    const Clock::time_point update_start = Clock::now();
+                    mapper.updateCloud(clouds[i]);
+                    update_us += std::chrono::duration<double, std::micro>(Clock::now() - update_start).count();
+                    points_to_mapper += clouds[i].size();
+                    updates++;
+                    continue;
+                }
+
+                accumulator.alignToHeightMap(mapper.getHeightMap());
+                accumulator.add(clouds[i]);
+                if (accumulator.frames() >= accumulate_frames) {
+                    accumulator.flush(batch);
+                    const Clock::time_point update_start = Clock::now();
+                    mapper.updateCloud(batch.points());
+                    update_us += std::chrono::duration<double, std::micro>(Clock::now() - update_start).count();
+                    points_to_mapper += batch.size();
+                    updates++;
+                }
+            }
+            const double frame_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / frames;
+
+            // The oldest frame of a batch waits for the K - 1 frames after it
+            const double max_latency_ms = (accumulate_frames - 1) * 1e3 / frame_rate_hz;
+            std::printf("%8.0fm %3zu %14.1f %14.1f %14zu %16.1f\n", altitude_m, accumulate_frames, frame_us,
+                        update_us / updates, points_to_mapper / updates, max_latency_ms);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Synthetic depth camera point clouds for the landing manager benchmarks
+ * @file SyntheticGround.hpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#pragma once
+
+#include <Eigen/Core>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace synthetic_ground {
+
+// Downsampled 848x480 depth image with the RealSense D435 depth field of view, looking down
+constexpr int image_width = 212;
+constexpr int image_height = 120;
+constexpr float horizontal_fov_rad = 87.f * M_PI / 180.f;
+constexpr float vertical_fov_rad = 58.f * M_PI / 180.f;
+constexpr float frame_rate_hz = 30.f;
+constexpr float speed_m_s = 2.f;
+
+// Vehicle position of a frame, flying north at constant altitude
+inline Eigen::Vector3f position(int frame, float altitude_m) {
+    return Eigen::Vector3f(frame * speed_m_s / frame_rate_hz, 0.f, -altitude_m);
+}
+
+// Flat ground, then a 15 degree ramp, then rubble of 0.5 m blocks up to 0.4 m high. Heights are down, in meters.
+inline float terrain(float x, float y) {
+    static const float ramp_slope = std::tan(15.f * M_PI / 180.f);
+    if (x < 10.f) {
+        return 0.f;
+    }
+    if (x < 20.f) {
+        return -(x - 10.f) * ramp_slope;
+    }
+    const uint32_t block = static_cast<uint32_t>(std::floor(x * 2.f)) * 73856093u ^
+                           static_cast<uint32_t>(std::floor(y * 2.f)) * 19349663u;
+    return -10.f * ramp_slope - 0.4f * static_cast<float>(block % 1000u) / 1000.f;
+}
+
+// Points of slightly noisy ground seen from the given position, in the NED frame. The ground height (down) at a
+// horizontal position is given by height(x, y), the rays are intersected with the z = 0 plane.
+template <typename Height>
+inline std::vector<Eigen::Vector3f> frame(const Eigen::Vector3f& position, std::mt19937& generator, Height height) {
+    std::normal_distribution<float> noise(0.f, 0.02f);
+    std::vector<Eigen::Vector3f> points;
+    points.reserve(image_width * image_height);
+    const float altitude = -position.z();
+    for (int v = 0; v < image_height; ++v) {
+        const float ray_y = std::tan(vertical_fov_rad * ((v + 0.5f) / image_height - 0.5f));
+        for (int u = 0; u < image_width; ++u) {
+            const float ray_x = std::tan(horizontal_fov_rad * ((u + 0.5f) / image_width - 0.5f));
+            const float x = position.x() + altitude * ray_y;
+            const float y = position.y() + altitude * ray_x;
+            points.emplace_back(x, y, height(x, y) + noise(generator));
+        }
+    }
+    return points;
+}
+
+// Points of flat, slightly noisy ground seen from the given position, in the NED frame
+inline std::vector<Eigen::Vector3f> frame(const Eigen::Vector3f& position, std::mt19937& generator) {
+    return frame(position, generator, [](float, float) { return 0.f; });
+}
+
+}  // namespace synthetic_ground
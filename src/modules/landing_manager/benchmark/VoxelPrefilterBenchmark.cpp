@@ -0,0 +1,231 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Benchmark of the voxel prefilter in front of the landing mapper: points and mapper time with and without it,
+ * and the landing states of the prefiltered map against the unfiltered one. Both depend on the landing_mapper the
+ * benchmark is linked against, only a run against the real one tells whether the prefilter can be enabled.
+ * @file VoxelPrefilterBenchmark.cpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#include <VoxelPointAccumulator.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <landing_mapper/LandingMapper.hpp>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "SyntheticGround.hpp"
+
+using namespace synthetic_ground;
+
+namespace {
+
+using State = landing_mapper::eLandingMapperState;
+
+constexpr int frames = 240;
+constexpr float voxel_size_m = 0.1f;
+
+landing_mapper::LandingMapperParameter mapperParameter() {
+    landing_mapper::LandingMapperParameter parameter;
+    parameter.search_altitude_m = 7.5f;
+    parameter.max_search_altitude_m = 8.f;
+    parameter.window_size_m = 2.f;
+    parameter.max_window_size_m = 8.f;
+    parameter.voxel_size_m = voxel_size_m;
+    parameter.slope_threshold_deg = 10.f;
+    parameter.below_plane_deviation_thresh_m = 0.3f;
+    parameter.above_plane_deviation_thresh_m = 0.3f;
+    parameter.std_dev_from_plane_thresh_m = 0.1f;
+    parameter.percentage_of_valid_samples_in_window = 0.7f;
+    parameter.debug_print = false;
+    return parameter;
+}
+
+// Lowest point of a frame relative to the vehicle, as the projector reports it
+float pointHeightMin(const std::vector<Eigen::Vector3f>& points, const Eigen::Vector3f& position) {
+    float point_height_min = std::numeric_limits<float>::max();
+    for (const Eigen::Vector3f& point : points) {
+        point_height_min = std::min(point_height_min, point.z() - position.z());
+    }
+    return point_height_min;
+}
+
+/*
+ * Points per frame and time per frame over flat ground. The mapper times only mean something against the landing_mapper
+ * library, a negative gain means the prefilter costs more than the mapper saves.
+ */
+void benchmarkThroughput() {
+    using Clock = std::chrono::steady_clock;
+    std::mt19937 generator(42);
+
+    std::printf("%d frames of %dx%d points, %.2f m columns, times per frame\n\n", frames, image_width, image_height,
+                voxel_size_m);
+    std::printf("%9s %11s %11s %15s %16s %15s %11s\n", "altitude", "points in", "points out", "prefilter [us]",
+                "mapper off [us]", "mapper on [us]", "gain [us]");
+
+    for (const float altitude_m : {2.f, 5.f, 10.f}) {
+        landing_mapper::LandingMapper<float> unfiltered_mapper(mapperParameter());
+        landing_mapper::LandingMapper<float> filtered_mapper(mapperParameter());
+        VoxelPointAccumulator prefilter(voxel_size_m);
+        PointCloudBuffer filtered;
+
+        size_t points_in = 0;
+        size_t points_out = 0;
+        double prefilter_us = 0.0;
+        double unfiltered_us = 0.0;
+        double filtered_us = 0.0;
+        for (int i = 0; i < frames; ++i) {
+            const Eigen::Vector3f vehicle_position = position(i, altitude_m);
+            const std::vector<Eigen::Vector3f> cloud = frame(vehicle_position, generator);
+            unfiltered_mapper.updateVehiclePosition(vehicle_position);
+            filtered_mapper.updateVehiclePosition(vehicle_position);
+
+            const Clock::time_point unfiltered_start = Clock::now();
+            unfiltered_mapper.updateCloud(cloud);
+            unfiltered_us += std::chrono::duration<double, std::micro>(Clock::now() - unfiltered_start).count();
+
+            const Clock::time_point prefilter_start = Clock::now();
+            prefilter.alignToHeightMap(filtered_mapper.getHeightMap());
+            prefilter.add(cloud);
+            prefilter.flush(filtered);
+            const Clock::time_point filtered_start = Clock::now();
+            filtered_mapper.updateCloud(filtered.points());
+            const Clock::time_point filtered_end = Clock::now();
+            prefilter_us += std::chrono::duration<double, std::micro>(filtered_start - prefilter_start).count();
+            filtered_us += std::chrono::duration<double, std::micro>(filtered_end - filtered_start).count();
+
+            points_in += cloud.size();
+            points_out += filtered.size();
+        }
+
+        std::printf("%8.0fm %11zu %11zu %15.1f %16.1f %15.1f %11.1f\n", altitude_m, points_in / frames,
+                    points_out / frames, prefilter_us / frames, unfiltered_us / frames, filtered_us / frames,
+                    (unfiltered_us - prefilter_us - filtered_us) / frames);
+    }
+}
+
+/*
+ * Flies one mapper with and one without the prefilter over flat ground, a 15 degree ramp and rubble, and compares
+ * their landing states below the vehicle (checkLandingArea()) and around it (computeLandingStateAtPositionXY()). A
+ * CAN_LAND of the prefiltered map where the unfiltered one does not accept the window is unsafe.
+ */
+void benchmarkLandingStateAgreement() {
+    constexpr float altitude_m = 6.f;
+    constexpr int agreement_frames = 450;
+    constexpr int compare_every = 3;
+    constexpr int positions_per_comparison = 50;
+
+    std::printf("\nLanding state agreement, %d frames at %.0f m over flat ground, a 15 deg ramp and rubble\n",
+                agreement_frames, altitude_m);
+    std::printf("%14s %9s %11s %8s %11s %11s %8s\n", "representative", "windows", "mismatches", "unsafe",
+                "positions", "mismatches", "unsafe");
+
+    const std::pair<const char*, VoxelPointAccumulator::Representative> representatives[] = {
+        {"mean", VoxelPointAccumulator::Representative::MEAN},
+        {"min_z", VoxelPointAccumulator::Representative::MIN_Z},
+        {"max_z", VoxelPointAccumulator::Representative::MAX_Z}};
+
+    for (const auto& [name, representative] : representatives) {
+        // Same points and candidates for every representative
+        std::mt19937 generator(7);
+        std::uniform_real_distribution<float> offset(-3.f, 3.f);
+
+        landing_mapper::LandingMapper<float> unfiltered_mapper(mapperParameter());
+        landing_mapper::LandingMapper<float> filtered_mapper(mapperParameter());
+        VoxelPointAccumulator prefilter(voxel_size_m);
+        PointCloudBuffer filtered;
+
+        int windows = 0;
+        int window_mismatches = 0;
+        int window_unsafe = 0;
+        int positions = 0;
+        int position_mismatches = 0;
+        int position_unsafe = 0;
+
+        for (int i = 0; i < agreement_frames; ++i) {
+            const Eigen::Vector3f vehicle_position = position(i, altitude_m);
+            const std::vector<Eigen::Vector3f> cloud = frame(vehicle_position, generator, terrain);
+            const float point_height_min = pointHeightMin(cloud, vehicle_position);
+
+            for (landing_mapper::LandingMapper<float>* mapper : {&unfiltered_mapper, &filtered_mapper}) {
+                mapper->updateVehiclePosition(vehicle_position);
+                mapper->updateVehicleOrientation(Eigen::Quaternionf::Identity());
+            }
+            unfiltered_mapper.updateCloud(cloud);
+            prefilter.alignToHeightMap(filtered_mapper.getHeightMap());
+            prefilter.add(cloud);
+            prefilter.flush(filtered, representative);
+            filtered_mapper.updateCloud(filtered.points());
+            unfiltered_mapper.setImageHeightEstimate(point_height_min);
+            filtered_mapper.setImageHeightEstimate(point_height_min);
+
+            if (i % compare_every != 0) {
+                continue;
+            }
+
+            Eigen::Vector3f ground_position;
+            const State unfiltered_state = unfiltered_mapper.checkLandingArea(ground_position);
+            const State filtered_state = filtered_mapper.checkLandingArea(ground_position);
+            windows++;
+            window_mismatches += filtered_state != unfiltered_state;
+            window_unsafe += filtered_state == State::CAN_LAND && unfiltered_state != State::CAN_LAND;
+
+            for (int j = 0; j < positions_per_comparison; ++j) {
+                const Eigen::Vector2f candidate =
+                    vehicle_position.head<2>() + Eigen::Vector2f(offset(generator), offset(generator));
+                const State unfiltered =
+                    unfiltered_mapper.computeLandingStateAtPositionXY(candidate.x(), candidate.y());
+                const State filtered = filtered_mapper.computeLandingStateAtPositionXY(candidate.x(), candidate.y());
+                positions++;
+                position_mismatches += filtered != unfiltered;
+                position_unsafe += filtered == State::CAN_LAND && unfiltered != State::CAN_LAND;
+            }
+        }
+
+        std::printf("%14s %9d %11d %8d %11d %11d %8d\n", name, windows, window_mismatches, window_unsafe, positions,
+                    position_mismatches, position_unsafe);
+    }
+}
+
+}  // namespace
+
+int main() {
+    benchmarkThroughput();
+    benchmarkLandingStateAgreement();
+    return 0;
+}
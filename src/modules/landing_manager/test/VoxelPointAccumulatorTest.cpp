@@ -0,0 +1,205 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Tests of the voxel grid filter in front of the landing mapper
+ * @file VoxelPointAccumulatorTest.cpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#include <gtest/gtest.h>
+
+#include <VoxelPointAccumulator.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+using Representative = VoxelPointAccumulator::Representative;
+
+// Stand-in for the landing mapper height map, only what alignToHeightMap() reads
+struct TestHeightMap {
+    Eigen::MatrixXf heights_matrix;
+    Eigen::Vector2f centre;
+    float bin_width;
+
+    const Eigen::MatrixXf& heights() const { return heights_matrix; }
+    Eigen::Vector2f getCentrePosition() const { return centre; }
+    float getBinEdgeWidth() const { return bin_width; }
+};
+
+std::vector<Eigen::Vector3f> sortedByXY(const PointCloudBuffer& cloud) {
+    std::vector<Eigen::Vector3f> points = cloud.points();
+    std::sort(points.begin(), points.end(), [](const Eigen::Vector3f& a, const Eigen::Vector3f& b) {
+        return a.x() < b.x() || (a.x() == b.x() && a.y() < b.y());
+    });
+    return points;
+}
+
+size_t columnsOf(VoxelPointAccumulator& accumulator, const std::vector<Eigen::Vector3f>& points) {
+    accumulator.add(points);
+    PointCloudBuffer out;
+    accumulator.flush(out);
+    return out.size();
+}
+
+}  // namespace
+
+TEST(VoxelPointAccumulatorTest, MergesEachColumnIntoOneRepresentative) {
+    const std::vector<Eigen::Vector3f> points{
+        {0.1f, 0.1f, -1.f}, {0.4f, 0.2f, -3.f}, {0.2f, 0.4f, -2.f}, {0.7f, 0.1f, -5.f}};
+    VoxelPointAccumulator accumulator(0.5f);
+    PointCloudBuffer out;
+
+    accumulator.add(points);
+    accumulator.flush(out, Representative::MEAN);
+    std::vector<Eigen::Vector3f> merged = sortedByXY(out);
+    ASSERT_EQ(merged.size(), 2U);
+    EXPECT_TRUE(merged[0].isApprox(Eigen::Vector3f(0.7f / 3.f, 0.7f / 3.f, -2.f)));
+    EXPECT_TRUE(merged[1].isApprox(points[3]));
+
+    // NED, the minimum z is the highest point of the column
+    accumulator.add(points);
+    accumulator.flush(out, Representative::MIN_Z);
+    merged = sortedByXY(out);
+    ASSERT_EQ(merged.size(), 2U);
+    EXPECT_FLOAT_EQ(merged[0].x(), 0.7f / 3.f);
+    EXPECT_FLOAT_EQ(merged[0].z(), -3.f);
+
+    accumulator.add(points);
+    accumulator.flush(out, Representative::MAX_Z);
+    merged = sortedByXY(out);
+    ASSERT_EQ(merged.size(), 2U);
+    EXPECT_FLOAT_EQ(merged[0].z(), -1.f);
+    EXPECT_FLOAT_EQ(merged[1].z(), -5.f);
+}
+
+TEST(VoxelPointAccumulatorTest, MergesColumnsAcrossFramesOfABatch) {
+    VoxelPointAccumulator accumulator(0.5f);
+    accumulator.add({{0.1f, 0.1f, -1.f}, {1.1f, 0.1f, -1.f}});
+    accumulator.add({{0.2f, 0.2f, -3.f}, {2.1f, 0.1f, -1.f}});
+
+    EXPECT_EQ(accumulator.frames(), 2U);
+    EXPECT_EQ(accumulator.pointsIn(), 4U);
+    EXPECT_EQ(accumulator.voxels(), 3U);
+
+    PointCloudBuffer out;
+    accumulator.flush(out);
+    EXPECT_EQ(out.size(), 3U);
+    EXPECT_FLOAT_EQ(sortedByXY(out)[0].z(), -2.f);
+
+    // Flushing starts a new batch
+    EXPECT_EQ(accumulator.frames(), 0U);
+    EXPECT_EQ(accumulator.pointsIn(), 0U);
+    EXPECT_EQ(accumulator.voxels(), 0U);
+}
+
+TEST(VoxelPointAccumulatorTest, ClearDropsTheBatch) {
+    VoxelPointAccumulator accumulator(0.5f);
+    accumulator.add({{0.1f, 0.1f, -1.f}, {1.1f, 0.1f, -1.f}});
+    accumulator.clear();
+    EXPECT_EQ(accumulator.frames(), 0U);
+    EXPECT_EQ(accumulator.voxels(), 0U);
+
+    accumulator.add({{0.2f, 0.2f, -3.f}});
+    PointCloudBuffer out;
+    accumulator.flush(out);
+    ASSERT_EQ(out.size(), 1U);
+    EXPECT_TRUE(out.points()[0].isApprox(Eigen::Vector3f(0.2f, 0.2f, -3.f)));
+}
+
+TEST(VoxelPointAccumulatorTest, NegativeCoordinatesRoundDown) {
+    VoxelPointAccumulator accumulator(0.5f);
+
+    // Truncation would put both sides of zero into the same column
+    EXPECT_EQ(columnsOf(accumulator, {{-0.1f, 0.1f, 0.f}, {0.1f, 0.1f, 0.f}}), 2U);
+    EXPECT_EQ(columnsOf(accumulator, {{0.1f, -0.1f, 0.f}, {0.1f, 0.1f, 0.f}}), 2U);
+    EXPECT_EQ(columnsOf(accumulator, {{-0.1f, -0.1f, 0.f}, {-0.4f, -0.4f, 0.f}}), 1U);
+    EXPECT_EQ(columnsOf(accumulator, {{-0.4f, -0.1f, 0.f}, {-0.6f, -0.1f, 0.f}}), 2U);
+}
+
+TEST(VoxelPointAccumulatorTest, GridOriginTakesEffectWithTheNextBatch) {
+    VoxelPointAccumulator accumulator(1.f);
+    PointCloudBuffer out;
+
+    accumulator.add({{0.25f, 0.f, 0.f}});
+    accumulator.setGridOrigin(Eigen::Vector2f(0.5f, 0.f));
+    // Still on the grid the batch started with
+    accumulator.add({{0.75f, 0.f, 0.f}});
+    accumulator.flush(out);
+    EXPECT_EQ(out.size(), 1U);
+
+    EXPECT_EQ(columnsOf(accumulator, {{0.25f, 0.f, 0.f}, {0.75f, 0.f, 0.f}}), 2U);
+    EXPECT_EQ(columnsOf(accumulator, {{0.75f, 0.f, 0.f}, {1.25f, 0.f, 0.f}}), 1U);
+}
+
+TEST(VoxelPointAccumulatorTest, ColumnsMatchTheHeightMapCells) {
+    TestHeightMap height_map{Eigen::MatrixXf::Zero(4, 6), Eigen::Vector2f(10.25f, 10.5f), 0.5f};
+    VoxelPointAccumulator accumulator(height_map.bin_width);
+
+    // Unaligned, the columns split the cell starting at (9.25, 9)
+    EXPECT_EQ(columnsOf(accumulator, {{9.3f, 9.1f, 0.f}, {9.7f, 9.1f, 0.f}}), 2U);
+
+    accumulator.alignToHeightMap(height_map);
+    EXPECT_EQ(columnsOf(accumulator, {{9.3f, 9.1f, 0.f}, {9.7f, 9.1f, 0.f}}), 1U);
+    EXPECT_EQ(columnsOf(accumulator, {{9.3f, 9.1f, 0.f}, {9.3f, 9.4f, 0.f}}), 1U);
+    EXPECT_EQ(columnsOf(accumulator, {{9.7f, 9.1f, 0.f}, {9.8f, 9.1f, 0.f}}), 2U);
+    EXPECT_EQ(columnsOf(accumulator, {{9.3f, 9.4f, 0.f}, {9.3f, 9.6f, 0.f}}), 2U);
+}
+
+TEST(VoxelPointAccumulatorTest, TableGrowsWithTheNumberOfColumns) {
+    constexpr int kSide = 120;
+    std::vector<Eigen::Vector3f> points;
+    for (int x = 0; x < kSide; ++x) {
+        for (int y = 0; y < kSide; ++y) {
+            points.emplace_back(x + 0.25f, y + 0.25f, -1.f);
+            points.emplace_back(x + 0.75f, y + 0.75f, -3.f);
+        }
+    }
+
+    VoxelPointAccumulator accumulator(1.f);
+    PointCloudBuffer out;
+    for (int batch = 0; batch < 2; ++batch) {
+        accumulator.add(points);
+        EXPECT_EQ(accumulator.voxels(), static_cast<size_t>(kSide * kSide));
+        accumulator.flush(out);
+        ASSERT_EQ(out.size(), static_cast<size_t>(kSide * kSide));
+
+        const std::vector<Eigen::Vector3f> merged = sortedByXY(out);
+        for (size_t i = 0; i < merged.size(); ++i) {
+            const Eigen::Vector3f expected(static_cast<float>(i / kSide) + 0.5f, static_cast<float>(i % kSide) + 0.5f,
+                                           -2.f);
+            ASSERT_TRUE(merged[i].isApprox(expected)) << "column " << i;
+        }
+    }
+}
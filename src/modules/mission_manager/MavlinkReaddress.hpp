@@ -0,0 +1,85 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Forwarding of MAVLink messages under the Autopilot Manager's own address
+ * @file MavlinkReaddress.hpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#pragma once
+
+#include <mavsdk/plugins/mavlink_passthrough/mavlink_passthrough.h>
+
+#include <cstdint>
+
+/**
+ * Re-address a MAVLink 2 message in place without decoding it. The header IDs and the sequence number are replaced and
+ * the checksum is recomputed, the payload is forwarded as received. The sequence number is taken from the channel
+ * status, as for the messages encoded with the mavlink_msg_*_encode() functions, so the forwarded messages are counted
+ * on our link rather than on the sender's. Signatures are dropped, as they would not match the new header.
+ *
+ * Returns false and leaves the message untouched if it is not a MAVLink 2 message, as the checksum of a MAVLink 1
+ * message covers a different header. Those have to be decoded and encoded again.
+ */
+inline bool readdress_mavlink_message(mavlink_message_t& message, uint8_t system_id, uint8_t component_id,
+                                      uint8_t crc_extra, mavlink_channel_t channel = MAVLINK_COMM_0) {
+    if (message.magic != MAVLINK_STX) {
+        return false;
+    }
+
+    mavlink_status_t* status = mavlink_get_channel_status(channel);
+    message.incompat_flags &= ~MAVLINK_IFLAG_SIGNED;
+    message.seq = status->current_tx_seq;
+    status->current_tx_seq = static_cast<uint8_t>(status->current_tx_seq + 1);
+    message.sysid = system_id;
+    message.compid = component_id;
+
+    const uint8_t header[MAVLINK_CORE_HEADER_LEN] = {message.len,
+                                                     message.incompat_flags,
+                                                     message.compat_flags,
+                                                     message.seq,
+                                                     message.sysid,
+                                                     message.compid,
+                                                     static_cast<uint8_t>(message.msgid & 0xFF),
+                                                     static_cast<uint8_t>((message.msgid >> 8) & 0xFF),
+                                                     static_cast<uint8_t>((message.msgid >> 16) & 0xFF)};
+    uint16_t checksum = crc_calculate(header, MAVLINK_CORE_HEADER_LEN);
+    crc_accumulate_buffer(&checksum, _MAV_PAYLOAD(&message), message.len);
+    crc_accumulate(crc_extra, &checksum);
+
+    message.checksum = checksum;
+    mavlink_ck_a(&message) = static_cast<uint8_t>(checksum & 0xFF);
+    mavlink_ck_b(&message) = static_cast<uint8_t>(checksum >> 8);
+    return true;
+}
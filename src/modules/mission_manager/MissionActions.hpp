@@ -0,0 +1,107 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Decision maker inputs and actions of the Mission Manager
+ * @file MissionActions.hpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+/**
+ * Configuration strings are parsed into these enums once, when a configuration is set, so the decision loop only
+ * dispatches on small integers. An empty string parses to NONE, any other unknown string is rejected.
+ */
+enum class DecisionMakerInputType : uint8_t { NONE = 0, SAFE_LANDING, SIMPLE_COLLISION_AVOIDANCE, COUNT };
+
+enum class MissionAction : uint8_t {
+    NONE = 0,
+    HOLD,
+    RTL,
+    LAND,
+    MOVE_XYZ_WRT_CURRENT,
+    MOVE_LLA_WRT_CURRENT,
+    GO_TO_WAYPOINT_XYZ,
+    GO_TO_WAYPOINT,
+    LANDING_SITE_SEARCH,
+    SCRIPT_CALL,
+    API_CALL,
+    COUNT
+};
+
+static constexpr std::array<const char*, static_cast<size_t>(DecisionMakerInputType::COUNT)> kDecisionMakerInputNames{
+    "", "SAFE_LANDING", "SIMPLE_COLLISION_AVOIDANCE"};
+
+static constexpr std::array<const char*, static_cast<size_t>(MissionAction::COUNT)> kMissionActionNames{
+    "",
+    "HOLD",
+    "RTL",
+    "LAND",
+    "MOVE_XYZ_WRT_CURRENT",
+    "MOVE_LLA_WRT_CURRENT",
+    "GO_TO_WAYPOINT_XYZ",
+    "GO_TO_WAYPOINT",
+    "LANDING_SITE_SEARCH",
+    "SCRIPT_CALL",
+    "API_CALL"};
+
+template <typename Enum, size_t N>
+inline std::optional<Enum> parseEnumName(const std::array<const char*, N>& names, const std::string& name) {
+    for (size_t i = 0; i < N; ++i) {
+        if (name == names[i]) {
+            return static_cast<Enum>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+inline std::optional<DecisionMakerInputType> parseDecisionMakerInputType(const std::string& name) {
+    return parseEnumName<DecisionMakerInputType>(kDecisionMakerInputNames, name);
+}
+
+inline std::optional<MissionAction> parseMissionAction(const std::string& name) {
+    return parseEnumName<MissionAction>(kMissionActionNames, name);
+}
+
+inline const char* toString(DecisionMakerInputType input) {
+    return kDecisionMakerInputNames[static_cast<size_t>(input)];
+}
+
+inline const char* toString(MissionAction action) { return kMissionActionNames[static_cast<size_t>(action)]; }
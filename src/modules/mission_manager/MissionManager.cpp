@@ -37,18 +37,31 @@
  * @author Nuno Marques <nuno@auterion.com>
  */
 
+#include <MavlinkReaddress.hpp>
 #include <MissionManager.hpp>
+#include <algorithm>
 #include <atomic>
+#include <cstring>
 #include <future>
 #include <iostream>
+#include <limits>
 #include <string>
 #include <utility>
 
+#include <pthread.h>
+#include <sched.h>
+
 using namespace std::placeholders;
 using namespace std::chrono_literals;
 
 static constexpr auto decision_maker_run_interval = 50ms;
+// Fallback period on the ground, events still wake up the decision maker immediately
+static constexpr auto decision_maker_idle_interval = 1s;
 static constexpr auto gps_origin_update_interval = 1s;
+// Trajectory messages waiting for the trajectory thread, older ones are dropped since PX4 only needs the latest
+static constexpr size_t trajectory_queue_size = 4;
+// Obstacle avoidance counts as enabled in PX4 while trajectory messages arrive at most this far apart
+static constexpr double trajectory_timeout_s = 0.5;
 
 static std::atomic<bool> int_signal{false};
 
@@ -57,7 +70,7 @@ using LandingMapperState = landing_mapper::eLandingMapperState;
 MissionManager::MissionManager(std::shared_ptr<mavsdk::System> mavsdk_system,
                                const std::string& path_to_custom_action_file)
     : Node("mission_manager"),
-      _config_update_callback([]() { return MissionManagerConfiguration{}; }),
+      _config_channel(std::make_shared<ConfigurationChannel>()),
       _path_to_custom_action_file{std::move(path_to_custom_action_file)},
       _mission_manager_config{},
       _mavsdk_system{std::move(mavsdk_system)},
@@ -67,9 +80,6 @@ MissionManager::MissionManager(std::shared_ptr<mavsdk::System> mavsdk_system,
       _landing_crawl_speed{0.3},
       _landing_crawl_altitude{1.0},
       _is_stationary_debounce_counter{0},
-      _current_latitude{0.0},
-      _current_longitude{0.0},
-      _current_altitude_amsl{0.0},
       _new_latitude{NAN},
       _new_longitude{NAN},
       _new_altitude_amsl{NAN},
@@ -96,24 +106,52 @@ void MissionManager::init() {
     // Parameter interface
     _param = std::make_shared<mavsdk::Param>(_mavsdk_system);
 
-    // Telemetry data checks are fundamental for proper execution
-    _telemetry = std::make_shared<mavsdk::Telemetry>(_mavsdk_system);
+    // Telemetry data checks are fundamental for proper execution. The plugins are shared through the hub.
+    if (_telemetry_hub == nullptr) {
+        _telemetry_hub = std::make_shared<TelemetryHub>(_mavsdk_system);
+    }
+    _telemetry = _telemetry_hub->telemetry();
 
     // Bring up a ServerUtility instance to allow sending status messages
     _server_utility = std::make_shared<mavsdk::ServerUtility>(_mavsdk_system);
 
-    _mavlink_passthrough = std::make_shared<mavsdk::MavlinkPassthrough>(_mavsdk_system);
+    _mavlink_passthrough = _telemetry_hub->mavlink_passthrough();
 
     _custom_action_handler =
         std::make_shared<CustomActionHandler>(_mavsdk_system, _telemetry, _path_to_custom_action_file);
+
+    // Time to collision along the camera axis that triggers the collision avoidance action, 0 to disable
+    this->declare_parameter("collision_ttc_threshold_s");
+    this->get_parameter_or("collision_ttc_threshold_s", _collision_ttc_threshold_s, 0.0);
+
+    // SCHED_FIFO priority of the trajectory thread, 0 keeps the default scheduling
+    this->declare_parameter("trajectory_thread_priority");
+    this->get_parameter_or("trajectory_thread_priority", _trajectory_thread_priority, 0);
 }
 
 void MissionManager::deinit() {
-    int_signal.store(true, std::memory_order_relaxed);
+    {
+        // Set under the mutexes the threads wait on, so a thread cannot miss the notification between checking the
+        // flag and going to sleep. The trajectory thread waits without a timeout.
+        std::scoped_lock lock(_decision_maker_mutex, _trajectory_mutex);
+        int_signal.store(true, std::memory_order_relaxed);
+    }
+    _decision_maker_wakeup.notify_all();
+    _trajectory_wakeup.notify_all();
 
     _decision_maker_th.join();
+    if (_trajectory_th.joinable()) {
+        _trajectory_th.join();
+    }
     _global_origin_reference_th.join();
     _custom_action_handler.reset();
+
+    // The hub is shared and outlives this module, its listeners must not call into us anymore
+    _trajectory_listener.remove();
+    for (TelemetryHub::ListenerHandle& listener : _telemetry_listeners) {
+        listener.remove();
+    }
+    _telemetry_listeners.clear();
 }
 
 void MissionManager::run() {
@@ -128,18 +166,81 @@ void MissionManager::run() {
         _custom_action_handler->run();
     }
 
-    _mavlink_passthrough->subscribe_message_async(MAVLINK_MSG_ID_TRAJECTORY_REPRESENTATION_WAYPOINTS,
-                                                  std::bind(&MissionManager::on_mavlink_trajectory_message, this, _1));
+    // Trajectory messages are handled on their own thread, the MAVSDK callback only queues them
+    _trajectory_th = std::thread(&MissionManager::trajectory_run, this);
+    _trajectory_listener =
+        _telemetry_hub->addMavlinkMessageListener(MAVLINK_MSG_ID_TRAJECTORY_REPRESENTATION_WAYPOINTS,
+                                                  std::bind(&MissionManager::push_trajectory_message, this, _1));
 
     rclcpp::spin(shared_from_this());
 }
 
-void MissionManager::on_mavlink_trajectory_message(const mavlink_message_t& _message) {
-    if (_message.compid == MAV_COMP_ID_OBSTACLE_AVOIDANCE) {
+void MissionManager::push_trajectory_message(const mavlink_message_t& message) {
+    if (message.compid == MAV_COMP_ID_OBSTACLE_AVOIDANCE) {
         return;
     }
 
-    _time_last_traj = this->now();
+    {
+        std::lock_guard<std::mutex> lock(_trajectory_mutex);
+        if (_trajectory_queue.size() >= trajectory_queue_size) {
+            _trajectory_queue.pop_front();
+            ++_trajectory_dropped;
+        }
+        _trajectory_queue.push_back({message, std::chrono::steady_clock::now()});
+    }
+    _trajectory_wakeup.notify_one();
+}
+
+void MissionManager::trajectory_run() {
+    // PX4 takes the trajectory replies as the obstacle avoidance heartbeat, keep them ahead of the other threads
+    if (_trajectory_thread_priority > 0) {
+        sched_param param{};
+        param.sched_priority = std::clamp(_trajectory_thread_priority, sched_get_priority_min(SCHED_FIFO),
+                                          sched_get_priority_max(SCHED_FIFO));
+        const int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (result != 0) {
+            std::cout << missionManagerOut << "Could not set the trajectory thread priority to "
+                      << param.sched_priority << " (" << std::strerror(result) << "), running with default priority"
+                      << std::endl;
+        }
+    }
+
+    while (!int_signal.load(std::memory_order_relaxed)) {
+        std::unique_lock<std::mutex> lock(_trajectory_mutex);
+        _trajectory_wakeup.wait(
+            lock, [this] { return !_trajectory_queue.empty() || int_signal.load(std::memory_order_relaxed); });
+        if (_trajectory_queue.empty()) {
+            continue;
+        }
+        const TrajectoryMessage trajectory = _trajectory_queue.front();
+        _trajectory_queue.pop_front();
+        lock.unlock();
+
+        on_mavlink_trajectory_message(trajectory.message);
+        _trajectory_latency.record(std::chrono::steady_clock::now() - trajectory.ingress_time);
+    }
+}
+
+void MissionManager::printTrajectoryLatency(std::ostream& os) {
+    uint64_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(_trajectory_mutex);
+        std::swap(dropped, _trajectory_dropped);
+    }
+    _trajectory_latency.print(os);
+    os << "dropped " << dropped << std::endl;
+}
+
+void MissionManager::on_mavlink_trajectory_message(const mavlink_message_t& _message) {
+
+    // The first trajectory message after a pause enables obstacle avoidance, let the decision maker pick it up right
+    // away. Only the start of the stream wakes it, not every message.
+    const rclcpp::Time now = this->now();
+    const bool trajectory_resumed = (now - _time_last_traj).seconds() >= trajectory_timeout_s;
+    _time_last_traj = now;
+    if (trajectory_resumed) {
+        wake_decision_maker();
+    }
 
     const bool is_pos_valid = std::isfinite(_new_x) && std::isfinite(_new_y) && std::isfinite(_new_yaw);
     const bool is_valid = _landing_planner.isActive() && is_pos_valid;
@@ -182,7 +283,8 @@ void MissionManager::on_mavlink_trajectory_message(const mavlink_message_t& _mes
             const float vel_scale = _mission_manager_config.landing_site_search_speed;
             lock.unlock();
 
-            Eigen::Vector2f vel_new(_current_pos_x - _new_x, _current_pos_y - _new_y);
+            const VehicleState vehicle = _vehicle_state->load();
+            Eigen::Vector2f vel_new(vehicle.x_m - _new_x, vehicle.y_m - _new_y);
             vel_new = vel_new.normalized() * vel_scale;
 
             static Eigen::Vector2f vel(vel_new);
@@ -202,10 +304,10 @@ void MissionManager::on_mavlink_trajectory_message(const mavlink_message_t& _mes
             wp_message.vel_z[0] = NAN;
 
             if (DEBUG_PRINT) {
-                const float d_x = abs(_current_pos_x - _new_x);
-                const float d_y = abs(_current_pos_y - _new_y);
+                const float d_x = abs(vehicle.x_m - _new_x);
+                const float d_y = abs(vehicle.y_m - _new_y);
                 std::stringstream ss;
-                ss << "[OA] " << std::fixed << std::setprecision(3) << "[" << _current_pos_x << ", " << _current_pos_y
+                ss << "[OA] " << std::fixed << std::setprecision(3) << "[" << vehicle.x_m << ", " << vehicle.y_m
                    << "] >>->> [" << _new_x << ", " << _new_y << "]  d_x=" << d_x << " d_y" << d_y;
                 std::cout << ss.str() << std::endl;
             }
@@ -217,13 +319,16 @@ void MissionManager::on_mavlink_trajectory_message(const mavlink_message_t& _mes
         _mavlink_passthrough->send_message(corrected_traj_message);
     } else {
         // The Landing Planner is not active and an alternative wayppoint has not been set.
-        // Send the trajectory message back with no change.
-        mavlink_trajectory_representation_waypoints_t wp_message;
-        mavlink_msg_trajectory_representation_waypoints_decode(&_message, &wp_message);
-
-        mavlink_message_t forwarded_traj_message;
-        mavlink_msg_trajectory_representation_waypoints_encode(1, MAV_COMP_ID_OBSTACLE_AVOIDANCE,
-                                                               &forwarded_traj_message, &wp_message);
+        // Send the trajectory message back with no change, only re-addressed to the obstacle avoidance component.
+        mavlink_message_t forwarded_traj_message = _message;
+        if (!readdress_mavlink_message(forwarded_traj_message, 1, MAV_COMP_ID_OBSTACLE_AVOIDANCE,
+                                       MAVLINK_MSG_ID_TRAJECTORY_REPRESENTATION_WAYPOINTS_CRC)) {
+            // MAVLink 1 messages are decoded and encoded again
+            mavlink_trajectory_representation_waypoints_t wp_message;
+            mavlink_msg_trajectory_representation_waypoints_decode(&_message, &wp_message);
+            mavlink_msg_trajectory_representation_waypoints_encode(1, MAV_COMP_ID_OBSTACLE_AVOIDANCE,
+                                                                   &forwarded_traj_message, &wp_message);
+        }
         _mavlink_passthrough->send_message(forwarded_traj_message);
     }
     _frequency_traj.tic();
@@ -243,7 +348,7 @@ void MissionManager::on_mavlink_trajectory_message(const mavlink_message_t& _mes
 void MissionManager::update_obstacle_avoidance_status() {
     const auto ros_now = this->get_clock()->now();
     const auto s_since_last_traj = (ros_now - _time_last_traj).seconds();
-    const bool received_recent_trajectory_message = s_since_last_traj < 0.5f;
+    const bool received_recent_trajectory_message = s_since_last_traj < trajectory_timeout_s;
 
     if (is_obstacle_avoidance_enabled() == received_recent_trajectory_message) {
         // No change in OA-enabled status
@@ -251,11 +356,17 @@ void MissionManager::update_obstacle_avoidance_status() {
     }
 
     set_obstacle_avoidance_enabled(received_recent_trajectory_message);
+
+    std::lock_guard<std::mutex> lock(_obstacle_avoidance_status_callback_mutex);
+    if (_obstacle_avoidance_status_callback) {
+        _obstacle_avoidance_status_callback(received_recent_trajectory_message);
+    }
 }
 
 void MissionManager::flight_mode_callback(const mavsdk::Telemetry::FlightMode& flight_mode) {
     if (flight_mode != _flight_mode) {
         _flight_mode = flight_mode;
+        wake_decision_maker();
 
         // Reset safe landing on new flights or when in manual control
         const bool is_taking_off = _landed_state == mavsdk::Telemetry::LandedState::OnGround ||
@@ -347,10 +458,11 @@ void MissionManager::set_global_position_reference() {
 mavsdk::geometry::CoordinateTransformation::LocalCoordinate MissionManager::get_local_position_from_local_offset(
     const double& offset_x, const double& offset_y) const {
     // Given an offset in body-frame x and y, compute the local position
+    const VehicleState vehicle = _vehicle_state->load();
     const double local_position_x =
-        (std::cos(_current_yaw) * offset_x - std::sin(_current_yaw) * offset_y) + _current_pos_x;
+        (std::cos(vehicle.yaw_rad) * offset_x - std::sin(vehicle.yaw_rad) * offset_y) + vehicle.x_m;
     const double local_position_y =
-        (std::sin(_current_yaw) * offset_x + std::cos(_current_yaw) * offset_y) + _current_pos_y;
+        (std::sin(vehicle.yaw_rad) * offset_x + std::cos(vehicle.yaw_rad) * offset_y) + vehicle.y_m;
     return mavsdk::geometry::CoordinateTransformation::LocalCoordinate{local_position_x, local_position_y};
 }
 
@@ -374,9 +486,10 @@ void MissionManager::set_new_waypoint(const double& lat, const double& lon, cons
 }
 
 bool MissionManager::arrived_to_new_waypoint() {
-    if ((std::abs(_new_latitude - _current_latitude) <= 1.0E-5) &&
-        (std::abs(_new_longitude - _current_longitude) <= 1.0E-5) &&
-        (std::abs(_new_altitude_amsl - _current_altitude_amsl) <= 1.0)) {  // ~1 meter acceptance radius
+    const VehicleState vehicle = _vehicle_state->load();
+    if ((std::abs(_new_latitude - vehicle.latitude_deg) <= 1.0E-5) &&
+        (std::abs(_new_longitude - vehicle.longitude_deg) <= 1.0E-5) &&
+        (std::abs(_new_altitude_amsl - vehicle.altitude_amsl_m) <= 1.0)) {  // ~1 meter acceptance radius
         return true;
     }
 
@@ -392,13 +505,14 @@ void MissionManager::set_new_local_waypoint(const double& x, const double& y, co
 
 void MissionManager::go_to_new_local_waypoint(
     mavsdk::geometry::CoordinateTransformation::LocalCoordinate local_waypoint) {
-    set_new_local_waypoint(local_waypoint.north_m, local_waypoint.east_m, _current_yaw);
+    set_new_local_waypoint(local_waypoint.north_m, local_waypoint.east_m, _vehicle_state->load().yaw_rad);
 }
 
 bool MissionManager::is_stationary() {
     static const double vel_tol = 0.5;
+    const VehicleState vehicle = _vehicle_state->load();
     const double vel_mag =
-        std::sqrt(std::pow(_current_vel_x, 2) + std::pow(_current_vel_y, 2) + std::pow(_current_vel_z, 2));
+        std::sqrt(std::pow(vehicle.vx_m_s, 2) + std::pow(vehicle.vy_m_s, 2) + std::pow(vehicle.vz_m_s, 2));
     return debounce_is_stationary(vel_mag < vel_tol);
 }
 
@@ -464,12 +578,20 @@ void MissionManager::update_landing_speed_config() {
               << "m/s below " << _landing_crawl_altitude << "m)" << std::endl;
 }
 
-void MissionManager::handle_safe_landing(std::chrono::time_point<std::chrono::system_clock> now) {
+const std::array<MissionManager::DecisionHandler, static_cast<size_t>(DecisionMakerInputType::COUNT)>
+    MissionManager::kDecisionHandlers{
+        nullptr,                                             // NONE
+        &MissionManager::handle_safe_landing,                // SAFE_LANDING
+        &MissionManager::handle_simple_collision_avoidance,  // SIMPLE_COLLISION_AVOIDANCE
+    };
+
+void MissionManager::handle_safe_landing(const DecisionTick& tick) {
+    const auto now = tick.now;
     std::unique_lock<std::mutex> lock(mission_manager_config_mtx);
     const bool safe_landing_enabled = _mission_manager_config.safe_landing_enabled;
     const float safe_landing_distance_to_ground = _mission_manager_config.safe_landing_distance_to_ground;
     const bool safe_landing_try_landing_after_action = _mission_manager_config.safe_landing_try_landing_after_action;
-    const std::string safe_landing_on_no_safe_land = _mission_manager_config.safe_landing_on_no_safe_land;
+    const MissionAction safe_landing_on_no_safe_land = _mission_manager_config.safe_landing_on_no_safe_land;
     const double landing_site_search_max_distance = _mission_manager_config.landing_site_search_max_distance;
     const double landing_site_search_min_height = _mission_manager_config.landing_site_search_min_height;
     const double landing_site_search_min_distance_after_abort =
@@ -491,6 +613,8 @@ void MissionManager::handle_safe_landing(std::chrono::time_point<std::chrono::sy
     const float height_above_obstacle = _height_above_obstacle_update_callback();
 
     update_obstacle_avoidance_status();
+    // Mission manager is healthy as long as we have trajectory messages in an auto mode
+    _is_healthy = is_obstacle_avoidance_enabled() || under_manual_control();
 
     // Do nothing if Safe Landing or OA is disabled
     if (!safe_landing_enabled || !is_obstacle_avoidance_enabled()) {
@@ -540,187 +664,178 @@ void MissionManager::handle_safe_landing(std::chrono::time_point<std::chrono::sy
         } else if (should_trigger_safe_landing) {
             std::cout << std::string(missionManagerOut) << "Cannot land! ----------------------- ("
                       << safe_landing_state << ")" << std::endl;
-            if (safe_landing_on_no_safe_land == "HOLD") {
-                _action->hold();
-
-                status = std::string(missionManagerOut) + "Position hold triggered for Safe Landing";
-                _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Info, status);
-                std::cout << status << std::endl;
-
-            } else if (safe_landing_on_no_safe_land == "RTL") {
-                _action->return_to_launch();
-
-                status = std::string(missionManagerOut) + "RTL triggered for Safe Landing";
-                _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Info, status);
-                std::cout << status << std::endl;
-
-            } else if (safe_landing_on_no_safe_land == "MOVE_XYZ_WRT_CURRENT") {
-                // get the global origin from the FMU and set the reference
-                if (_global_origin_reference_set) {
-                    const auto waypoint =
-                        get_global_position_from_local_offset(local_position_offset_x, local_position_offset_y);
-                    const double waypoint_altitude = _current_altitude_amsl + local_position_offset_z;
-
-                    _action->goto_location(waypoint.latitude_deg, waypoint.longitude_deg, waypoint_altitude, NAN);
-
-                    set_new_waypoint(waypoint.latitude_deg, waypoint.longitude_deg, waypoint_altitude);
+            switch (safe_landing_on_no_safe_land) {
+                case MissionAction::HOLD: {
+                    _action->hold();
 
-                    status = std::string(missionManagerOut) +
-                             "Moving XYZ WRT to current vehicle position triggered for Safe Landing. Heading to "
-                             "determined "
-                             "Latitude " +
-                             std::to_string(waypoint.latitude_deg) + " deg, Longitude " +
-                             std::to_string(waypoint.longitude_deg) + " deg, Altitude (AMSL) " +
-                             std::to_string(waypoint_altitude) + " meters";
+                    status = std::string(missionManagerOut) + "Position hold triggered for Safe Landing";
                     _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Info, status);
+                    std::cout << status << std::endl;
+                    break;
+                }
+                case MissionAction::RTL: {
+                    _action->return_to_launch();
 
-                } else {
-                    _action->hold();
-
-                    status = std::string(missionManagerOut) + "Holding position...";
-                    _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Warning, status);
+                    status = std::string(missionManagerOut) + "RTL triggered for Safe Landing";
+                    _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Info, status);
+                    std::cout << status << std::endl;
+                    break;
                 }
+                case MissionAction::MOVE_XYZ_WRT_CURRENT: {
+                    // get the global origin from the FMU and set the reference
+                    if (_global_origin_reference_set) {
+                        const auto waypoint =
+                            get_global_position_from_local_offset(local_position_offset_x, local_position_offset_y);
+                        const double waypoint_altitude = tick.vehicle.altitude_amsl_m + local_position_offset_z;
 
-                std::cout << status << std::endl;
+                        _action->goto_location(waypoint.latitude_deg, waypoint.longitude_deg, waypoint_altitude, NAN);
 
-            } else if (safe_landing_on_no_safe_land == "LANDING_SITE_SEARCH") {
-                if (_global_origin_reference_set && is_obstacle_avoidance_enabled()) {
-                    std::cout << "*" << std::endl
-                              << "***" << std::endl
-                              << "***** Starting Landing Site Search" << std::endl
-                              << "***" << std::endl
-                              << "*" << std::endl;
+                        set_new_waypoint(waypoint.latitude_deg, waypoint.longitude_deg, waypoint_altitude);
 
-                    status = "Starting Landing Site Search";
-                    _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Warning, status);
+                        status = std::string(missionManagerOut) +
+                                 "Moving XYZ WRT to current vehicle position triggered for Safe Landing. Heading to "
+                                 "determined "
+                                 "Latitude " +
+                                 std::to_string(waypoint.latitude_deg) + " deg, Longitude " +
+                                 std::to_string(waypoint.longitude_deg) + " deg, Altitude (AMSL) " +
+                                 std::to_string(waypoint_altitude) + " meters";
+                        _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Info, status);
 
-                    // Set the landing speeds
-                    update_landing_speed_config();
-
-                    // Configure landing planner
-                    landing_planner::LandingPlannerConfig lp_config;
-                    lp_config.max_distance = landing_site_search_max_distance;
-                    lp_config.min_height = landing_site_search_min_height;
-                    lp_config.max_height = safe_landing_distance_to_ground;
-                    lp_config.min_distance_after_abort = landing_site_search_min_distance_after_abort;
-                    lp_config.waypoint_arrival_radius = landing_site_search_arrival_radius;
-                    lp_config.site_assess_time = landing_site_search_assess_time;
-                    lp_config.search_strategy = landing_site_search_strategy;
-                    lp_config.spiral_search_spacing = landing_site_search_spiral_spacing;
-                    lp_config.spiral_search_points = landing_site_search_spiral_points;
-
-                    // Start search
-                    _landing_planner.startSearch(_current_pos_x, _current_pos_y, _current_yaw, -_current_pos_z,
-                                                 lp_config);
-
-                    if (_landing_planner.isActive()) {
-                        // Set the first waypoint in the search pattern
-                        const mavsdk::geometry::CoordinateTransformation::LocalCoordinate new_wpt =
-                            _landing_planner.getCurrentWaypoint();
-                        go_to_new_local_waypoint(new_wpt);
                     } else {
-                        // Planner did not start correctly.
                         _action->hold();
-                        landing_site_search_has_ended("NSC");
 
-                        status =
-                            std::string(missionManagerOut) + "Landing planner could not start. Holding position...";
+                        status = std::string(missionManagerOut) + "Holding position...";
                         _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Warning, status);
                     }
-                } else if (!_global_origin_reference_set) {
-                    // Planner did not start correctly.
-                    _action->hold();
-                    landing_site_search_has_ended("No GO");
-
-                    status = std::string(missionManagerOut) + "Global position reference not set. Holding position...";
-                    _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Error, status);
-                } else if (!is_obstacle_avoidance_enabled()) {
-                    _action->hold();
-                    landing_site_search_has_ended("No OA");
 
-                    status = std::string(missionManagerOut) +
-                             "Landing planner could not start. No OA active in PX4. Holding position...";
-                    _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Error, status);
+                    std::cout << status << std::endl;
+                    break;
                 }
+                case MissionAction::LANDING_SITE_SEARCH: {
+                    if (_global_origin_reference_set && is_obstacle_avoidance_enabled()) {
+                        std::cout << "*" << std::endl
+                                  << "***" << std::endl
+                                  << "***** Starting Landing Site Search" << std::endl
+                                  << "***" << std::endl
+                                  << "*" << std::endl;
+
+                        status = "Starting Landing Site Search";
+                        _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Warning, status);
 
-                std::cout << status << std::endl;
-            } else if (safe_landing_on_no_safe_land == "GO_TO_WAYPOINT_XYZ") {
-                _action->hold();
-
-                status = std::string(missionManagerOut) +
-                         "GO_TO_WAYPOINT_XYZ action currently not supported for Safe Landing. Holding position...";
-                _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Warning, status);
-                std::cout << status << std::endl;
-
-            } else if (safe_landing_on_no_safe_land == "MOVE_LLA_WRT_CURRENT") {
-                _action->hold();
-
-                status = std::string(missionManagerOut) +
-                         "MOVE_LLA_WRT_CURRENT action currently not supported for Safe Landing. Holding position...";
-                _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Warning, status);
-                std::cout << status << std::endl;
-
-            } else if (safe_landing_on_no_safe_land == "GO_TO_WAYPOINT") {
-                std::string status{};
-
-                // If this action run previously, but the user didn't change the waypoint online after the
-                // action was triggered, the previous waypoint will match the current waypoint. If that's the
-                // case enfore an RTL so to avoid the vehicle getting stuck trying to land in a place it can't
-                // land
-                if ((std::abs(global_position_waypoint_lat - _current_latitude) <= 1.0E-5) &&
-                    (std::abs(global_position_waypoint_lon - _current_longitude) <= 1.0E-5) &&
-                    (std::abs(_previously_set_waypoint_altitude_amsl - _current_altitude_amsl) <= 1.0)) {
-                    _action->return_to_launch();
+                        // Set the landing speeds
+                        update_landing_speed_config();
+
+                        // Configure landing planner
+                        landing_planner::LandingPlannerConfig lp_config;
+                        lp_config.max_distance = landing_site_search_max_distance;
+                        lp_config.min_height = landing_site_search_min_height;
+                        lp_config.max_height = safe_landing_distance_to_ground;
+                        lp_config.min_distance_after_abort = landing_site_search_min_distance_after_abort;
+                        lp_config.waypoint_arrival_radius = landing_site_search_arrival_radius;
+                        lp_config.site_assess_time = landing_site_search_assess_time;
+                        lp_config.search_strategy = landing_site_search_strategy;
+                        lp_config.spiral_search_spacing = landing_site_search_spiral_spacing;
+                        lp_config.spiral_search_points = landing_site_search_spiral_points;
+
+                        // Start search
+                        _landing_planner.startSearch(tick.vehicle.x_m, tick.vehicle.y_m, tick.vehicle.yaw_rad,
+                                                     -tick.vehicle.z_m, lp_config);
+
+                        if (_landing_planner.isActive()) {
+                            // Set the first waypoint in the search pattern
+                            const mavsdk::geometry::CoordinateTransformation::LocalCoordinate new_wpt =
+                                _landing_planner.getCurrentWaypoint();
+                            go_to_new_local_waypoint(new_wpt);
+                        } else {
+                            // Planner did not start correctly.
+                            _action->hold();
+                            landing_site_search_has_ended("NSC");
+
+                            status =
+                                std::string(missionManagerOut) + "Landing planner could not start. Holding position...";
+                            _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Warning, status);
+                        }
+                    } else if (!_global_origin_reference_set) {
+                        // Planner did not start correctly.
+                        _action->hold();
+                        landing_site_search_has_ended("No GO");
 
-                    status = std::string(missionManagerOut) +
-                             "Go-To Global Position Waypoint not triggered for Safe Landing, as the waypoint set "
-                             "is the same as the "
-                             "global position of the vehicle."
-                             "RTL triggered instead...";
-                    _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Warning, status);
+                        status =
+                            std::string(missionManagerOut) + "Global position reference not set. Holding position...";
+                        _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Error, status);
+                    } else if (!is_obstacle_avoidance_enabled()) {
+                        _action->hold();
+                        landing_site_search_has_ended("No OA");
 
-                } else {
-                    // get the global origin from the FMU and set the reference
-                    if (_global_origin_reference_set) {
-                        // then send the DO_REPOSITION
-                        _action->goto_location(global_position_waypoint_lat, global_position_waypoint_lon,
-                                               global_position_waypoint_alt_amsl, NAN);
+                        status = std::string(missionManagerOut) +
+                                 "Landing planner could not start. No OA active in PX4. Holding position...";
+                        _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Error, status);
+                    }
 
-                        set_new_waypoint(global_position_waypoint_lat, global_position_waypoint_lon,
-                                         global_position_waypoint_alt_amsl);
+                    std::cout << status << std::endl;
+                    break;
+                }
+                case MissionAction::GO_TO_WAYPOINT: {
+                    std::string status{};
+
+                    // If this action run previously, but the user didn't change the waypoint online after the
+                    // action was triggered, the previous waypoint will match the current waypoint. If that's the
+                    // case enfore an RTL so to avoid the vehicle getting stuck trying to land in a place it can't
+                    // land
+                    if ((std::abs(global_position_waypoint_lat - tick.vehicle.latitude_deg) <= 1.0E-5) &&
+                        (std::abs(global_position_waypoint_lon - tick.vehicle.longitude_deg) <= 1.0E-5) &&
+                        (std::abs(_previously_set_waypoint_altitude_amsl - tick.vehicle.altitude_amsl_m) <= 1.0)) {
+                        _action->return_to_launch();
 
                         status = std::string(missionManagerOut) +
-                                 "Go-To Global Position Waypoint triggered for Safe Landing. Heading to Latitude " +
-                                 std::to_string(global_position_waypoint_lat) + " deg, Longitude " +
-                                 std::to_string(global_position_waypoint_lon) + " deg, Altitude (AMSL) " +
-                                 std::to_string(global_position_waypoint_alt_amsl) + " meters";
-                        _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Info, status);
+                                 "Go-To Global Position Waypoint not triggered for Safe Landing, as the waypoint set "
+                                 "is the same as the "
+                                 "global position of the vehicle."
+                                 "RTL triggered instead...";
+                        _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Warning, status);
 
                     } else {
-                        _action->hold();
-
-                        status = std::string(missionManagerOut) + "Holding position...";
-                        _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Warning, status);
+                        // get the global origin from the FMU and set the reference
+                        if (_global_origin_reference_set) {
+                            // then send the DO_REPOSITION
+                            _action->goto_location(global_position_waypoint_lat, global_position_waypoint_lon,
+                                                   global_position_waypoint_alt_amsl, NAN);
+
+                            set_new_waypoint(global_position_waypoint_lat, global_position_waypoint_lon,
+                                             global_position_waypoint_alt_amsl);
+
+                            status = std::string(missionManagerOut) +
+                                     "Go-To Global Position Waypoint triggered for Safe Landing. Heading to Latitude " +
+                                     std::to_string(global_position_waypoint_lat) + " deg, Longitude " +
+                                     std::to_string(global_position_waypoint_lon) + " deg, Altitude (AMSL) " +
+                                     std::to_string(global_position_waypoint_alt_amsl) + " meters";
+                            _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Info, status);
+
+                        } else {
+                            _action->hold();
+
+                            status = std::string(missionManagerOut) + "Holding position...";
+                            _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Warning, status);
+                        }
                     }
-                }
-
-                std::cout << status << std::endl;
-
-            } else if (safe_landing_on_no_safe_land == "SCRIPT_CALL") {
-                _action->hold();
-
-                status = std::string(missionManagerOut) +
-                         "SCRIPT_CALL action currently not supported for Safe Landing. Holding position...";
-                _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Warning, status);
-                std::cout << status << std::endl;
 
-            } else if (safe_landing_on_no_safe_land == "API_CALL") {
-                _action->hold();
+                    std::cout << status << std::endl;
+                    break;
+                }
+                case MissionAction::MOVE_LLA_WRT_CURRENT:
+                case MissionAction::GO_TO_WAYPOINT_XYZ:
+                case MissionAction::SCRIPT_CALL:
+                case MissionAction::API_CALL:
+                    _action->hold();
 
-                status = std::string(missionManagerOut) +
-                         "API_CALL action currently not supported for Safe Landing. Holding position...";
-                _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Warning, status);
-                std::cout << status << std::endl;
+                    status = std::string(missionManagerOut) + toString(safe_landing_on_no_safe_land) +
+                             " action currently not supported for Safe Landing. Holding position...";
+                    _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Warning, status);
+                    std::cout << status << std::endl;
+                    break;
+                default:
+                    // NONE and LAND keep the vehicle landing
+                    break;
             }
 
             _action_in_progress = true;
@@ -801,6 +916,7 @@ void MissionManager::update_landing_site_search(const landing_mapper::eLandingMa
      *  STEP 1: Decide what to do
      */
     bool should_initiate_landing = false;
+    const VehicleState vehicle = _vehicle_state->load();
     const bool busy_landing = _landing_planner.shouldLand();
     if (busy_landing) {
         if (safe_landing_state == LandingMapperState::UNHEALTHY || safe_landing_state == LandingMapperState::UNKNOWN ||
@@ -809,10 +925,10 @@ void MissionManager::update_landing_site_search(const landing_mapper::eLandingMa
             std::string status = std::string(missionManagerOut) + "Aborting landing at candidate site";
             _server_utility->send_status_text(mavsdk::ServerUtility::StatusTextType::Info, status);
             std::cout << status << std::endl;
-            _landing_planner.abortLanding(-_current_pos_z, height_above_obstacle);
+            _landing_planner.abortLanding(-vehicle.z_m, height_above_obstacle);
         }
     } else {
-        _landing_planner.updateSearch({_current_pos_x, _current_pos_y}, -_current_pos_z, height_above_obstacle,
+        _landing_planner.updateSearch({vehicle.x_m, vehicle.y_m}, -vehicle.z_m, height_above_obstacle,
                                       is_stationary(), safe_landing_state);
         if (_landing_planner.shouldLand()) {
             // Planner has approved a landing site
@@ -890,7 +1006,49 @@ void MissionManager::landing_site_search_has_ended(const std::string& _debug) {
     }
 }
 
-void MissionManager::handle_simple_collision_avoidance(std::chrono::time_point<std::chrono::system_clock> now) {
+void MissionManager::handle_obstacle_distance(float distance_m, const Eigen::Vector3f& direction_ned,
+                                              std::chrono::steady_clock::time_point frame_received) {
+    if (!std::isfinite(distance_m)) {
+        return;
+    }
+
+    // Only the velocity towards the obstacle along the camera axis closes the distance
+    const double closing_speed = _vehicle_state->load().velocity_ned().dot(direction_ned);
+    const float time_to_collision_s =
+        closing_speed > 0.1 ? static_cast<float>(distance_m / closing_speed) : std::numeric_limits<float>::infinity();
+
+    const bool distance_crossed = distance_m <= _collision_distance_threshold;
+    const bool time_to_collision_crossed =
+        _collision_ttc_threshold_s > 0.0 && time_to_collision_s <= _collision_ttc_threshold_s;
+    if (!distance_crossed && !time_to_collision_crossed) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_decision_maker_mutex);
+        _collision_event = CollisionEvent{distance_m, time_to_collision_s, frame_received};
+    }
+    _decision_maker_wakeup.notify_one();
+}
+
+void MissionManager::wake_decision_maker() {
+    {
+        std::lock_guard<std::mutex> lock(_decision_maker_mutex);
+        _decision_maker_wake_requested = true;
+    }
+    _decision_maker_wakeup.notify_one();
+}
+
+std::optional<MissionManager::CollisionEvent> MissionManager::take_collision_event() {
+    std::lock_guard<std::mutex> lock(_decision_maker_mutex);
+    std::optional<CollisionEvent> collision_event;
+    collision_event.swap(_collision_event);
+    return collision_event;
+}
+
+void MissionManager::handle_simple_collision_avoidance(const DecisionTick& tick) {
+    const auto now = tick.now;
+    const std::optional<CollisionEvent>& collision_event = tick.collision_event;
     if (_mission_manager_config.simple_collision_avoid_enabled != 0U) {
         const bool in_air = (_landed_state == mavsdk::Telemetry::LandedState::InAir);
         // std::cout << "Depth measured: " << _distance_to_obstacle_update_callback()
@@ -898,61 +1056,60 @@ void MissionManager::handle_simple_collision_avoidance(std::chrono::time_point<s
         //           << " | in air: " << in_air << " | is action triggered? " << std::boolalpha
         //           << _action_in_progress << std::endl;
 
-        if (std::isfinite(_distance_to_obstacle_update_callback()) &&
-            _distance_to_obstacle_update_callback() <=
-                _mission_manager_config.simple_collision_avoid_distance_threshold &&
-            in_air && !_action_in_progress) {  // only trigger the condition when the vehicle is in-air
-            if (_mission_manager_config.simple_collision_avoid_action_on_condition_true == "HOLD") {
-                _action->hold();
-                std::cout << std::string(missionManagerOut) << "Position hold triggered for Simple Obstacle Avoidance"
-                          << std::endl;
-            } else if (_mission_manager_config.simple_collision_avoid_action_on_condition_true == "RTL") {
-                _action->return_to_launch();
-                std::cout << std::string(missionManagerOut) << "RTL triggered for Simple Obstacle Avoidance"
-                          << std::endl;
-            } else if (_mission_manager_config.simple_collision_avoid_action_on_condition_true ==
-                       "MOVE_XYZ_WRT_CURRENT") {
-                _action->hold();
-                std::cout << std::string(missionManagerOut)
-                          << "MOVE_XYZ_WRT_CURRENT action currently not supported for Simple Obstacle Avoidance. "
-                             "Holding position..."
-                          << std::endl;
-            } else if (_mission_manager_config.simple_collision_avoid_action_on_condition_true ==
-                       "GO_TO_WAYPOINT_XYZ") {
-                _action->hold();
-                std::cout << std::string(missionManagerOut)
-                          << "GO_TO_WAYPOINT_XYZ action currently not supported for Simple Obstacle Avoidance. Holding "
-                             "position..."
-                          << std::endl;
-            } else if (_mission_manager_config.simple_collision_avoid_action_on_condition_true ==
-                       "MOVE_LLA_WRT_CURRENT") {
-                _action->hold();
-                std::cout << std::string(missionManagerOut)
-                          << "MOVE_LLA_WRT_CURRENT action currently not supported for Simple Obstacle Avoidance. "
-                             "Holding position..."
-                          << std::endl;
-            } else if (_mission_manager_config.simple_collision_avoid_action_on_condition_true == "GO_TO_WAYPOINT") {
-                _action->hold();
-                std::cout << std::string(missionManagerOut)
-                          << "GO_TO_WAYPOINT action currently not supported for Simple Obstacle Avoidance. Holding "
-                             "position..."
-                          << std::endl;
-            } else if (_mission_manager_config.simple_collision_avoid_action_on_condition_true == "LAND") {
-                _action->land();
-                std::cout << std::string(missionManagerOut) << "Land triggered for Simple Obstacle Avoidance"
-                          << std::endl;
-            } else if (_mission_manager_config.simple_collision_avoid_action_on_condition_true == "SCRIPT_CALL") {
-                _action->hold();
-                std::cout
-                    << std::string(missionManagerOut)
-                    << "SCRIPT_CALL action currently not supported for Simple Obstacle Avoidance. Holding position..."
-                    << std::endl;
-            } else if (_mission_manager_config.simple_collision_avoid_action_on_condition_true == "API_CALL") {
-                _action->hold();
-                std::cout
-                    << std::string(missionManagerOut)
-                    << "API_CALL action currently not supported for Simple Obstacle Avoidance. Holding position..."
-                    << std::endl;
+        // Threshold crossings are pushed with every frame, polling the latest distance covers the timer trigger
+        const float distance_to_obstacle = _distance_to_obstacle_update_callback();
+        const bool obstacle_ahead =
+            collision_event.has_value() ||
+            (std::isfinite(distance_to_obstacle) &&
+             distance_to_obstacle <= _mission_manager_config.simple_collision_avoid_distance_threshold);
+
+        // only trigger the condition when the vehicle is in-air
+        if (obstacle_ahead && in_air && !_action_in_progress) {
+            const MissionAction action = _mission_manager_config.simple_collision_avoid_action_on_condition_true;
+            switch (action) {
+                case MissionAction::HOLD:
+                    _action->hold();
+                    std::cout << std::string(missionManagerOut)
+                              << "Position hold triggered for Simple Obstacle Avoidance" << std::endl;
+                    break;
+                case MissionAction::RTL:
+                    _action->return_to_launch();
+                    std::cout << std::string(missionManagerOut) << "RTL triggered for Simple Obstacle Avoidance"
+                              << std::endl;
+                    break;
+                case MissionAction::LAND:
+                    _action->land();
+                    std::cout << std::string(missionManagerOut) << "Land triggered for Simple Obstacle Avoidance"
+                              << std::endl;
+                    break;
+                case MissionAction::MOVE_XYZ_WRT_CURRENT:
+                case MissionAction::MOVE_LLA_WRT_CURRENT:
+                case MissionAction::GO_TO_WAYPOINT_XYZ:
+                case MissionAction::GO_TO_WAYPOINT:
+                case MissionAction::SCRIPT_CALL:
+                case MissionAction::API_CALL:
+                    _action->hold();
+                    std::cout << std::string(missionManagerOut) << toString(action)
+                              << " action currently not supported for Simple Obstacle Avoidance. Holding position..."
+                              << std::endl;
+                    break;
+                default:
+                    // LANDING_SITE_SEARCH is only available for Safe Landing
+                    break;
+            }
+
+            if (collision_event.has_value()) {
+                const double latency_ms = std::chrono::duration<double, std::milli>(
+                                              std::chrono::steady_clock::now() - collision_event->frame_received)
+                                              .count();
+                _collision_actions++;
+                _collision_action_latency_sum_ms += latency_ms;
+                _collision_action_latency_max_ms = std::max(_collision_action_latency_max_ms, latency_ms);
+                std::cout << std::string(missionManagerOut) << "Obstacle at " << collision_event->distance_m
+                          << " m, time to collision " << collision_event->time_to_collision_s
+                          << " s. Frame to action latency: " << latency_ms << " ms (mean "
+                          << _collision_action_latency_sum_ms / _collision_actions << " ms, max "
+                          << _collision_action_latency_max_ms << " ms)" << std::endl;
             }
 
             _action_in_progress = true;
@@ -966,59 +1123,80 @@ void MissionManager::decision_maker_run() {
     _last_time = std::chrono::system_clock::now();
 
     // Get global position
-    _telemetry->subscribe_position([this](mavsdk::Telemetry::Position position) {
-        _current_latitude = position.latitude_deg;
-        _current_longitude = position.longitude_deg;
-        _current_altitude_amsl = position.absolute_altitude_m;
-    });
+    _telemetry_listeners.push_back(
+        _telemetry_hub->addPositionListener([this](const mavsdk::Telemetry::Position& position) {
+            _vehicle_state->update([&position](VehicleState& state) {
+                state.latitude_deg = position.latitude_deg;
+                state.longitude_deg = position.longitude_deg;
+                state.altitude_amsl_m = position.absolute_altitude_m;
+                state.global_position_time = VehicleState::Clock::now();
+            });
+        }));
 
     // Get global and home positions health
-    _telemetry->subscribe_health([this](mavsdk::Telemetry::Health health) {
-        _is_global_position_ok = health.is_global_position_ok;
-        _is_home_position_ok = health.is_home_position_ok;
-    });
+    _telemetry_listeners.push_back(_telemetry_hub->addHealthListener([this](const mavsdk::Telemetry::Health& health) {
+        _vehicle_state->update([&health](VehicleState& state) {
+            state.global_position_ok = health.is_global_position_ok;
+            state.home_position_ok = health.is_home_position_ok;
+            state.health_time = VehicleState::Clock::now();
+        });
+    }));
 
     // Get local position and velocity
-    _telemetry->subscribe_position_velocity_ned([this](mavsdk::Telemetry::PositionVelocityNed position_velocity) {
-        _current_pos_x = position_velocity.position.north_m;
-        _current_pos_y = position_velocity.position.east_m;
-        _current_pos_z = position_velocity.position.down_m;
-        _current_vel_x = position_velocity.velocity.north_m_s;
-        _current_vel_y = position_velocity.velocity.east_m_s;
-        _current_vel_z = position_velocity.velocity.down_m_s;
-    });
+    _telemetry_listeners.push_back(_telemetry_hub->addPositionVelocityNedListener(
+        [this](const mavsdk::Telemetry::PositionVelocityNed& position_velocity) {
+            _vehicle_state->update([&position_velocity](VehicleState& state) {
+                state.x_m = position_velocity.position.north_m;
+                state.y_m = position_velocity.position.east_m;
+                state.z_m = position_velocity.position.down_m;
+                state.vx_m_s = position_velocity.velocity.north_m_s;
+                state.vy_m_s = position_velocity.velocity.east_m_s;
+                state.vz_m_s = position_velocity.velocity.down_m_s;
+                state.local_position_time = VehicleState::Clock::now();
+            });
+        }));
 
     // Get yaw
-    _telemetry->subscribe_attitude_euler(
-        [this](mavsdk::Telemetry::EulerAngle euler_angle) { _current_yaw = euler_angle.yaw_deg * M_PI / 180.0; });
+    _telemetry_listeners.push_back(
+        _telemetry_hub->addAttitudeEulerListener([this](const mavsdk::Telemetry::EulerAngle& euler_angle) {
+            _vehicle_state->update([&euler_angle](VehicleState& state) {
+                state.yaw_rad = euler_angle.yaw_deg * M_PI / 180.0;
+                state.attitude_time = VehicleState::Clock::now();
+            });
+        }));
 
     // Get the flight mode
-    _telemetry->subscribe_flight_mode(
-        [this](mavsdk::Telemetry::FlightMode flight_mode) { flight_mode_callback(flight_mode); });
+    _telemetry_listeners.push_back(_telemetry_hub->addFlightModeListener(
+        [this](const mavsdk::Telemetry::FlightMode& flight_mode) { flight_mode_callback(flight_mode); }));
 
     // Get the landing state so we know when the vehicle is in-air, landing or on-ground
-    _telemetry->subscribe_landed_state([this](mavsdk::Telemetry::LandedState landed_state) {
-        if (landed_state != _landed_state) {
-            _previous_landed_state = _landed_state.load();
-            _landed_state = landed_state;
-        }
-    });
+    _telemetry_listeners.push_back(
+        _telemetry_hub->addLandedStateListener([this](const mavsdk::Telemetry::LandedState& landed_state) {
+            if (landed_state != _landed_state) {
+                _previous_landed_state = _landed_state.load();
+                _landed_state = landed_state;
+                wake_decision_maker();
+            }
+        }));
 
     _is_healthy = true;
 
     while (!int_signal) {
-        // Update configuration at each iteration
-        _mission_manager_config = _config_update_callback();
+        // Update the configuration when the Autopilot Manager published a new one
+        if (const auto config = _config_channel->poll(_config_generation)) {
+            std::lock_guard<std::mutex> lock(mission_manager_config_mtx);
+            _mission_manager_config = *config;
+            _collision_distance_threshold = _mission_manager_config.simple_collision_avoid_distance_threshold;
+        }
+        const DecisionTick tick{std::chrono::system_clock::now(), take_collision_event(), _vehicle_state->load()};
 
         if (_mission_manager_config.autopilot_manager_enabled) {
-            auto now = std::chrono::system_clock::now();
-
-            if (_mission_manager_config.decision_maker_input_type == "SAFE_LANDING") {
-                handle_safe_landing(now);
-                // Mission manager is healthy as long as we have trajectory messages in an auto mode
-                _is_healthy = is_obstacle_avoidance_enabled() || under_manual_control();
-            } else if (_mission_manager_config.decision_maker_input_type == "SIMPLE_COLLISION_AVOIDANCE") {
-                handle_simple_collision_avoidance(now);
+            const auto now = tick.now;
+
+            const DecisionHandler handler =
+                kDecisionHandlers[static_cast<size_t>(_mission_manager_config.decision_maker_input_type)];
+            if (handler != nullptr) {
+                (this->*handler)(tick);
             }
 
             // After an action is triggered, we give it 5 seconds to process it before retrying.
@@ -1028,7 +1206,18 @@ void MissionManager::decision_maker_run() {
                 std::cout << missionManagerOut << "5 seconds have passed since last action." << std::endl;
             }
         }
-        std::this_thread::sleep_for(decision_maker_run_interval);
+
+        // Sleep until an event arrives, or until the fallback interval elapsed. Nothing changes on the ground without
+        // an event, so the fallback is much longer there.
+        const bool idle = _landed_state == mavsdk::Telemetry::LandedState::OnGround && !_action_in_progress &&
+                          !_landing_planner.isActive();
+        const auto fallback_interval = idle ? std::chrono::milliseconds(decision_maker_idle_interval)
+                                            : std::chrono::milliseconds(decision_maker_run_interval);
+        std::unique_lock<std::mutex> lock(_decision_maker_mutex);
+        _decision_maker_wakeup.wait_for(lock, fallback_interval, [this]() {
+            return _decision_maker_wake_requested || _collision_event.has_value() || int_signal;
+        });
+        _decision_maker_wake_requested = false;
     }
 
     _is_healthy = false;
@@ -41,16 +41,27 @@
 
 #include <timing_tools/timing_tools.h>
 
+#include <ConfigChannel.hpp>
 #include <CustomActionHandler.hpp>
 #include <Eigen/Eigen>
+#include <LatencyHistogram.hpp>
+#include <MissionActions.hpp>
 #include <ModuleBase.hpp>
 #include <ObstacleAvoidanceModule.hpp>
+#include <TelemetryHub.hpp>
+#include <VehicleState.hpp>
+#include <array>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <future>
 #include <iostream>
 #include <landing_mapper/LandingMapper.hpp>
 #include <landing_planner/LandingPlanner.hpp>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <vector>
 
 // MAVSDK dependencies
 #include <mavsdk/geometry.h>
@@ -80,7 +91,7 @@ class MissionManager : public rclcpp::Node, public ObstacleAvoidanceModule, Modu
 
     struct MissionManagerConfiguration {
         uint8_t autopilot_manager_enabled = 0U;
-        std::string decision_maker_input_type = "";
+        DecisionMakerInputType decision_maker_input_type = DecisionMakerInputType::NONE;
 
         std::string script_to_call = "";
         std::string api_call = "";
@@ -104,7 +115,7 @@ class MissionManager : public rclcpp::Node, public ObstacleAvoidanceModule, Modu
 
         uint8_t safe_landing_enabled = 0U;
         double safe_landing_distance_to_ground = 0.0;
-        std::string safe_landing_on_no_safe_land = "";
+        MissionAction safe_landing_on_no_safe_land = MissionAction::NONE;
         uint8_t safe_landing_try_landing_after_action = 0U;
 
         // Landing site search config
@@ -122,13 +133,31 @@ class MissionManager : public rclcpp::Node, public ObstacleAvoidanceModule, Modu
 
         uint8_t simple_collision_avoid_enabled = 0U;
         double simple_collision_avoid_distance_threshold = 0.0;
-        std::string simple_collision_avoid_action_on_condition_true = "";
+        MissionAction simple_collision_avoid_action_on_condition_true = MissionAction::NONE;
     };
 
-    void setConfigUpdateCallback(std::function<MissionManagerConfiguration()> callback) {
-        _config_update_callback = callback;
+    using ConfigurationChannel = ConfigChannel<MissionManagerConfiguration>;
+
+    void setConfigChannel(std::shared_ptr<const ConfigurationChannel> channel) { _config_channel = std::move(channel); }
+
+    /**
+     * @brief Print the ingress-to-egress latency of the trajectory passthrough since the previous call
+     */
+    void printTrajectoryLatency(std::ostream& os);
+
+    /**
+     * @brief Called when the Mission Manager detects that obstacle avoidance got enabled or disabled in PX4
+     */
+    void setObstacleAvoidanceStatusCallback(std::function<void(bool enabled)> callback) {
+        std::lock_guard<std::mutex> lock(_obstacle_avoidance_status_callback_mutex);
+        _obstacle_avoidance_status_callback = std::move(callback);
     }
 
+    /**
+     * @brief Shared telemetry subscriptions, must be set before init(). A private hub is created otherwise.
+     */
+    void setTelemetryHub(std::shared_ptr<TelemetryHub> telemetry_hub) { _telemetry_hub = std::move(telemetry_hub); }
+
     void getDistanceToObstacleCallback(std::function<float()> callback) {
         _distance_to_obstacle_update_callback = callback;
     }
@@ -147,16 +176,62 @@ class MissionManager : public rclcpp::Node, public ObstacleAvoidanceModule, Modu
 
     bool isHealthy() const { return _is_healthy; }
 
+    /**
+     * @brief Vehicle state written by the telemetry callbacks, other modules copy consistent snapshots from it
+     */
+    std::shared_ptr<const VehicleStateLock> get_vehicle_state() const { return _vehicle_state; }
+
+    /**
+     * @brief New obstacle distance from the Collision Avoidance Manager, called for every depth frame. Wakes up the
+     * decision maker when the distance or the time to collision crosses its threshold.
+     */
+    void handle_obstacle_distance(float distance_m, const Eigen::Vector3f& direction_ned,
+                                  std::chrono::steady_clock::time_point frame_received);
+
+    /**
+     * @brief Run the decision maker now instead of at its next fallback tick. Called on flight mode, landed state,
+     * landing state and configuration changes.
+     */
+    void wake_decision_maker();
+
     void decision_maker_run();
 
    private:
-    void handle_safe_landing(std::chrono::time_point<std::chrono::system_clock> now);
-    void handle_simple_collision_avoidance(std::chrono::time_point<std::chrono::system_clock> now);
+    struct CollisionEvent {
+        float distance_m{NAN};
+        float time_to_collision_s{NAN};
+        std::chrono::steady_clock::time_point frame_received{};
+    };
+
+    /**
+     * @brief Inputs of one decision maker iteration
+     */
+    struct DecisionTick {
+        std::chrono::time_point<std::chrono::system_clock> now;
+        std::optional<CollisionEvent> collision_event;
+        VehicleState vehicle;
+    };
+
+    using DecisionHandler = void (MissionManager::*)(const DecisionTick&);
+
+    // Decision maker handlers, indexed by DecisionMakerInputType
+    static const std::array<DecisionHandler, static_cast<size_t>(DecisionMakerInputType::COUNT)> kDecisionHandlers;
+
+    void handle_safe_landing(const DecisionTick& tick);
+    void handle_simple_collision_avoidance(const DecisionTick& tick);
+    std::optional<CollisionEvent> take_collision_event();
 
     void update_landing_site_search(const landing_mapper::eLandingMapperState safe_landing_state,
                                     const float height_above_obstacle, const bool land_when_found_site);
     void landing_site_search_has_ended(const std::string& _debug = "");
 
+    struct TrajectoryMessage {
+        mavlink_message_t message;
+        std::chrono::steady_clock::time_point ingress_time;
+    };
+
+    void push_trajectory_message(const mavlink_message_t& message);
+    void trajectory_run();
     void on_mavlink_trajectory_message(const mavlink_message_t& _message);
     void update_obstacle_avoidance_status();
     void flight_mode_callback(const mavsdk::Telemetry::FlightMode& flight_mode);
@@ -184,8 +259,11 @@ class MissionManager : public rclcpp::Node, public ObstacleAvoidanceModule, Modu
     mavsdk::geometry::CoordinateTransformation::GlobalCoordinate get_global_position_from_local_offset(
         const double& offset_x, const double& offset_y) const;
 
-    std::function<MissionManagerConfiguration()> _config_update_callback;
+    std::shared_ptr<const ConfigurationChannel> _config_channel;
+    uint64_t _config_generation{0};
     std::function<float()> _distance_to_obstacle_update_callback;
+    std::mutex _obstacle_avoidance_status_callback_mutex;
+    std::function<void(bool enabled)> _obstacle_avoidance_status_callback;
     std::function<landing_mapper::eLandingMapperState()> _landing_condition_state_update_callback;
     std::function<float()> _height_above_obstacle_update_callback;
 
@@ -199,6 +277,10 @@ class MissionManager : public rclcpp::Node, public ObstacleAvoidanceModule, Modu
     std::shared_ptr<CustomActionHandler> _custom_action_handler;
     std::shared_ptr<mavsdk::Action> _action;
     std::shared_ptr<mavsdk::Param> _param;
+    std::shared_ptr<TelemetryHub> _telemetry_hub;
+    // Added by the decision maker and the trajectory forwarding on their own threads, removed in deinit()
+    std::vector<TelemetryHub::ListenerHandle> _telemetry_listeners;
+    TelemetryHub::ListenerHandle _trajectory_listener;
     std::shared_ptr<mavsdk::Telemetry> _telemetry;
     std::shared_ptr<mavsdk::ServerUtility> _server_utility;
     std::shared_ptr<mavsdk::MavlinkPassthrough> _mavlink_passthrough;
@@ -207,8 +289,6 @@ class MissionManager : public rclcpp::Node, public ObstacleAvoidanceModule, Modu
     std::atomic<mavsdk::Telemetry::FlightMode> _flight_mode{mavsdk::Telemetry::FlightMode::Unknown};
     std::atomic<mavsdk::Telemetry::LandedState> _landed_state{mavsdk::Telemetry::LandedState::Unknown};
     std::atomic<mavsdk::Telemetry::LandedState> _previous_landed_state{mavsdk::Telemetry::LandedState::Unknown};
-    std::atomic<bool> _is_global_position_ok;
-    std::atomic<bool> _is_home_position_ok;
     std::atomic<bool> _global_origin_reference_set;
 
     std::atomic<double> _landing_speed;
@@ -217,19 +297,11 @@ class MissionManager : public rclcpp::Node, public ObstacleAvoidanceModule, Modu
 
     std::atomic<int> _is_stationary_debounce_counter;
 
-    std::atomic<double> _current_latitude;
-    std::atomic<double> _current_longitude;
-    std::atomic<double> _current_altitude_amsl;
+    std::shared_ptr<VehicleStateLock> _vehicle_state{std::make_shared<VehicleStateLock>()};
+
     std::atomic<double> _ref_latitude;
     std::atomic<double> _ref_longitude;
     std::atomic<double> _ref_altitude;
-    std::atomic<double> _current_pos_x;
-    std::atomic<double> _current_pos_y;
-    std::atomic<double> _current_pos_z;
-    std::atomic<double> _current_vel_x;
-    std::atomic<double> _current_vel_y;
-    std::atomic<double> _current_vel_z;
-    std::atomic<double> _current_yaw;
     std::atomic<double> _new_latitude;
     std::atomic<double> _new_longitude;
     std::atomic<double> _new_altitude_amsl;
@@ -246,8 +318,28 @@ class MissionManager : public rclcpp::Node, public ObstacleAvoidanceModule, Modu
     std::chrono::time_point<std::chrono::system_clock> _last_time{};
 
     std::thread _decision_maker_th;
+
+    // The decision maker sleeps on the condition until an event is pushed or the fallback interval elapsed.
+    // Threshold crossings pushed by the Collision Avoidance Manager carry their own event.
+    std::mutex _decision_maker_mutex;
+    std::condition_variable _decision_maker_wakeup;
+    bool _decision_maker_wake_requested{false};
+    std::optional<CollisionEvent> _collision_event;
+    std::atomic<double> _collision_distance_threshold{0.0};
+    double _collision_ttc_threshold_s{0.0};
+    uint64_t _collision_actions{0};
+    double _collision_action_latency_sum_ms{0.0};
+    double _collision_action_latency_max_ms{0.0};
     std::thread _global_origin_reference_th;
 
+    std::thread _trajectory_th;
+    std::mutex _trajectory_mutex;
+    std::condition_variable _trajectory_wakeup;
+    std::deque<TrajectoryMessage> _trajectory_queue;
+    uint64_t _trajectory_dropped{0};
+    int _trajectory_thread_priority{0};
+    LatencyHistogram _trajectory_latency{"trajectory passthrough"};
+
     rclcpp::Time _time_last_traj;
 
     std::atomic<bool> _is_healthy;
@@ -0,0 +1,185 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Tests of the in-place MAVLink re-addressing against the c_library_v2 encoder
+ * @file MavlinkReaddressTest.cpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#include <gtest/gtest.h>
+
+#include <MavlinkReaddress.hpp>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// PX4 sends the trajectory on its own channel, we forward it on ours, the reference is encoded on a third one
+constexpr mavlink_channel_t kPx4Channel = MAVLINK_COMM_1;
+constexpr mavlink_channel_t kOurChannel = MAVLINK_COMM_2;
+constexpr mavlink_channel_t kReferenceChannel = MAVLINK_COMM_3;
+constexpr uint8_t kSystemId = 1;
+
+mavlink_trajectory_representation_waypoints_t trajectory(uint8_t valid_points) {
+    mavlink_trajectory_representation_waypoints_t waypoints{};
+    waypoints.time_usec = 123456789;
+    waypoints.valid_points = valid_points;
+    for (int i = 0; i < MAVLINK_MSG_TRAJECTORY_REPRESENTATION_WAYPOINTS_FIELD_POS_X_LEN; ++i) {
+        // Unused points are NaN, as sent by PX4
+        const bool valid = i < valid_points;
+        waypoints.pos_x[i] = valid ? 1.f + i : NAN;
+        waypoints.pos_y[i] = valid ? -2.f * i : NAN;
+        waypoints.pos_z[i] = valid ? -5.f : NAN;
+        waypoints.vel_x[i] = valid ? 0.5f : NAN;
+        waypoints.vel_y[i] = valid ? 0.f : NAN;
+        waypoints.vel_z[i] = valid ? -0.25f : NAN;
+        waypoints.acc_x[i] = NAN;
+        waypoints.acc_y[i] = NAN;
+        waypoints.acc_z[i] = NAN;
+        waypoints.pos_yaw[i] = valid ? 0.1f * i : NAN;
+        waypoints.vel_yaw[i] = NAN;
+        waypoints.command[i] = valid ? MAV_CMD_NAV_WAYPOINT : UINT16_MAX;
+    }
+    return waypoints;
+}
+
+// Trajectory as received from PX4, with PX4's own sequence number
+mavlink_message_t fromPx4(const mavlink_trajectory_representation_waypoints_t& waypoints, uint8_t sequence,
+                          bool mavlink1 = false) {
+    mavlink_status_t* status = mavlink_get_channel_status(kPx4Channel);
+    status->current_tx_seq = sequence;
+    if (mavlink1) {
+        status->flags |= MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+    } else {
+        status->flags &= ~MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+    }
+    mavlink_message_t message;
+    mavlink_msg_trajectory_representation_waypoints_encode_chan(kSystemId, MAV_COMP_ID_AUTOPILOT1, kPx4Channel,
+                                                                &message, &waypoints);
+    return message;
+}
+
+// What decoding and encoding the trajectory again under our address produces
+mavlink_message_t reencoded(const mavlink_message_t& received) {
+    mavlink_trajectory_representation_waypoints_t waypoints;
+    mavlink_msg_trajectory_representation_waypoints_decode(&received, &waypoints);
+    mavlink_message_t message;
+    mavlink_msg_trajectory_representation_waypoints_encode_chan(kSystemId, MAV_COMP_ID_OBSTACLE_AVOIDANCE,
+                                                                kReferenceChannel, &message, &waypoints);
+    return message;
+}
+
+bool readdressed(mavlink_message_t& message) {
+    return readdress_mavlink_message(message, kSystemId, MAV_COMP_ID_OBSTACLE_AVOIDANCE,
+                                     MAVLINK_MSG_ID_TRAJECTORY_REPRESENTATION_WAYPOINTS_CRC, kOurChannel);
+}
+
+std::vector<uint8_t> serialized(const mavlink_message_t& message) {
+    std::vector<uint8_t> buffer(MAVLINK_MAX_PACKET_LEN);
+    buffer.resize(mavlink_msg_to_send_buffer(buffer.data(), &message));
+    return buffer;
+}
+
+void setSequences(uint8_t sequence) {
+    mavlink_get_channel_status(kOurChannel)->current_tx_seq = sequence;
+    mavlink_get_channel_status(kReferenceChannel)->current_tx_seq = sequence;
+}
+
+}  // namespace
+
+TEST(MavlinkReaddressTest, MatchesDecodeAndEncode) {
+    for (uint8_t valid_points = 0; valid_points <= MAVLINK_MSG_TRAJECTORY_REPRESENTATION_WAYPOINTS_FIELD_POS_X_LEN;
+         ++valid_points) {
+        const mavlink_message_t received = fromPx4(trajectory(valid_points), 200);
+        setSequences(7);
+
+        mavlink_message_t forwarded = received;
+        ASSERT_TRUE(readdressed(forwarded));
+        EXPECT_EQ(serialized(forwarded), serialized(reencoded(received))) << "valid points " << int(valid_points);
+    }
+}
+
+TEST(MavlinkReaddressTest, StampsTheSequenceOfOurChannel) {
+    setSequences(254);
+    const uint8_t px4_sequences[] = {200, 17, 90};
+    const uint8_t expected_sequences[] = {254, 255, 0};
+    for (size_t i = 0; i < 3; ++i) {
+        mavlink_message_t forwarded = fromPx4(trajectory(3), px4_sequences[i]);
+        ASSERT_TRUE(readdressed(forwarded));
+        EXPECT_EQ(forwarded.seq, expected_sequences[i]);
+    }
+    EXPECT_EQ(mavlink_get_channel_status(kOurChannel)->current_tx_seq, 1);
+}
+
+TEST(MavlinkReaddressTest, ParsesWithAValidChecksum) {
+    const mavlink_trajectory_representation_waypoints_t waypoints = trajectory(4);
+    mavlink_message_t forwarded = fromPx4(waypoints, 33);
+    ASSERT_TRUE(readdressed(forwarded));
+
+    mavlink_message_t parsed{};
+    mavlink_status_t parse_status{};
+    int complete = 0;
+    for (const uint8_t byte : serialized(forwarded)) {
+        complete += mavlink_parse_char(MAVLINK_COMM_0, byte, &parsed, &parse_status);
+    }
+    ASSERT_EQ(complete, 1);
+    EXPECT_EQ(parsed.sysid, kSystemId);
+    EXPECT_EQ(parsed.compid, MAV_COMP_ID_OBSTACLE_AVOIDANCE);
+
+    mavlink_trajectory_representation_waypoints_t decoded;
+    mavlink_msg_trajectory_representation_waypoints_decode(&parsed, &decoded);
+    EXPECT_EQ(std::memcmp(&decoded, &waypoints, sizeof(waypoints)), 0);
+}
+
+TEST(MavlinkReaddressTest, DropsTheSignature) {
+    const mavlink_message_t received = fromPx4(trajectory(2), 5);
+    setSequences(40);
+
+    mavlink_message_t forwarded = received;
+    forwarded.incompat_flags |= MAVLINK_IFLAG_SIGNED;
+    ASSERT_TRUE(readdressed(forwarded));
+    EXPECT_EQ(forwarded.incompat_flags & MAVLINK_IFLAG_SIGNED, 0);
+    EXPECT_EQ(serialized(forwarded), serialized(reencoded(received)));
+}
+
+TEST(MavlinkReaddressTest, LeavesMavlink1MessagesUntouched) {
+    const mavlink_message_t received = fromPx4(trajectory(3), 9, true);
+    setSequences(12);
+
+    mavlink_message_t forwarded = received;
+    EXPECT_FALSE(readdressed(forwarded));
+    EXPECT_EQ(serialized(forwarded), serialized(received));
+    EXPECT_EQ(mavlink_get_channel_status(kOurChannel)->current_tx_seq, 12);
+}
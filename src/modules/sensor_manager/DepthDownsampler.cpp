@@ -0,0 +1,467 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Block-min depth image downsampler writing into caller-owned buffers
+ * @file DepthDownsampler.cpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#include <DepthDownsampler.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DEPTH_DOWNSAMPLER_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define DEPTH_DOWNSAMPLER_NEON
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+constexpr float kInfinity = std::numeric_limits<float>::infinity();
+
+/*
+ * Column kernels: reduce `rows` image rows starting at `data` to one minimum per column for the columns
+ * [0, cols). The horizontal reduction within a block is done afterwards on the column minima.
+ *
+ * 16 bit depths are handled on the raw values. Converting to meters is monotonic, so the smallest valid raw value
+ * gives the smallest valid depth. Subtracting the raw threshold with wrap-around maps valid values to
+ * [0, 0xFFFF - threshold] and invalid ones above it, so a plain unsigned minimum ignores invalid values.
+ */
+using ColumnMinUint16 = void (*)(const uint8_t* data, size_t step, uint32_t rows, uint32_t cols, uint16_t threshold,
+                                 uint16_t* column_min);
+
+// Floating point depths are converted first, and invalid (including NaN) depths are replaced by infinity
+using ColumnMinFloat32 = void (*)(const uint8_t* data, size_t step, uint32_t rows, uint32_t cols, float scale,
+                                  float min_depth, float* column_min);
+
+inline void column_min_uint16_scalar(const uint8_t* data, size_t step, uint32_t rows, uint32_t col_begin,
+                                     uint32_t cols, uint16_t threshold, uint16_t* column_min) {
+    for (uint32_t col = col_begin; col < cols; ++col) {
+        uint16_t min_value = 0xFFFF;
+        for (uint32_t row = 0; row < rows; ++row) {
+            uint16_t raw;
+            std::memcpy(&raw, data + row * step + col * sizeof(uint16_t), sizeof(uint16_t));
+            min_value = std::min(min_value, static_cast<uint16_t>(raw - threshold));
+        }
+        column_min[col] = min_value;
+    }
+}
+
+inline void column_min_float32_scalar(const uint8_t* data, size_t step, uint32_t rows, uint32_t col_begin,
+                                      uint32_t cols, float scale, float min_depth, float* column_min) {
+    for (uint32_t col = col_begin; col < cols; ++col) {
+        float min_value = kInfinity;
+        for (uint32_t row = 0; row < rows; ++row) {
+            float raw;
+            std::memcpy(&raw, data + row * step + col * sizeof(float), sizeof(float));
+            const float depth = raw * scale;
+            if (depth > min_depth && depth < min_value) {
+                min_value = depth;
+            }
+        }
+        column_min[col] = min_value;
+    }
+}
+
+#if defined(DEPTH_DOWNSAMPLER_X86)
+
+__attribute__((target("sse4.1"))) void column_min_uint16_sse41(const uint8_t* data, size_t step, uint32_t rows,
+                                                               uint32_t cols, uint16_t threshold,
+                                                               uint16_t* column_min) {
+    const __m128i threshold_vec = _mm_set1_epi16(static_cast<int16_t>(threshold));
+    uint32_t col = 0;
+    for (; col + 8 <= cols; col += 8) {
+        __m128i min_vec = _mm_set1_epi16(-1);
+        for (uint32_t row = 0; row < rows; ++row) {
+            const __m128i raw =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + row * step + col * sizeof(uint16_t)));
+            min_vec = _mm_min_epu16(min_vec, _mm_sub_epi16(raw, threshold_vec));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(column_min + col), min_vec);
+    }
+    column_min_uint16_scalar(data, step, rows, col, cols, threshold, column_min);
+}
+
+__attribute__((target("avx2"))) void column_min_uint16_avx2(const uint8_t* data, size_t step, uint32_t rows,
+                                                            uint32_t cols, uint16_t threshold, uint16_t* column_min) {
+    const __m256i threshold_vec = _mm256_set1_epi16(static_cast<int16_t>(threshold));
+    uint32_t col = 0;
+    for (; col + 16 <= cols; col += 16) {
+        __m256i min_vec = _mm256_set1_epi16(-1);
+        for (uint32_t row = 0; row < rows; ++row) {
+            const __m256i raw =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + row * step + col * sizeof(uint16_t)));
+            min_vec = _mm256_min_epu16(min_vec, _mm256_sub_epi16(raw, threshold_vec));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(column_min + col), min_vec);
+    }
+    column_min_uint16_scalar(data, step, rows, col, cols, threshold, column_min);
+}
+
+__attribute__((target("sse4.1"))) void column_min_float32_sse41(const uint8_t* data, size_t step, uint32_t rows,
+                                                                uint32_t cols, float scale, float min_depth,
+                                                                float* column_min) {
+    const __m128 scale_vec = _mm_set1_ps(scale);
+    const __m128 min_depth_vec = _mm_set1_ps(min_depth);
+    const __m128 infinity_vec = _mm_set1_ps(kInfinity);
+    uint32_t col = 0;
+    for (; col + 4 <= cols; col += 4) {
+        __m128 min_vec = infinity_vec;
+        for (uint32_t row = 0; row < rows; ++row) {
+            const __m128 depth = _mm_mul_ps(
+                _mm_loadu_ps(reinterpret_cast<const float*>(data + row * step + col * sizeof(float))), scale_vec);
+            const __m128 valid = _mm_cmpgt_ps(depth, min_depth_vec);
+            min_vec = _mm_min_ps(min_vec, _mm_blendv_ps(infinity_vec, depth, valid));
+        }
+        _mm_storeu_ps(column_min + col, min_vec);
+    }
+    column_min_float32_scalar(data, step, rows, col, cols, scale, min_depth, column_min);
+}
+
+__attribute__((target("avx2"))) void column_min_float32_avx2(const uint8_t* data, size_t step, uint32_t rows,
+                                                             uint32_t cols, float scale, float min_depth,
+                                                             float* column_min) {
+    const __m256 scale_vec = _mm256_set1_ps(scale);
+    const __m256 min_depth_vec = _mm256_set1_ps(min_depth);
+    const __m256 infinity_vec = _mm256_set1_ps(kInfinity);
+    uint32_t col = 0;
+    for (; col + 8 <= cols; col += 8) {
+        __m256 min_vec = infinity_vec;
+        for (uint32_t row = 0; row < rows; ++row) {
+            const __m256 depth = _mm256_mul_ps(
+                _mm256_loadu_ps(reinterpret_cast<const float*>(data + row * step + col * sizeof(float))), scale_vec);
+            const __m256 valid = _mm256_cmp_ps(depth, min_depth_vec, _CMP_GT_OQ);
+            min_vec = _mm256_min_ps(min_vec, _mm256_blendv_ps(infinity_vec, depth, valid));
+        }
+        _mm256_storeu_ps(column_min + col, min_vec);
+    }
+    column_min_float32_scalar(data, step, rows, col, cols, scale, min_depth, column_min);
+}
+
+#elif defined(DEPTH_DOWNSAMPLER_NEON)
+
+void column_min_uint16_neon(const uint8_t* data, size_t step, uint32_t rows, uint32_t cols, uint16_t threshold,
+                            uint16_t* column_min) {
+    const uint16x8_t threshold_vec = vdupq_n_u16(threshold);
+    uint32_t col = 0;
+    for (; col + 8 <= cols; col += 8) {
+        uint16x8_t min_vec = vdupq_n_u16(0xFFFF);
+        for (uint32_t row = 0; row < rows; ++row) {
+            // Byte loads, since the image rows are not guaranteed to be aligned
+            const uint16x8_t raw = vreinterpretq_u16_u8(vld1q_u8(data + row * step + col * sizeof(uint16_t)));
+            min_vec = vminq_u16(min_vec, vsubq_u16(raw, threshold_vec));
+        }
+        vst1q_u16(column_min + col, min_vec);
+    }
+    column_min_uint16_scalar(data, step, rows, col, cols, threshold, column_min);
+}
+
+void column_min_float32_neon(const uint8_t* data, size_t step, uint32_t rows, uint32_t cols, float scale,
+                             float min_depth, float* column_min) {
+    const float32x4_t scale_vec = vdupq_n_f32(scale);
+    const float32x4_t min_depth_vec = vdupq_n_f32(min_depth);
+    const float32x4_t infinity_vec = vdupq_n_f32(kInfinity);
+    uint32_t col = 0;
+    for (; col + 4 <= cols; col += 4) {
+        float32x4_t min_vec = infinity_vec;
+        for (uint32_t row = 0; row < rows; ++row) {
+            const float32x4_t raw = vreinterpretq_f32_u8(vld1q_u8(data + row * step + col * sizeof(float)));
+            const float32x4_t depth = vmulq_f32(raw, scale_vec);
+            const uint32x4_t valid = vcgtq_f32(depth, min_depth_vec);
+            min_vec = vminq_f32(min_vec, vbslq_f32(valid, depth, infinity_vec));
+        }
+        vst1q_f32(column_min + col, min_vec);
+    }
+    column_min_float32_scalar(data, step, rows, col, cols, scale, min_depth, column_min);
+}
+
+#endif
+
+ColumnMinUint16 column_min_uint16(DepthDownsampler::Kernel kernel) {
+    switch (kernel) {
+#if defined(DEPTH_DOWNSAMPLER_X86)
+        case DepthDownsampler::Kernel::SSE41:
+            return column_min_uint16_sse41;
+        case DepthDownsampler::Kernel::AVX2:
+            return column_min_uint16_avx2;
+#elif defined(DEPTH_DOWNSAMPLER_NEON)
+        case DepthDownsampler::Kernel::NEON:
+            return column_min_uint16_neon;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+ColumnMinFloat32 column_min_float32(DepthDownsampler::Kernel kernel) {
+    switch (kernel) {
+#if defined(DEPTH_DOWNSAMPLER_X86)
+        case DepthDownsampler::Kernel::SSE41:
+            return column_min_float32_sse41;
+        case DepthDownsampler::Kernel::AVX2:
+            return column_min_float32_avx2;
+#elif defined(DEPTH_DOWNSAMPLER_NEON)
+        case DepthDownsampler::Kernel::NEON:
+            return column_min_float32_neon;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+}  // namespace
+
+DepthDownsampler::DepthDownsampler(Encoding encoding, uint32_t width, uint32_t height, uint32_t block_width,
+                                   uint32_t block_height, float min_depth_to_use_m, float depth_scale, Kernel kernel)
+    : _encoding(encoding),
+      _kernel(kernel_supported(kernel) ? kernel : Kernel::SCALAR),
+      _width(width),
+      _height(height),
+      _block_width(block_width),
+      _block_height(block_height),
+      _output_width(width / block_width),
+      _output_height(height / block_height),
+      _min_depth_to_use_m(min_depth_to_use_m),
+      _depth_scale(depth_scale),
+      _region(full_region()) {
+    // Binary search for the first raw value that is a valid depth, relying on the conversion being monotonic
+    uint32_t low = 0;
+    uint32_t high = 0x10000;
+    while (low < high) {
+        const uint32_t mid = (low + high) / 2;
+        if (static_cast<float>(static_cast<uint16_t>(mid)) * _depth_scale > _min_depth_to_use_m) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    _raw_threshold = low;
+
+    if (_encoding == Encoding::UINT16) {
+        _column_min_uint16.resize(_output_width * _block_width);
+    } else {
+        _column_min_float32.resize(_output_width * _block_width);
+    }
+}
+
+const char* DepthDownsampler::kernel_to_string(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::SSE41:
+            return "SSE4.1";
+        case Kernel::AVX2:
+            return "AVX2";
+        case Kernel::NEON:
+            return "NEON";
+        default:
+            return "scalar";
+    }
+}
+
+DepthDownsampler::Kernel DepthDownsampler::detect_kernel() {
+#if defined(DEPTH_DOWNSAMPLER_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return Kernel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return Kernel::SSE41;
+    }
+    return Kernel::SCALAR;
+#elif defined(DEPTH_DOWNSAMPLER_NEON)
+    return Kernel::NEON;
+#else
+    return Kernel::SCALAR;
+#endif
+}
+
+bool DepthDownsampler::kernel_supported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::SCALAR:
+            return true;
+#if defined(DEPTH_DOWNSAMPLER_X86)
+        case Kernel::SSE41:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse4.1");
+        case Kernel::AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#elif defined(DEPTH_DOWNSAMPLER_NEON)
+        case Kernel::NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+void DepthDownsampler::set_region(const Region& region) {
+    _region.col_end = std::min(region.col_end, _output_width);
+    _region.col_begin = std::min(region.col_begin, _region.col_end);
+    _region.row_end = std::min(region.row_end, _output_height);
+    _region.row_begin = std::min(region.row_begin, _region.row_end);
+}
+
+bool DepthDownsampler::is_full_region() const {
+    return _region.col_begin == 0 && _region.col_end == _output_width && _region.row_begin == 0 &&
+           _region.row_end == _output_height;
+}
+
+void DepthDownsampler::downsample(const uint8_t* data, size_t step, DepthPixelArrayF& out) {
+    if (out.size() != output_size()) {
+        out.resize(output_size());
+    }
+
+    if (_kernel == Kernel::SCALAR) {
+        if (_encoding == Encoding::UINT16) {
+            downsample_reference<uint16_t>(data, step, _region, out);
+        } else {
+            downsample_reference<float>(data, step, _region, out);
+        }
+    } else {
+        if (_encoding == Encoding::UINT16) {
+            downsample_uint16(data, step, _region, out);
+        } else {
+            downsample_float32(data, step, _region, out);
+        }
+    }
+
+    if (!is_full_region()) {
+        fill_outside_region(out);
+    }
+}
+
+void DepthDownsampler::fill_outside_region(DepthPixelArrayF& out) const {
+    // Output buffers are reused, so the pixels outside of the region have to be rewritten for every frame
+    for (uint32_t block_row = 0; block_row < _output_height; ++block_row) {
+        const bool row_inside = block_row >= _region.row_begin && block_row < _region.row_end;
+        for (uint32_t block_col = 0; block_col < _output_width; ++block_col) {
+            if (row_inside && block_col >= _region.col_begin && block_col < _region.col_end) {
+                continue;
+            }
+            DepthPixelF& pixel = out[block_row * _output_width + block_col];
+            pixel.x = block_col;
+            pixel.y = block_row;
+            pixel.depth = kInfinity;
+        }
+    }
+}
+
+template <typename T>
+void DepthDownsampler::downsample_reference(const uint8_t* data, size_t step, const Region& region,
+                                            DepthPixelArrayF& out) const {
+    for (uint32_t block_row = region.row_begin; block_row < region.row_end; ++block_row) {
+        for (uint32_t block_col = region.col_begin; block_col < region.col_end; ++block_col) {
+            float min_depth = kInfinity;
+
+            for (uint32_t row = block_row * _block_height; row < (block_row + 1) * _block_height; ++row) {
+                const uint8_t* row_data = data + row * step;
+                for (uint32_t col = block_col * _block_width; col < (block_col + 1) * _block_width; ++col) {
+                    T raw;
+                    std::memcpy(&raw, row_data + col * sizeof(T), sizeof(T));
+                    const float depth = static_cast<float>(raw) * _depth_scale;
+
+                    // NaN depths fail the comparison and are skipped as well
+                    if (depth > _min_depth_to_use_m && depth < min_depth) {
+                        min_depth = depth;
+                    }
+                }
+            }
+
+            DepthPixelF& pixel = out[block_row * _output_width + block_col];
+            pixel.x = block_col;
+            pixel.y = block_row;
+            pixel.depth = min_depth;
+        }
+    }
+}
+
+void DepthDownsampler::downsample_uint16(const uint8_t* data, size_t step, const Region& region,
+                                         DepthPixelArrayF& out) {
+    const ColumnMinUint16 column_min = column_min_uint16(_kernel);
+    const uint32_t cols = (region.col_end - region.col_begin) * _block_width;
+    const size_t col_offset = static_cast<size_t>(region.col_begin) * _block_width * sizeof(uint16_t);
+    const bool any_valid = _raw_threshold <= 0xFFFF;
+    const uint16_t threshold = static_cast<uint16_t>(_raw_threshold);
+    const uint16_t max_valid = static_cast<uint16_t>(0xFFFF - threshold);
+
+    for (uint32_t block_row = region.row_begin; block_row < region.row_end; ++block_row) {
+        if (any_valid) {
+            column_min(data + block_row * _block_height * step + col_offset, step, _block_height, cols, threshold,
+                       _column_min_uint16.data());
+        }
+
+        for (uint32_t block_col = region.col_begin; block_col < region.col_end; ++block_col) {
+            float min_depth = kInfinity;
+            if (any_valid) {
+                const uint16_t* block = _column_min_uint16.data() + (block_col - region.col_begin) * _block_width;
+                const uint16_t min_value = *std::min_element(block, block + _block_width);
+                if (min_value <= max_valid) {
+                    min_depth = static_cast<float>(static_cast<uint16_t>(min_value + threshold)) * _depth_scale;
+                }
+            }
+
+            DepthPixelF& pixel = out[block_row * _output_width + block_col];
+            pixel.x = block_col;
+            pixel.y = block_row;
+            pixel.depth = min_depth;
+        }
+    }
+}
+
+void DepthDownsampler::downsample_float32(const uint8_t* data, size_t step, const Region& region,
+                                          DepthPixelArrayF& out) {
+    const ColumnMinFloat32 column_min = column_min_float32(_kernel);
+    const uint32_t cols = (region.col_end - region.col_begin) * _block_width;
+    const size_t col_offset = static_cast<size_t>(region.col_begin) * _block_width * sizeof(float);
+
+    for (uint32_t block_row = region.row_begin; block_row < region.row_end; ++block_row) {
+        column_min(data + block_row * _block_height * step + col_offset, step, _block_height, cols, _depth_scale,
+                   _min_depth_to_use_m, _column_min_float32.data());
+
+        for (uint32_t block_col = region.col_begin; block_col < region.col_end; ++block_col) {
+            // Column minima are never NaN, so plain comparisons give the block minimum
+            const float* block = _column_min_float32.data() + (block_col - region.col_begin) * _block_width;
+
+            DepthPixelF& pixel = out[block_row * _output_width + block_col];
+            pixel.x = block_col;
+            pixel.y = block_row;
+            pixel.depth = *std::min_element(block, block + _block_width);
+        }
+    }
+}
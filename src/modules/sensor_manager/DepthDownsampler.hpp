@@ -0,0 +1,133 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Block-min depth image downsampler writing into caller-owned buffers
+ * @file DepthDownsampler.hpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#pragma once
+
+#include <common.h>
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Reduces every block_width x block_height block of a depth image to the minimum valid depth in meters. Depths at or
+ * below the minimum depth to use are invalid, and blocks without a valid depth are reported as infinity. The output is
+ * one pixel per block in row-major order, with the pixel coordinates on the downsampled grid.
+ *
+ * The block reduction runs on the widest SIMD kernel supported by the CPU unless another kernel is requested. The
+ * scalar reference kernel is kept for verification, and the SIMD kernels are tested for bit-exact output against it.
+ *
+ * When only part of the frame is of interest, the downsampling can be restricted to a region of the output grid. Only
+ * the image rows and columns covering that region are read, and the pixels outside of it are reported as infinity.
+ */
+class DepthDownsampler {
+   public:
+    enum class Encoding { UINT16, FLOAT32 };
+    enum class Kernel { SCALAR, SSE41, AVX2, NEON };
+
+    // Output grid columns [col_begin, col_end) and rows [row_begin, row_end)
+    struct Region {
+        uint32_t col_begin;
+        uint32_t col_end;
+        uint32_t row_begin;
+        uint32_t row_end;
+    };
+
+    DepthDownsampler(Encoding encoding, uint32_t width, uint32_t height, uint32_t block_width, uint32_t block_height,
+                     float min_depth_to_use_m, float depth_scale = 1.f, Kernel kernel = detect_kernel());
+
+    uint32_t output_width() const { return _output_width; }
+    uint32_t output_height() const { return _output_height; }
+    size_t output_size() const { return static_cast<size_t>(_output_width) * _output_height; }
+
+    Kernel kernel() const { return _kernel; }
+    const char* kernel_name() const { return kernel_to_string(_kernel); }
+
+    /**
+     * @brief Only downsample the given region of the output grid, clipped to the grid
+     */
+    void set_region(const Region& region);
+    void reset_region() { _region = full_region(); }
+    const Region& region() const { return _region; }
+    bool is_full_region() const;
+
+    static const char* kernel_to_string(Kernel kernel);
+
+    /**
+     * @brief Best kernel supported by the CPU this runs on
+     */
+    static Kernel detect_kernel();
+
+    /**
+     * @brief Whether the kernel is compiled in and supported by the CPU this runs on
+     */
+    static bool kernel_supported(Kernel kernel);
+
+    /**
+     * @brief Downsample an image with rows step bytes apart. Only allocates if out is smaller than output_size().
+     */
+    void downsample(const uint8_t* data, size_t step, DepthPixelArrayF& out);
+
+   private:
+    Region full_region() const { return Region{0, _output_width, 0, _output_height}; }
+
+    template <typename T>
+    void downsample_reference(const uint8_t* data, size_t step, const Region& region, DepthPixelArrayF& out) const;
+    void downsample_uint16(const uint8_t* data, size_t step, const Region& region, DepthPixelArrayF& out);
+    void downsample_float32(const uint8_t* data, size_t step, const Region& region, DepthPixelArrayF& out);
+    void fill_outside_region(DepthPixelArrayF& out) const;
+
+    Encoding _encoding;
+    Kernel _kernel;
+    uint32_t _width;
+    uint32_t _height;
+    uint32_t _block_width;
+    uint32_t _block_height;
+    uint32_t _output_width;
+    uint32_t _output_height;
+    float _min_depth_to_use_m;
+    float _depth_scale;
+    Region _region;
+
+    // Smallest raw 16 bit value converting to a valid depth, 0x10000 if there is none
+    uint32_t _raw_threshold;
+
+    // Per-column minimum of the current block row, written by the SIMD kernels
+    std::vector<uint16_t> _column_min_uint16;
+    std::vector<float> _column_min_float32;
+};
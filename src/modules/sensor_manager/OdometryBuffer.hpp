@@ -0,0 +1,154 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Time-indexed ring buffer of vehicle odometry poses
+ * @file OdometryBuffer.hpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#pragma once
+
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Vehicle pose in the NED frame at a ROS time stamp
+ */
+struct StampedPose {
+    uint64_t stamp_ns{0};
+    Eigen::Vector3d position{Eigen::Vector3d::Zero()};
+    Eigen::Quaterniond orientation{Eigen::Quaterniond::Identity()};
+};
+
+/**
+ * Keeps the latest odometry samples in a fixed ring, ordered by time stamp, and interpolates the pose at any stamp
+ * they cover. It replaces the tf2 buffer lookup for the depth images, without the round trip through /tf.
+ *
+ * Samples must arrive in time order. Out-of-order samples are dropped, unless they jump back by more than
+ * reset_jump_ns, which happens when the time sync restarts and empties the buffer.
+ */
+class OdometryBuffer {
+   public:
+    static constexpr uint64_t reset_jump_ns = 1'000'000'000;
+
+    explicit OdometryBuffer(size_t capacity) : _samples(std::max<size_t>(capacity, 2)) {}
+
+    void push(const StampedPose& pose) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_size > 0) {
+            const uint64_t newest_stamp_ns = at(_size - 1).stamp_ns;
+            if (pose.stamp_ns <= newest_stamp_ns) {
+                if (newest_stamp_ns - pose.stamp_ns <= reset_jump_ns) {
+                    return;
+                }
+                _size = 0;
+            }
+        }
+
+        _samples[(_oldest + _size) % _samples.size()] = pose;
+        if (_size < _samples.size()) {
+            _size++;
+        } else {
+            _oldest = (_oldest + 1) % _samples.size();
+        }
+    }
+
+    /**
+     * @brief Pose at a time stamp, interpolated between the neighbouring samples
+     * @param max_extrapolation_ns stamps this far outside the buffered interval take the closest sample
+     * @return the pose, or nothing if the stamp is not covered by the buffer
+     */
+    std::optional<StampedPose> interpolate(uint64_t stamp_ns, uint64_t max_extrapolation_ns) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_size == 0) {
+            return std::nullopt;
+        }
+
+        const StampedPose& oldest = at(0);
+        const StampedPose& newest = at(_size - 1);
+        if (stamp_ns >= newest.stamp_ns) {
+            return stampedCopy(newest, stamp_ns, stamp_ns - newest.stamp_ns <= max_extrapolation_ns);
+        }
+        if (stamp_ns <= oldest.stamp_ns) {
+            return stampedCopy(oldest, stamp_ns, oldest.stamp_ns - stamp_ns <= max_extrapolation_ns);
+        }
+
+        // First sample at or after the stamp, the one before it is older
+        size_t low = 1;
+        size_t high = _size - 1;
+        while (low < high) {
+            const size_t mid = (low + high) / 2;
+            if (at(mid).stamp_ns < stamp_ns) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        const StampedPose& before = at(low - 1);
+        const StampedPose& after = at(low);
+
+        const double t = static_cast<double>(stamp_ns - before.stamp_ns) / (after.stamp_ns - before.stamp_ns);
+        StampedPose pose;
+        pose.stamp_ns = stamp_ns;
+        pose.position = before.position + t * (after.position - before.position);
+        pose.orientation = before.orientation.slerp(t, after.orientation);
+        return pose;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _size;
+    }
+
+   private:
+    const StampedPose& at(size_t i) const { return _samples[(_oldest + i) % _samples.size()]; }
+
+    static std::optional<StampedPose> stampedCopy(const StampedPose& sample, uint64_t stamp_ns, bool in_tolerance) {
+        if (!in_tolerance) {
+            return std::nullopt;
+        }
+        StampedPose pose = sample;
+        pose.stamp_ns = stamp_ns;
+        return pose;
+    }
+
+    mutable std::mutex _mutex;
+    std::vector<StampedPose> _samples;
+    size_t _oldest{0};
+    size_t _size{0};
+};
@@ -38,11 +38,22 @@
  */
 
 #include <SensorManager.hpp>
+#include <algorithm>
 
 using namespace std::chrono_literals;
 
 static constexpr auto health_check_interval = 100ms;
 static constexpr auto time_sync_publish_interval = 100ms;
+static constexpr auto print_stats_interval = 30s;
+static constexpr auto tf_subscribers_check_interval = 1s;
+
+// Odometry history for the camera pose lookup, a bit more than a second at the usual telemetry rates
+static constexpr size_t odometry_buffer_size = 256;
+// Images stamped this far past the latest odometry sample still take its pose, same as the former tf2 tolerance
+static constexpr auto odometry_max_extrapolation = 10ms;
+
+// RealSense 16UC1 depth images are in millimeters
+static constexpr float depth_scale_16UC1 = 1e-3f;
 
 SensorManager::SensorManager(std::shared_ptr<mavsdk::System> mavsdk_system)
     : Node("sensor_manager"),
@@ -50,15 +61,15 @@ SensorManager::SensorManager(std::shared_ptr<mavsdk::System> mavsdk_system)
       _downsampling_block_size(4),
       _static_tf_broadcaster(this),
       _tf_broadcaster(this),
-      _tf_buffer(this->get_clock()),
-      _tf_listener(_tf_buffer),
-      _tf_depth_filter(_tf_buffer, NED_FRAME, 10, this->create_sub_node("tf_filter")),
+      _odometry_buffer(odometry_buffer_size),
       _time_last_odometry{this->now()},
       _time_last_image{this->now()},
       _health_status{HealthStatus::HEALTHY},
       _frequency_images("sensor images"),
       _frequency_camera_info("sensor camera_info"),
-      _frequency_odometry("sensor odometry") {}
+      _frequency_odometry("sensor odometry"),
+      _depth_frame_channel(std::make_shared<DepthFrameChannel>()),
+      _depth_frame_demand(std::make_shared<FrameDemand>()) {}
 
 SensorManager::~SensorManager() { deinit(); }
 
@@ -70,6 +81,10 @@ void SensorManager::init() {
     this->declare_parameter("sim");
     this->get_parameter_or("sim", sim, false);
 
+    // Debug option to run the scalar reference downsampling kernel instead of the SIMD ones
+    this->declare_parameter("downsampling_force_scalar");
+    this->get_parameter_or("downsampling_force_scalar", _downsampling_force_scalar, false);
+
     rclcpp::SensorDataQoS qos;
     qos.keep_last(10);
     qos.best_effort();
@@ -82,59 +97,112 @@ void SensorManager::init() {
         depth_topic = "/camera/depth/image_raw";
     }
 
-    _telemetry = std::make_shared<mavsdk::Telemetry>(_mavsdk_system);
+    if (_telemetry_hub == nullptr) {
+        _telemetry_hub = std::make_shared<TelemetryHub>(_mavsdk_system);
+    }
     _server_utility = std::make_shared<mavsdk::ServerUtility>(_mavsdk_system);
 
-    _mavlink_passthrough = std::make_shared<mavsdk::MavlinkPassthrough>(_mavsdk_system);
+    _mavlink_passthrough = _telemetry_hub->mavlink_passthrough();
 
     _depth_img_camera_info_sub = this->create_subscription<sensor_msgs::msg::CameraInfo>(
         depth_camera_info_topic, qos,
         [this](const sensor_msgs::msg::CameraInfo::ConstSharedPtr msg) { handle_incoming_camera_info(msg); });
 
-    _tf_depth_subscriber.subscribe(this, depth_topic, rmw_qos_profile);
-    auto timer_interface =
-        std::make_shared<tf2_ros::CreateTimerROS>(this->get_node_base_interface(), this->get_node_timers_interface());
-    _tf_buffer.setCreateTimerInterface(timer_interface);
-    _tf_depth_filter.connectInput(_tf_depth_subscriber);
-    _tf_depth_filter.registerCallback(&SensorManager::handle_incoming_depth_image, this);
-    _tf_depth_filter.setTolerance(rclcpp::Duration(0, static_cast<int>(10 * 1E6)));
+    // Where the camera pose of the depth images comes from: "odometry" interpolates the MAVSDK odometry in process,
+    // "tf" looks it up from /tf, which is needed when the odometry is replayed from a bag
+    std::string camera_pose_source;
+    this->declare_parameter("camera_pose_source");
+    this->get_parameter_or("camera_pose_source", camera_pose_source, std::string("odometry"));
+    _use_tf_camera_pose = camera_pose_source == "tf";
+    std::cout << sensorManagerOut << "Camera pose source = " << (_use_tf_camera_pose ? "tf" : "odometry")
+              << std::endl;
+
+    // Odometry on /tf: "off", "rate" to broadcast at most odometry_tf_max_rate_hz (0 for every sample) or
+    // "subscribed" to also skip it while nothing else listens on /tf
+    std::string odometry_tf_broadcast;
+    double odometry_tf_max_rate_hz;
+    this->declare_parameter("odometry_tf_broadcast");
+    this->declare_parameter("odometry_tf_max_rate_hz");
+    this->get_parameter_or("odometry_tf_broadcast", odometry_tf_broadcast, std::string("subscribed"));
+    this->get_parameter_or("odometry_tf_max_rate_hz", odometry_tf_max_rate_hz, 30.0);
+
+    if (odometry_tf_broadcast == "off") {
+        _odometry_tf_policy = TfBroadcastPolicy::OFF;
+    } else if (odometry_tf_broadcast == "rate") {
+        _odometry_tf_policy = TfBroadcastPolicy::RATE_LIMITED;
+    } else {
+        if (odometry_tf_broadcast != "subscribed") {
+            RCLCPP_WARN(get_logger(), "Unknown odometry_tf_broadcast '%s', using 'subscribed'",
+                        odometry_tf_broadcast.c_str());
+        }
+        _odometry_tf_policy = TfBroadcastPolicy::SUBSCRIBED;
+    }
+    if (odometry_tf_max_rate_hz > 0.0) {
+        _odometry_tf_min_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(1.0 / odometry_tf_max_rate_hz));
+    }
+
+    if (_use_tf_camera_pose) {
+        // The camera poses are looked up from our own broadcast, which then has to run at the full odometry rate
+        _odometry_tf_policy = TfBroadcastPolicy::RATE_LIMITED;
+        _odometry_tf_min_interval = {};
+
+        _tf_buffer = std::make_unique<tf2_ros::Buffer>(this->get_clock());
+        _tf_listener = std::make_unique<tf2_ros::TransformListener>(*_tf_buffer);
+        _tf_depth_filter = std::make_unique<tf2_ros::MessageFilter<sensor_msgs::msg::Image>>(
+            *_tf_buffer, NED_FRAME, 10, this->create_sub_node("tf_filter"));
+
+        _tf_depth_subscriber.subscribe(this, depth_topic, rmw_qos_profile);
+        auto timer_interface = std::make_shared<tf2_ros::CreateTimerROS>(this->get_node_base_interface(),
+                                                                         this->get_node_timers_interface());
+        _tf_buffer->setCreateTimerInterface(timer_interface);
+        _tf_depth_filter->connectInput(_tf_depth_subscriber);
+        _tf_depth_filter->registerCallback(&SensorManager::handle_incoming_depth_image, this);
+        _tf_depth_filter->setTolerance(rclcpp::Duration(0, static_cast<int>(10 * 1E6)));
+    } else {
+        _depth_img_sub = this->create_subscription<sensor_msgs::msg::Image>(
+            depth_topic, qos,
+            [this](const sensor_msgs::msg::Image::ConstSharedPtr msg) { handle_incoming_depth_image(msg); });
+    }
 
     _vehicle_status_pub =
         this->create_publisher<px4_msgs::msg::VehicleStatus>("vehicle_status/out", 10);  // for bagger in MAVLink mode
 }
 
-auto SensorManager::deinit() -> void { _depth_img_camera_info_sub.reset(); }
-
-auto SensorManager::run() -> void {
-    // Subscribe to odometry for publishing the TF
-    _telemetry->subscribe_odometry([this](mavsdk::Telemetry::Odometry odometry) {
-        _frequency_odometry.tic();
-
-        geometry_msgs::msg::TransformStamped tMsg{};
+auto SensorManager::deinit() -> void {
+    // The hub is shared and outlives this module, its listeners must not call into us anymore
+    for (TelemetryHub::ListenerHandle& listener : _telemetry_listeners) {
+        listener.remove();
+    }
+    _telemetry_listeners.clear();
 
-        tMsg.transform.translation = geometry_msgs::msg::Vector3{};
-        tMsg.transform.translation.x = odometry.position_body.x_m;
-        tMsg.transform.translation.y = odometry.position_body.y_m;
-        tMsg.transform.translation.z = odometry.position_body.z_m;
+    _depth_img_camera_info_sub.reset();
+    _depth_img_sub.reset();
+}
 
-        tMsg.transform.rotation = geometry_msgs::msg::Quaternion{};
-        tMsg.transform.rotation.w = odometry.q.w;
-        tMsg.transform.rotation.x = odometry.q.x;
-        tMsg.transform.rotation.y = odometry.q.y;
-        tMsg.transform.rotation.z = odometry.q.z;
+auto SensorManager::run() -> void {
+    // Subscribe to odometry for the camera poses and the TF
+    _telemetry_listeners.push_back(
+        _telemetry_hub->addOdometryListener([this](const mavsdk::Telemetry::Odometry& odometry) {
+            _frequency_odometry.tic();
 
-        uint64_t ts_ns = _time_sync.sync_stamp(odometry.time_usec, this->now().nanoseconds() / 1000ULL) * 1000;
-        tMsg.header.stamp = rclcpp::Time(ts_ns);
+            uint64_t ts_ns = _time_sync.sync_stamp(odometry.time_usec, this->now().nanoseconds() / 1000ULL) * 1000;
 
-        tMsg.header.frame_id = NED_FRAME;
-        tMsg.child_frame_id = BASE_LINK_FRAME;
+            StampedPose pose;
+            pose.stamp_ns = ts_ns;
+            pose.position = Eigen::Vector3d(odometry.position_body.x_m, odometry.position_body.y_m,
+                                            odometry.position_body.z_m);
+            pose.orientation = Eigen::Quaterniond(odometry.q.w, odometry.q.x, odometry.q.y, odometry.q.z);
+            _odometry_buffer.push(pose);
 
-        _tf_broadcaster.sendTransform(tMsg);
+            if (should_broadcast_odometry_tf()) {
+                broadcast_odometry_tf(pose);
+            }
 
-        _time_last_odometry = this->now();
-    });
+            _time_last_odometry = this->now();
+        }));
 
-    _telemetry->subscribe_armed([this](bool _armed) {
+    _telemetry_listeners.push_back(_telemetry_hub->addArmedListener([this](const bool& _armed) {
         px4_msgs::msg::VehicleStatus msg;
         if (_armed) {
             msg.arming_state = px4_msgs::msg::VehicleStatus::ARMING_STATE_ARMED;
@@ -143,38 +211,137 @@ auto SensorManager::run() -> void {
         }
 
         _vehicle_status_pub->publish(msg);  // Send data for bagger
-    });
+    }));
 
-    _mavlink_passthrough->subscribe_message_async(MAVLINK_MSG_ID_TIMESYNC, [this](const mavlink_message_t& _message) {
-        mavlink_timesync_t tsync;
-        mavlink_msg_timesync_decode(&_message, &tsync);
+    _telemetry_listeners.push_back(_telemetry_hub->addMavlinkMessageListener(
+        MAVLINK_MSG_ID_TIMESYNC, [this](const mavlink_message_t& _message) {
+            mavlink_timesync_t tsync;
+            mavlink_msg_timesync_decode(&_message, &tsync);
 
-        _time_sync.run(tsync.ts1, tsync.tc1, this->now().nanoseconds() / 1000ULL);
-    });
+            _time_sync.run(tsync.ts1, tsync.tc1, this->now().nanoseconds() / 1000ULL);
+        }));
 
     _timer_health_check_task = create_wall_timer(health_check_interval, std::bind(&SensorManager::health_check, this));
     _timer_time_sync_task =
         create_wall_timer(time_sync_publish_interval, std::bind(&SensorManager::publish_time_sync, this));
+    _timer_stats = create_wall_timer(print_stats_interval, std::bind(&SensorManager::print_stats, this));
+    if (_odometry_tf_policy == TfBroadcastPolicy::SUBSCRIBED) {
+        update_tf_subscribers();
+        _timer_tf_subscribers =
+            create_wall_timer(tf_subscribers_check_interval, std::bind(&SensorManager::update_tf_subscribers, this));
+    }
 
     rclcpp::spin(shared_from_this());
 }
 
+bool SensorManager::should_broadcast_odometry_tf() {
+    bool broadcast = false;
+    switch (_odometry_tf_policy) {
+        case TfBroadcastPolicy::OFF:
+            break;
+        case TfBroadcastPolicy::RATE_LIMITED:
+            broadcast = true;
+            break;
+        case TfBroadcastPolicy::SUBSCRIBED:
+            broadcast = _tf_has_subscribers.load(std::memory_order_relaxed);
+            break;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (broadcast && now - _odometry_tf_last_broadcast >= _odometry_tf_min_interval) {
+        _odometry_tf_last_broadcast = now;
+        return true;
+    }
+    _odometry_tf_skipped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void SensorManager::broadcast_odometry_tf(const StampedPose& pose) {
+    const auto start = std::chrono::steady_clock::now();
+
+    geometry_msgs::msg::TransformStamped tMsg{};
+
+    tMsg.transform.translation = geometry_msgs::msg::Vector3{};
+    tMsg.transform.translation.x = pose.position.x();
+    tMsg.transform.translation.y = pose.position.y();
+    tMsg.transform.translation.z = pose.position.z();
+
+    tMsg.transform.rotation = geometry_msgs::msg::Quaternion{};
+    tMsg.transform.rotation.w = pose.orientation.w();
+    tMsg.transform.rotation.x = pose.orientation.x();
+    tMsg.transform.rotation.y = pose.orientation.y();
+    tMsg.transform.rotation.z = pose.orientation.z();
+
+    tMsg.header.stamp = rclcpp::Time(pose.stamp_ns);
+    tMsg.header.frame_id = NED_FRAME;
+    tMsg.child_frame_id = BASE_LINK_FRAME;
+
+    _tf_broadcaster.sendTransform(tMsg);
+
+    const auto send_time = std::chrono::steady_clock::now() - start;
+    _odometry_tf_send_time_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(send_time).count(),
+                                        std::memory_order_relaxed);
+    _odometry_tf_sent.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SensorManager::update_tf_subscribers() {
+    // Our own tf listener only exists when the camera poses come from /tf, and then the policy is not used
+    _tf_has_subscribers.store(this->count_subscribers("/tf") > 0, std::memory_order_relaxed);
+}
+
 bool SensorManager::set_downsampler(const sensor_msgs::msg::Image::ConstSharedPtr& msg) {
+    // The downsampler and the frame pool are sized for one image format, rebuild them when the camera changes it
+    if (_imageDownsampler != nullptr && (msg->width != _depth_image_width || msg->height != _depth_image_height ||
+                                         msg->encoding != _depth_image_encoding)) {
+        RCLCPP_WARN(get_logger(), "Depth image format changed from %ux%u %s to %ux%u %s, rebuilding the downsampler",
+                    _depth_image_width, _depth_image_height, _depth_image_encoding.c_str(), msg->width, msg->height,
+                    msg->encoding.c_str());
+        _imageDownsampler.reset();
+        _depthDownsampler.reset();
+        // Frames are dropped until the next camera info provides the intrinsics of the new format
+        _intrinsics = RectifiedIntrinsicsF{};
+        _ray_table.reset();
+    }
+
     bool ret = true;
     if (_imageDownsampler == nullptr) {
+        const DepthDownsampler::Kernel kernel =
+            _downsampling_force_scalar ? DepthDownsampler::Kernel::SCALAR : DepthDownsampler::detect_kernel();
         if (msg->encoding == sensor_msgs::image_encodings::TYPE_16UC1) {
             _imageDownsampler = ImageDownsamplerInterface::getInstance<uint16_t>(
                 msg->width, msg->height, _downsampling_block_size, _downsampling_block_size,
                 _downsampling_min_depth_to_use_m);
+            _depthDownsampler = std::make_unique<DepthDownsampler>(
+                DepthDownsampler::Encoding::UINT16, msg->width, msg->height, _downsampling_block_size,
+                _downsampling_block_size, _downsampling_min_depth_to_use_m, depth_scale_16UC1, kernel);
 
         } else if (msg->encoding == sensor_msgs::image_encodings::TYPE_32FC1) {
             _imageDownsampler = ImageDownsamplerInterface::getInstance<float>(
                 msg->width, msg->height, _downsampling_block_size, _downsampling_block_size,
                 _downsampling_min_depth_to_use_m);
+            _depthDownsampler = std::make_unique<DepthDownsampler>(
+                DepthDownsampler::Encoding::FLOAT32, msg->width, msg->height, _downsampling_block_size,
+                _downsampling_block_size, _downsampling_min_depth_to_use_m, 1.f, kernel);
         } else {
             RCLCPP_ERROR(get_logger(), "Unhandled image encoding %s", msg->encoding.c_str());
             ret = false;
         }
+
+        if (_depthDownsampler != nullptr) {
+            _depth_image_width = msg->width;
+            _depth_image_height = msg->height;
+            _depth_image_encoding = msg->encoding;
+            std::cout << sensorManagerOut << "Downsampling kernel = " << _depthDownsampler->kernel_name() << std::endl;
+
+            // Size the frame pool from the first image, so that no frame needs to be allocated afterwards
+            const size_t pixels = _depthDownsampler->output_size();
+            _depth_frame_pool.reset(DepthFrameChannel::kMaxFramesInUse + 1, [pixels](ExtendedDownsampledImageF& frame) {
+                frame.downsampled_image.depth_pixel_array.resize(pixels);
+            });
+            std::cout << sensorManagerOut << "Depth frame pool: " << _depth_frame_pool.capacity() << " frames of "
+                      << _depthDownsampler->output_width() << "x" << _depthDownsampler->output_height() << " pixels"
+                      << std::endl;
+        }
     }
 
     return ret;
@@ -204,6 +371,9 @@ void SensorManager::set_camera_static_tf(const double x, const double y, const d
 
     _static_tf_broadcaster.sendTransform(_camera_static_tf);
 
+    _camera_extrinsic_position = Eigen::Vector3d(x, y, 0.);
+    _camera_extrinsic_orientation = Eigen::Quaterniond(rot.w(), rot.x(), rot.y(), rot.z());
+
     std::cout << sensorManagerOut << "Camera offset is [" << x << "m, " << y << "m] with " << yaw_deg << "° yaw."
               << std::endl;
 }
@@ -213,6 +383,7 @@ void SensorManager::handle_incoming_camera_info(const sensor_msgs::msg::CameraIn
 
     const RectifiedIntrinsicsF raw_intrinsics(msg->k[0], msg->k[4], msg->k[2], msg->k[5], msg->width, msg->height);
 
+    std::lock_guard<std::mutex> lock(_camera_mutex);
     if (_imageDownsampler == nullptr) {
         return;
     }
@@ -221,54 +392,152 @@ void SensorManager::handle_incoming_camera_info(const sensor_msgs::msg::CameraIn
 
     _inverse_focal_length = _intrinsics.inverse_focal_length();
     _principal_point = _intrinsics.principal_point();
+
+    // Camera info arrives with every image, but the rays only need to be recomputed when the intrinsics change
+    if (_ray_table == nullptr || !_ray_table->matches(_intrinsics)) {
+        _ray_table = std::make_shared<const RayTable>(_intrinsics);
+        std::cout << sensorManagerOut << "Ray table updated for " << _intrinsics.rw << "x" << _intrinsics.rh
+                  << " pixels" << std::endl;
+    }
 }
 
 void SensorManager::handle_incoming_depth_image(const sensor_msgs::msg::Image::ConstSharedPtr& msg) {
+    const std::chrono::steady_clock::time_point received_time = std::chrono::steady_clock::now();
     _frequency_images.tic();
 
-    set_downsampler(msg);
+    // The camera info callback updates the intrinsics and the rays concurrently, take a consistent copy of both
+    RectifiedIntrinsicsF intrinsics;
+    std::shared_ptr<const RayTable> ray_table;
+    {
+        std::lock_guard<std::mutex> lock(_camera_mutex);
+        set_downsampler(msg);
 
-    if (_imageDownsampler == nullptr) {
-        RCLCPP_ERROR_SKIPFIRST(get_logger(), "_imageDownsampler not set");
+        if (_imageDownsampler == nullptr) {
+            RCLCPP_ERROR_SKIPFIRST(get_logger(), "_imageDownsampler not set");
+            return;
+        }
+        intrinsics = _intrinsics;
+        ray_table = _ray_table;
+    }
+
+    // The downsampler reads height rows of width pixels, step bytes apart, straight from the message
+    const size_t pixel_size =
+        msg->encoding == sensor_msgs::image_encodings::TYPE_16UC1 ? sizeof(uint16_t) : sizeof(float);
+    if (msg->step < msg->width * pixel_size || msg->data.size() < static_cast<size_t>(msg->step) * msg->height) {
+        RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 1000,
+                             "Depth image data too short for %ux%u pixels with step %u, dropping image", msg->width,
+                             msg->height, msg->step);
+        _depth_frames_malformed++;
         return;
     }
 
-    const bool intrinsicPlausible = (_intrinsics.rh != 0) && (_intrinsics.rw != 0);
+    const bool intrinsicPlausible = (intrinsics.rh != 0) && (intrinsics.rw != 0) && (ray_table != nullptr);
     if (!intrinsicPlausible) {
         RCLCPP_ERROR_SKIPFIRST(get_logger(), "Intrinsics not plausible");
         return;
     }
 
-    std::shared_ptr<ExtendedDownsampledImageF> downsampled_depth_image = std::make_shared<ExtendedDownsampledImageF>();
+    // Skip the downsampling, pose lookup and publication when no consumer wants this frame
+    if (!_depth_frame_demand->admit(received_time)) {
+        _depth_frames_without_demand++;
+        _time_last_image = this->now();
+        return;
+    }
 
-    downsampled_depth_image->downsampled_image.depth_pixel_array = _imageDownsampler->downsample(msg->data.data());
-    downsampled_depth_image->downsampled_image.intrinsics = _intrinsics;
+    // Frames go back to the pool automatically once the last consumer drops them
+    std::shared_ptr<ExtendedDownsampledImageF> downsampled_depth_image = _depth_frame_pool.acquire();
+    if (downsampled_depth_image == nullptr) {
+        RCLCPP_ERROR(get_logger(), "Depth frame pool exhausted, dropping image");
+        return;
+    }
+
+    DepthPixelArrayF& depth_pixel_array = downsampled_depth_image->downsampled_image.depth_pixel_array;
+    const size_t depth_pixel_array_capacity = depth_pixel_array.capacity();
+    update_downsampling_region();
+    {
+        timing_tools::Timer timer_downsample("sensor: downsample", true);
+        _depthDownsampler->downsample(msg->data.data(), msg->step, depth_pixel_array);
+    }
+    if (depth_pixel_array.capacity() != depth_pixel_array_capacity) {
+        _depth_frame_buffer_allocations++;
+    }
+    downsampled_depth_image->downsampled_image.intrinsics = intrinsics;
+    downsampled_depth_image->ray_table = std::move(ray_table);
 
     // Get position and orientation to image
-    geometry_msgs::msg::TransformStamped transformStamped;
-    try {
-        transformStamped = _tf_buffer.lookupTransform(NED_FRAME, CAMERA_LINK_FRAME, msg->header.stamp);
-    } catch (tf2::TransformException& ex) {
-        RCLCPP_ERROR(get_logger(), "%s", ex.what());
-        downsampled_depth_image = nullptr;
+    if (!lookup_camera_pose(msg->header.stamp, downsampled_depth_image->position,
+                            downsampled_depth_image->orientation)) {
+        _depth_frames_without_pose++;
         return;
     }
-
-    downsampled_depth_image->position =
-        Eigen::Vector3f(transformStamped.transform.translation.x, transformStamped.transform.translation.y,
-                        transformStamped.transform.translation.z);
-    downsampled_depth_image->orientation =
-        Eigen::Quaternionf(transformStamped.transform.rotation.w, transformStamped.transform.rotation.x,
-                           transformStamped.transform.rotation.y, transformStamped.transform.rotation.z);
     downsampled_depth_image->timestamp_ns = msg->header.stamp.nanosec;
+    downsampled_depth_image->received_time = received_time;
 
     // Make the downsampled depth data available for other modules
-    std::lock_guard<std::mutex> lock(_sensor_manager_mutex);
-    _downsampled_depth = downsampled_depth_image;
+    if (_depth_frame_channel->publish(std::move(downsampled_depth_image))) {
+        _depth_frames_published++;
+    } else {
+        RCLCPP_ERROR(get_logger(), "No free slot to publish the downsampled depth frame");
+    }
 
     _time_last_image = this->now();
 }
 
+bool SensorManager::lookup_camera_pose(const builtin_interfaces::msg::Time& stamp, Eigen::Vector3f& position,
+                                       Eigen::Quaternionf& orientation) {
+    if (_use_tf_camera_pose) {
+        geometry_msgs::msg::TransformStamped transformStamped;
+        try {
+            transformStamped = _tf_buffer->lookupTransform(NED_FRAME, CAMERA_LINK_FRAME, stamp);
+        } catch (tf2::TransformException& ex) {
+            RCLCPP_ERROR(get_logger(), "%s", ex.what());
+            return false;
+        }
+
+        position = Eigen::Vector3f(transformStamped.transform.translation.x, transformStamped.transform.translation.y,
+                                   transformStamped.transform.translation.z);
+        orientation = Eigen::Quaternionf(transformStamped.transform.rotation.w, transformStamped.transform.rotation.x,
+                                         transformStamped.transform.rotation.y, transformStamped.transform.rotation.z);
+        return true;
+    }
+
+    const uint64_t stamp_ns = rclcpp::Time(stamp).nanoseconds();
+    const std::optional<StampedPose> base_link_pose = _odometry_buffer.interpolate(
+        stamp_ns, std::chrono::duration_cast<std::chrono::nanoseconds>(odometry_max_extrapolation).count());
+    if (!base_link_pose) {
+        RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 1000, "No odometry for the depth image stamp, dropping image");
+        return false;
+    }
+
+    // Compose with the static camera extrinsic, same as the ned -> base_link -> camera_link tf chain
+    position = (base_link_pose->position + base_link_pose->orientation * _camera_extrinsic_position).cast<float>();
+    orientation = (base_link_pose->orientation * _camera_extrinsic_orientation).normalized().cast<float>();
+    return true;
+}
+
+void SensorManager::update_downsampling_region() {
+    DepthRegionOfInterest roi;
+    {
+        std::lock_guard<std::mutex> lock(_region_of_interest_mutex);
+        if (_region_of_interest_callback) {
+            roi = _region_of_interest_callback();
+        }
+    }
+
+    // Same rounding as the consumers use to address the region on the downsampled grid, end bounds are inclusive
+    const auto to_index = [](float fraction, uint32_t size) {
+        return static_cast<uint32_t>(std::clamp(fraction * size, 0.f, static_cast<float>(size)));
+    };
+    const uint32_t width = _depthDownsampler->output_width();
+    const uint32_t height = _depthDownsampler->output_height();
+    DepthDownsampler::Region region;
+    region.col_begin = to_index(roi.col_begin, width);
+    region.col_end = to_index(roi.col_end, width) + 1;
+    region.row_begin = to_index(roi.row_begin, height);
+    region.row_end = to_index(roi.row_end, height) + 1;
+    _depthDownsampler->set_region(region);
+}
+
 void SensorManager::health_check() {
     const auto now = this->now();
     static rclcpp::Time time_start = now;
@@ -334,3 +603,49 @@ void SensorManager::publish_time_sync() {
     mavlink_msg_timesync_encode(1, MAV_COMP_ID_ONBOARD_COMPUTER3, &message_out, &timesync_message);
     _mavlink_passthrough->send_message(message_out);
 }
+
+void SensorManager::print_stats() {
+    static constexpr size_t width = 10;
+    std::stringstream ss;
+
+    if (_depth_frames_published + _depth_frames_without_demand + _depth_frames_malformed > 0) {
+        // Heap allocations for depth frames only happen when the pool is sized and should not grow afterwards
+        ss << "=== Depth frame statistics ===" << std::endl;
+        ss << "Frames published      " << std::setw(width) << _depth_frames_published << std::endl;
+        ss << "Pool frames allocated " << std::setw(width) << _depth_frame_pool.allocations() << std::endl;
+        ss << "Buffer reallocations  " << std::setw(width) << _depth_frame_buffer_allocations << std::endl;
+        ss << "Pool exhausted        " << std::setw(width) << _depth_frame_pool.exhausted() << std::endl;
+        ss << "Frames without pose   " << std::setw(width) << _depth_frames_without_pose << std::endl;
+        ss << "Frames without demand " << std::setw(width) << _depth_frames_without_demand << std::endl;
+        ss << "Frames malformed      " << std::setw(width) << _depth_frames_malformed << std::endl;
+        _depth_frame_demand->printStats(ss);
+    }
+
+    const uint64_t tf_sent = _odometry_tf_sent.exchange(0, std::memory_order_relaxed);
+    const uint64_t tf_skipped = _odometry_tf_skipped.exchange(0, std::memory_order_relaxed);
+    const uint64_t tf_send_time_ns = _odometry_tf_send_time_ns.exchange(0, std::memory_order_relaxed);
+    if (tf_sent + tf_skipped > 0) {
+        // The saving is estimated from the cost of the broadcasts that did happen, the last known one if none did
+        if (tf_sent > 0) {
+            _odometry_tf_mean_send_time_us = tf_send_time_ns * 1e-3 / tf_sent;
+        }
+        // CDR size of a TFMessage with one ned -> base_link transform, without alignment padding
+        static const size_t tf_message_bytes =
+            4 + 4 + 8 + (4 + NED_FRAME.size() + 1) + (4 + BASE_LINK_FRAME.size() + 1) + 7 * sizeof(double);
+        const double interval_s = std::chrono::duration<double>(print_stats_interval).count();
+        const double skipped_rate = tf_skipped / interval_s;
+
+        ss << "=== Odometry TF statistics ===" << std::endl;
+        ss << std::fixed << std::setprecision(1);
+        ss << "Sent [Hz]             " << std::setw(width) << tf_sent / interval_s << std::endl;
+        ss << "Skipped [Hz]          " << std::setw(width) << skipped_rate << std::endl;
+        ss << "Send time [us]        " << std::setw(width) << _odometry_tf_mean_send_time_us << std::endl;
+        ss << "CPU saved [%]         " << std::setw(width) << skipped_rate * _odometry_tf_mean_send_time_us * 1e-4
+           << std::endl;
+        ss << "DDS saved [kB/s]      " << std::setw(width) << skipped_rate * tf_message_bytes * 1e-3 << std::endl;
+    }
+
+    if (ss.tellp() > 0) {
+        std::cout << std::endl << ss.str() << std::endl;
+    }
+}
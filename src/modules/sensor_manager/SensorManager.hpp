@@ -44,12 +44,22 @@
 #include <timing_tools/timing_tools.h>
 
 #include <Eigen/Dense>
+#include <FramePool.hpp>
 #include <ModuleBase.hpp>
 #include <ObstacleAvoidanceModule.hpp>
+#include <TelemetryHub.hpp>
+#include <atomic>
 #include <chrono>
 #include <iomanip>
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
 
+#include "DepthDownsampler.hpp"
+#include "OdometryBuffer.hpp"
 #include "TimeSync.hpp"
 
 // ROS dependencies
@@ -87,21 +97,44 @@ class SensorManager : public rclcpp::Node, public ObstacleAvoidanceModule, Modul
     auto deinit() -> void override;
     auto run() -> void override;
 
-    std::shared_ptr<ExtendedDownsampledImageF> RCPPUTILS_TSA_GUARDED_BY(_sensor_manager_mutex)
-        get_lastest_downsampled_depth() {
-        std::lock_guard<std::mutex> lock(_sensor_manager_mutex);
-        return _downsampled_depth;
-    }
+    std::shared_ptr<const DepthFrameChannel> get_depth_frame_channel() const { return _depth_frame_channel; }
+
+    /**
+     * @brief Consumers of the depth frames register here, frames are only processed while one of them wants them
+     */
+    std::shared_ptr<FrameDemand> get_depth_frame_demand() const { return _depth_frame_demand; }
 
     void set_camera_static_tf(const double x, const double y, const double yaw_deg);
 
+    /**
+     * @brief Shared telemetry subscriptions, must be set before init(). A private hub is created otherwise.
+     */
+    void setTelemetryHub(std::shared_ptr<TelemetryHub> telemetry_hub) { _telemetry_hub = std::move(telemetry_hub); }
+
+    /**
+     * @brief Set the callback telling which part of the depth frame the consumers need. Only that part is downsampled.
+     */
+    void setRegionOfInterestCallback(std::function<DepthRegionOfInterest()> callback) {
+        std::lock_guard<std::mutex> lock(_region_of_interest_mutex);
+        _region_of_interest_callback = std::move(callback);
+    }
+
     bool isHealthy() const { return _health_status == HealthStatus::HEALTHY; }
 
    private:
     enum HealthStatus { HEALTHY = 0, UNHEALTHY_ODOMETRY = 1, UNHEALTHY_IMAGES = 2, UNHEALTHY_ODOMETRY_AND_IMAGES = 3 };
 
+    // When the odometry is broadcast on /tf. It is only needed for visualization, the modules use the odometry buffer.
+    enum class TfBroadcastPolicy { OFF, RATE_LIMITED, SUBSCRIBED };
+
     void handle_incoming_camera_info(const sensor_msgs::msg::CameraInfo::ConstSharedPtr& msg);
     void handle_incoming_depth_image(const sensor_msgs::msg::Image::ConstSharedPtr& msg);
+    void update_downsampling_region();
+    bool should_broadcast_odometry_tf();
+    void broadcast_odometry_tf(const StampedPose& pose);
+    void update_tf_subscribers();
+    bool lookup_camera_pose(const builtin_interfaces::msg::Time& stamp, Eigen::Vector3f& position,
+                            Eigen::Quaternionf& orientation);
 
     bool set_downsampler(const sensor_msgs::msg::Image::ConstSharedPtr& msg);
 
@@ -109,38 +142,73 @@ class SensorManager : public rclcpp::Node, public ObstacleAvoidanceModule, Modul
 
     void publish_time_sync();
 
-    mutable std::mutex _sensor_manager_mutex;
+    void print_stats();
 
     rclcpp::Subscription<sensor_msgs::msg::CameraInfo>::SharedPtr _depth_img_camera_info_sub;
 
     rclcpp::Publisher<px4_msgs::msg::VehicleStatus>::SharedPtr _vehicle_status_pub;  // for bagger in MAVLink mode
 
     std::shared_ptr<mavsdk::System> _mavsdk_system;
-    std::shared_ptr<mavsdk::Telemetry> _telemetry;
+    std::shared_ptr<TelemetryHub> _telemetry_hub;
+    // Added in run(), removed in deinit()
+    std::vector<TelemetryHub::ListenerHandle> _telemetry_listeners;
     std::shared_ptr<mavsdk::ServerUtility> _server_utility;
     std::shared_ptr<mavsdk::MavlinkPassthrough> _mavlink_passthrough;
 
+    // Guards the downsampler, the intrinsics and the ray table, the camera info and depth image callbacks run on
+    // different executor threads
+    std::mutex _camera_mutex;
     std::shared_ptr<ImageDownsamplerInterface> _imageDownsampler;
+    std::unique_ptr<DepthDownsampler> _depthDownsampler;
+    // Image format the downsampler was built for
+    uint32_t _depth_image_width{0};
+    uint32_t _depth_image_height{0};
+    std::string _depth_image_encoding;
+
+    std::mutex _region_of_interest_mutex;
+    std::function<DepthRegionOfInterest()> _region_of_interest_callback;
 
     RectifiedIntrinsicsF _intrinsics;
+    std::shared_ptr<const RayTable> _ray_table;
     Eigen::Vector2f _inverse_focal_length;
     Eigen::Vector2f _principal_point;
 
     int16_t _downsampling_block_size;
+    bool _downsampling_force_scalar{false};
     static constexpr float _downsampling_min_depth_to_use_m{0.2};
 
     tf2_ros::StaticTransformBroadcaster _static_tf_broadcaster;
     tf2_ros::TransformBroadcaster _tf_broadcaster;
-    tf2_ros::Buffer _tf_buffer;
-    tf2_ros::TransformListener _tf_listener;
-    tf2_ros::MessageFilter<sensor_msgs::msg::Image> _tf_depth_filter;
 
+    // Camera poses are interpolated from the odometry directly. The tf2 lookup is only set up when the poses should
+    // come from /tf instead, e.g. when replaying a bag.
+    bool _use_tf_camera_pose{false};
+    std::unique_ptr<tf2_ros::Buffer> _tf_buffer;
+    std::unique_ptr<tf2_ros::TransformListener> _tf_listener;
+    std::unique_ptr<tf2_ros::MessageFilter<sensor_msgs::msg::Image>> _tf_depth_filter;
     message_filters::Subscriber<sensor_msgs::msg::Image> _tf_depth_subscriber;
+    rclcpp::Subscription<sensor_msgs::msg::Image>::SharedPtr _depth_img_sub;
+
+    OdometryBuffer _odometry_buffer;
+
+    TfBroadcastPolicy _odometry_tf_policy{TfBroadcastPolicy::SUBSCRIBED};
+    std::chrono::steady_clock::duration _odometry_tf_min_interval{};
+    std::chrono::steady_clock::time_point _odometry_tf_last_broadcast{};
+    std::atomic<bool> _tf_has_subscribers{false};
+    std::atomic<uint64_t> _odometry_tf_sent{0};
+    std::atomic<uint64_t> _odometry_tf_skipped{0};
+    std::atomic<uint64_t> _odometry_tf_send_time_ns{0};
+    double _odometry_tf_mean_send_time_us{0.0};
+    uint64_t _depth_frames_without_pose{0};
 
     geometry_msgs::msg::TransformStamped _camera_static_tf;
+    Eigen::Vector3d _camera_extrinsic_position{Eigen::Vector3d::Zero()};
+    Eigen::Quaterniond _camera_extrinsic_orientation{Eigen::Quaterniond::Identity()};
 
     rclcpp::TimerBase::SharedPtr _timer_health_check_task;
     rclcpp::TimerBase::SharedPtr _timer_time_sync_task;
+    rclcpp::TimerBase::SharedPtr _timer_stats;
+    rclcpp::TimerBase::SharedPtr _timer_tf_subscribers;
 
     rclcpp::Time _time_last_odometry;
     rclcpp::Time _time_last_image;
@@ -153,6 +221,13 @@ class SensorManager : public rclcpp::Node, public ObstacleAvoidanceModule, Modul
     timing_tools::FrequencyMeter _frequency_camera_info;
     timing_tools::FrequencyMeter _frequency_odometry;
 
-   protected:
-    std::shared_ptr<ExtendedDownsampledImageF> _downsampled_depth;
+    std::shared_ptr<DepthFrameChannel> _depth_frame_channel;
+    std::shared_ptr<FrameDemand> _depth_frame_demand;
+    uint64_t _depth_frames_without_demand{0};
+
+    // Depth frames are recycled once every consumer released them, so steady state runs without heap allocations
+    FramePool<ExtendedDownsampledImageF> _depth_frame_pool;
+    uint64_t _depth_frames_published{0};
+    uint64_t _depth_frame_buffer_allocations{0};
+    uint64_t _depth_frames_malformed{0};
 };
@@ -0,0 +1,273 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Tests of the depth downsampler SIMD kernels against the scalar reference kernel
+ * @file DepthDownsamplerTest.cpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#include <gtest/gtest.h>
+
+#include <DepthDownsampler.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <tuple>
+
+namespace {
+
+using Encoding = DepthDownsampler::Encoding;
+using Kernel = DepthDownsampler::Kernel;
+
+constexpr float kInfinity = std::numeric_limits<float>::infinity();
+constexpr float kDepthScale16UC1 = 0.001f;
+
+struct ImageSize {
+    uint32_t width;
+    uint32_t height;
+    uint32_t block_width;
+    uint32_t block_height;
+};
+
+// Depth image with padded rows, starting at an odd byte offset so that neither the rows nor the pixels are aligned
+struct TestImage {
+    TestImage(Encoding encoding, uint32_t width, uint32_t height)
+        : element_size(encoding == Encoding::UINT16 ? sizeof(uint16_t) : sizeof(float)),
+          step((width + 3) * element_size + 1),
+          storage(step * height + 1) {}
+
+    uint8_t* data() { return storage.data() + 1; }
+
+    template <typename T>
+    void set(uint32_t row, uint32_t col, T value) {
+        std::memcpy(data() + row * step + col * sizeof(T), &value, sizeof(T));
+    }
+
+    size_t element_size;
+    size_t step;
+    std::vector<uint8_t> storage;
+};
+
+// Random depths, with a large share of invalid and boundary values
+void fillRandom(TestImage& image, Encoding encoding, uint32_t width, uint32_t height, float min_depth_m,
+                std::mt19937& generator) {
+    std::uniform_int_distribution<uint32_t> random;
+    const float min_depth_raw = min_depth_m / kDepthScale16UC1;
+    const uint16_t threshold = static_cast<uint16_t>(std::ceil(min_depth_raw));
+    const uint16_t uint16_edges[] = {0, 1, 0xFFFF, 0xFFFE, static_cast<uint16_t>(threshold - 1), threshold,
+                                     static_cast<uint16_t>(threshold + 1)};
+    const float float32_edges[] = {0.f,
+                                   -0.f,
+                                   -1.f,
+                                   std::numeric_limits<float>::quiet_NaN(),
+                                   kInfinity,
+                                   -kInfinity,
+                                   std::numeric_limits<float>::denorm_min(),
+                                   std::numeric_limits<float>::max(),
+                                   min_depth_m,
+                                   std::nextafter(min_depth_m, 0.f),
+                                   std::nextafter(min_depth_m, kInfinity)};
+
+    for (uint32_t row = 0; row < height; ++row) {
+        for (uint32_t col = 0; col < width; ++col) {
+            const uint32_t value = random(generator);
+            const bool edge = (value & 0x3) == 0;
+            if (encoding == Encoding::UINT16) {
+                image.set<uint16_t>(row, col,
+                                    edge ? uint16_edges[(value >> 2) % std::size(uint16_edges)]
+                                         : static_cast<uint16_t>(value >> 16));
+            } else {
+                image.set<float>(row, col,
+                                 edge ? float32_edges[(value >> 2) % std::size(float32_edges)]
+                                      : static_cast<float>(value >> 16) * 1e-3f);
+            }
+        }
+    }
+}
+
+void expectBitExact(const DepthPixelArrayF& expected, const DepthPixelArrayF& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(expected[i].x, actual[i].x) << "pixel " << i;
+        EXPECT_EQ(expected[i].y, actual[i].y) << "pixel " << i;
+        uint32_t expected_bits;
+        uint32_t actual_bits;
+        std::memcpy(&expected_bits, &expected[i].depth, sizeof(float));
+        std::memcpy(&actual_bits, &actual[i].depth, sizeof(float));
+        EXPECT_EQ(expected_bits, actual_bits)
+            << "pixel " << i << ": expected " << expected[i].depth << ", got " << actual[i].depth;
+    }
+}
+
+class DepthDownsamplerKernelTest : public ::testing::TestWithParam<std::tuple<Kernel, Encoding>> {
+   protected:
+    void SetUp() override {
+        std::tie(_kernel, _encoding) = GetParam();
+        if (!DepthDownsampler::kernel_supported(_kernel)) {
+            GTEST_SKIP() << DepthDownsampler::kernel_to_string(_kernel) << " is not supported on this CPU";
+        }
+    }
+
+    float depthScale() const { return _encoding == Encoding::UINT16 ? kDepthScale16UC1 : 1.f; }
+
+    // Downsample the same image with the kernel under test and with the scalar reference, region by region
+    void compare(const ImageSize& size, float min_depth_m, const std::vector<DepthDownsampler::Region>& regions,
+                 uint32_t seed) {
+        DepthDownsampler reference(_encoding, size.width, size.height, size.block_width, size.block_height,
+                                   min_depth_m, depthScale(), Kernel::SCALAR);
+        DepthDownsampler downsampler(_encoding, size.width, size.height, size.block_width, size.block_height,
+                                     min_depth_m, depthScale(), _kernel);
+        ASSERT_EQ(downsampler.kernel(), _kernel);
+
+        std::mt19937 generator(seed);
+        TestImage image(_encoding, size.width, size.height);
+        fillRandom(image, _encoding, size.width, size.height, min_depth_m, generator);
+
+        DepthPixelArrayF expected;
+        DepthPixelArrayF actual;
+        reference.downsample(image.data(), image.step, expected);
+        downsampler.downsample(image.data(), image.step, actual);
+        expectBitExact(expected, actual);
+
+        for (const auto& region : regions) {
+            SCOPED_TRACE(::testing::Message() << "region cols [" << region.col_begin << ", " << region.col_end
+                                              << ") rows [" << region.row_begin << ", " << region.row_end << ")");
+            reference.set_region(region);
+            downsampler.set_region(region);
+            reference.downsample(image.data(), image.step, expected);
+            downsampler.downsample(image.data(), image.step, actual);
+            expectBitExact(expected, actual);
+        }
+    }
+
+    Kernel _kernel;
+    Encoding _encoding;
+};
+
+TEST_P(DepthDownsamplerKernelTest, MatchesReferenceOnCameraResolution) {
+    compare({848, 480, 4, 4}, 0.1f, {{10, 200, 5, 100}, {0, 212, 119, 120}}, 1);
+}
+
+TEST_P(DepthDownsamplerKernelTest, MatchesReferenceOnOddSizesAndPartialBlocks) {
+    // The image does not divide into blocks, and the block widths do not divide into SIMD lanes
+    const ImageSize sizes[] = {{37, 23, 4, 4}, {101, 67, 3, 5}, {7, 9, 7, 1}, {29, 11, 1, 3}, {66, 17, 16, 2}};
+    uint32_t seed = 2;
+    for (const auto& size : sizes) {
+        SCOPED_TRACE(::testing::Message() << size.width << "x" << size.height << ", blocks of " << size.block_width
+                                          << "x" << size.block_height);
+        const uint32_t output_width = size.width / size.block_width;
+        const uint32_t output_height = size.height / size.block_height;
+        compare(size, 0.25f, {{1, output_width, 0, output_height}, {output_width / 2, output_width / 2 + 1, 1, 2}},
+                seed++);
+    }
+}
+
+TEST_P(DepthDownsamplerKernelTest, MatchesReferenceOnMinimumDepthEdges) {
+    // No minimum depth, a minimum depth on a raw 16 bit value, and one above every 16 bit depth
+    for (const float min_depth_m : {0.f, 0.5f, 0.0005f, 70.f}) {
+        SCOPED_TRACE(::testing::Message() << "min depth " << min_depth_m);
+        compare({64, 32, 4, 4}, min_depth_m, {{2, 5, 1, 7}}, 3);
+    }
+}
+
+TEST_P(DepthDownsamplerKernelTest, ReportsInfinityForInvalidBlocks) {
+    DepthDownsampler downsampler(_encoding, 32, 8, 4, 4, 0.5f, depthScale(), _kernel);
+    TestImage image(_encoding, 32, 8);
+    for (uint32_t row = 0; row < 8; ++row) {
+        for (uint32_t col = 0; col < 32; ++col) {
+            if (_encoding == Encoding::UINT16) {
+                // Zero, below and at the minimum depth of 0.5 m
+                image.set<uint16_t>(row, col, static_cast<uint16_t>((col % 3) * 250));
+            } else {
+                image.set<float>(row, col, col % 2 ? std::numeric_limits<float>::quiet_NaN() : 0.5f);
+            }
+        }
+    }
+    // A single valid depth in the last block
+    if (_encoding == Encoding::UINT16) {
+        image.set<uint16_t>(7, 31, 2000);
+    } else {
+        image.set<float>(7, 31, 2.f);
+    }
+
+    DepthPixelArrayF out;
+    downsampler.downsample(image.data(), image.step, out);
+    ASSERT_EQ(out.size(), 16u);
+    for (size_t i = 0; i + 1 < out.size(); ++i) {
+        EXPECT_EQ(out[i].depth, kInfinity) << "pixel " << i;
+    }
+    EXPECT_FLOAT_EQ(out.back().depth, 2.f);
+    EXPECT_EQ(out.back().x, 7.f);
+    EXPECT_EQ(out.back().y, 1.f);
+}
+
+std::string kernelTestName(const ::testing::TestParamInfo<DepthDownsamplerKernelTest::ParamType>& info) {
+    std::string name = DepthDownsampler::kernel_to_string(std::get<0>(info.param));
+    name.erase(std::remove(name.begin(), name.end(), '.'), name.end());
+    return name + (std::get<1>(info.param) == Encoding::UINT16 ? "_16UC1" : "_32FC1");
+}
+
+INSTANTIATE_TEST_SUITE_P(Kernels, DepthDownsamplerKernelTest,
+                         ::testing::Combine(::testing::Values(Kernel::SSE41, Kernel::AVX2, Kernel::NEON),
+                                            ::testing::Values(Encoding::UINT16, Encoding::FLOAT32)),
+                         kernelTestName);
+
+TEST(DepthDownsamplerTest, UnsupportedKernelFallsBackToScalar) {
+    for (const Kernel kernel : {Kernel::SSE41, Kernel::AVX2, Kernel::NEON}) {
+        const DepthDownsampler downsampler(Encoding::FLOAT32, 16, 16, 4, 4, 0.1f, 1.f, kernel);
+        EXPECT_EQ(downsampler.kernel(), DepthDownsampler::kernel_supported(kernel) ? kernel : Kernel::SCALAR);
+    }
+}
+
+TEST(DepthDownsamplerTest, ScalarKernelTakesBlockMinimum) {
+    DepthDownsampler downsampler(Encoding::UINT16, 4, 2, 2, 2, 0.2f, kDepthScale16UC1, Kernel::SCALAR);
+    TestImage image(Encoding::UINT16, 4, 2);
+    const uint16_t depths_mm[2][4] = {{1500, 900, 100, 0}, {1200, 3000, 0, 150}};
+    for (uint32_t row = 0; row < 2; ++row) {
+        for (uint32_t col = 0; col < 4; ++col) {
+            image.set<uint16_t>(row, col, depths_mm[row][col]);
+        }
+    }
+
+    DepthPixelArrayF out;
+    downsampler.downsample(image.data(), image.step, out);
+    ASSERT_EQ(out.size(), 2u);
+    EXPECT_FLOAT_EQ(out[0].depth, 0.9f);
+    EXPECT_EQ(out[1].depth, kInfinity);
+}
+
+}  // namespace
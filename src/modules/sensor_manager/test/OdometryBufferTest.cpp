@@ -0,0 +1,181 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Tests of the odometry ring buffer interpolation
+ * @file OdometryBufferTest.cpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#include <gtest/gtest.h>
+
+#include <OdometryBuffer.hpp>
+#include <cmath>
+#include <optional>
+
+namespace {
+
+constexpr uint64_t kMillisecond = 1'000'000;
+
+StampedPose pose(uint64_t stamp_ns, const Eigen::Vector3d& position, double yaw_rad = 0.0) {
+    StampedPose sample;
+    sample.stamp_ns = stamp_ns;
+    sample.position = position;
+    sample.orientation = Eigen::Quaterniond(Eigen::AngleAxisd(yaw_rad, Eigen::Vector3d::UnitZ()));
+    return sample;
+}
+
+double yaw(const Eigen::Quaterniond& orientation) {
+    return std::atan2(2.0 * (orientation.w() * orientation.z() + orientation.x() * orientation.y()),
+                      1.0 - 2.0 * (orientation.y() * orientation.y() + orientation.z() * orientation.z()));
+}
+
+}  // namespace
+
+TEST(OdometryBufferTest, EmptyBufferHasNoPose) {
+    OdometryBuffer buffer(8);
+    EXPECT_EQ(buffer.size(), 0U);
+    EXPECT_FALSE(buffer.interpolate(100 * kMillisecond, 1000 * kMillisecond).has_value());
+}
+
+TEST(OdometryBufferTest, InterpolatesPositionAndOrientation) {
+    OdometryBuffer buffer(8);
+    buffer.push(pose(100 * kMillisecond, Eigen::Vector3d(0.0, 0.0, -1.0), 0.0));
+    buffer.push(pose(200 * kMillisecond, Eigen::Vector3d(2.0, -4.0, -3.0), M_PI / 2.0));
+
+    const std::optional<StampedPose> middle = buffer.interpolate(150 * kMillisecond, 0);
+    ASSERT_TRUE(middle.has_value());
+    EXPECT_EQ(middle->stamp_ns, 150 * kMillisecond);
+    EXPECT_TRUE(middle->position.isApprox(Eigen::Vector3d(1.0, -2.0, -2.0)));
+    EXPECT_NEAR(yaw(middle->orientation), M_PI / 4.0, 1e-9);
+
+    const std::optional<StampedPose> quarter = buffer.interpolate(125 * kMillisecond, 0);
+    ASSERT_TRUE(quarter.has_value());
+    EXPECT_TRUE(quarter->position.isApprox(Eigen::Vector3d(0.5, -1.0, -1.5)));
+    EXPECT_NEAR(yaw(quarter->orientation), M_PI / 8.0, 1e-9);
+}
+
+TEST(OdometryBufferTest, PicksTheSamplesAroundTheStamp) {
+    OdometryBuffer buffer(16);
+    for (uint64_t i = 0; i < 10; ++i) {
+        buffer.push(pose(i * 10 * kMillisecond, Eigen::Vector3d(static_cast<double>(i * i), 0.0, 0.0)));
+    }
+
+    // Between the samples at 30 and 40 ms
+    const std::optional<StampedPose> between = buffer.interpolate(35 * kMillisecond, 0);
+    ASSERT_TRUE(between.has_value());
+    EXPECT_NEAR(between->position.x(), 12.5, 1e-9);
+
+    // Exactly on a sample
+    const std::optional<StampedPose> exact = buffer.interpolate(70 * kMillisecond, 0);
+    ASSERT_TRUE(exact.has_value());
+    EXPECT_NEAR(exact->position.x(), 49.0, 1e-9);
+}
+
+TEST(OdometryBufferTest, ExtrapolatesOnlyWithinTolerance) {
+    OdometryBuffer buffer(8);
+    buffer.push(pose(100 * kMillisecond, Eigen::Vector3d(1.0, 0.0, 0.0)));
+    buffer.push(pose(200 * kMillisecond, Eigen::Vector3d(3.0, 0.0, 0.0)));
+
+    // Past the newest sample, the newest pose is returned with the requested stamp
+    const std::optional<StampedPose> after = buffer.interpolate(210 * kMillisecond, 20 * kMillisecond);
+    ASSERT_TRUE(after.has_value());
+    EXPECT_EQ(after->stamp_ns, 210 * kMillisecond);
+    EXPECT_DOUBLE_EQ(after->position.x(), 3.0);
+    EXPECT_FALSE(buffer.interpolate(230 * kMillisecond, 20 * kMillisecond).has_value());
+
+    // Before the oldest sample
+    const std::optional<StampedPose> before = buffer.interpolate(90 * kMillisecond, 20 * kMillisecond);
+    ASSERT_TRUE(before.has_value());
+    EXPECT_DOUBLE_EQ(before->position.x(), 1.0);
+    EXPECT_FALSE(buffer.interpolate(70 * kMillisecond, 20 * kMillisecond).has_value());
+}
+
+TEST(OdometryBufferTest, DropsOutOfOrderSamples) {
+    OdometryBuffer buffer(8);
+    buffer.push(pose(100 * kMillisecond, Eigen::Vector3d(1.0, 0.0, 0.0)));
+    buffer.push(pose(200 * kMillisecond, Eigen::Vector3d(3.0, 0.0, 0.0)));
+    buffer.push(pose(150 * kMillisecond, Eigen::Vector3d(100.0, 0.0, 0.0)));
+    buffer.push(pose(200 * kMillisecond, Eigen::Vector3d(100.0, 0.0, 0.0)));
+
+    EXPECT_EQ(buffer.size(), 2U);
+    const std::optional<StampedPose> middle = buffer.interpolate(150 * kMillisecond, 0);
+    ASSERT_TRUE(middle.has_value());
+    EXPECT_NEAR(middle->position.x(), 2.0, 1e-9);
+}
+
+TEST(OdometryBufferTest, LargeJumpBackResetsTheBuffer) {
+    OdometryBuffer buffer(8);
+    const uint64_t start = 10 * OdometryBuffer::reset_jump_ns;
+    buffer.push(pose(start, Eigen::Vector3d(1.0, 0.0, 0.0)));
+    buffer.push(pose(start + 100 * kMillisecond, Eigen::Vector3d(2.0, 0.0, 0.0)));
+
+    // The time sync restarted
+    buffer.push(pose(5 * kMillisecond, Eigen::Vector3d(7.0, 0.0, 0.0)));
+    EXPECT_EQ(buffer.size(), 1U);
+    EXPECT_FALSE(buffer.interpolate(start, 0).has_value());
+
+    const std::optional<StampedPose> restarted = buffer.interpolate(5 * kMillisecond, 0);
+    ASSERT_TRUE(restarted.has_value());
+    EXPECT_DOUBLE_EQ(restarted->position.x(), 7.0);
+}
+
+TEST(OdometryBufferTest, RingKeepsTheNewestSamples) {
+    OdometryBuffer buffer(4);
+    for (uint64_t i = 1; i <= 10; ++i) {
+        buffer.push(pose(i * 10 * kMillisecond, Eigen::Vector3d(static_cast<double>(i), 0.0, 0.0)));
+    }
+    EXPECT_EQ(buffer.size(), 4U);
+
+    // Samples 7 to 10 are left
+    EXPECT_FALSE(buffer.interpolate(65 * kMillisecond, 0).has_value());
+    const std::optional<StampedPose> oldest = buffer.interpolate(70 * kMillisecond, 0);
+    ASSERT_TRUE(oldest.has_value());
+    EXPECT_DOUBLE_EQ(oldest->position.x(), 7.0);
+
+    const std::optional<StampedPose> middle = buffer.interpolate(95 * kMillisecond, 0);
+    ASSERT_TRUE(middle.has_value());
+    EXPECT_NEAR(middle->position.x(), 9.5, 1e-9);
+}
+
+TEST(OdometryBufferTest, CapacityIsAtLeastTwo) {
+    OdometryBuffer buffer(0);
+    buffer.push(pose(10 * kMillisecond, Eigen::Vector3d(0.0, 0.0, 0.0)));
+    buffer.push(pose(20 * kMillisecond, Eigen::Vector3d(1.0, 0.0, 0.0)));
+    buffer.push(pose(30 * kMillisecond, Eigen::Vector3d(2.0, 0.0, 0.0)));
+    EXPECT_EQ(buffer.size(), 2U);
+
+    const std::optional<StampedPose> middle = buffer.interpolate(25 * kMillisecond, 0);
+    ASSERT_TRUE(middle.has_value());
+    EXPECT_NEAR(middle->position.x(), 1.5, 1e-9);
+}
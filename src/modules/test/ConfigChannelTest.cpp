@@ -0,0 +1,168 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Tests of the versioned configuration channel
+ * @file ConfigChannelTest.cpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#include <gtest/gtest.h>
+
+#include <ConfigChannel.hpp>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct TestConfig {
+    uint64_t version{0};
+    std::string name;
+};
+
+}  // namespace
+
+TEST(ConfigChannelTest, EmptyUntilPublished) {
+    ConfigChannel<TestConfig> channel;
+    uint64_t last_generation = 0;
+
+    EXPECT_EQ(channel.generation(), 0U);
+    EXPECT_EQ(channel.latest(), nullptr);
+    EXPECT_EQ(channel.poll(last_generation), nullptr);
+    EXPECT_EQ(last_generation, 0U);
+}
+
+TEST(ConfigChannelTest, PollReturnsEachGenerationOnce) {
+    ConfigChannel<TestConfig> channel;
+    uint64_t last_generation = 0;
+
+    channel.publish({1, "first"});
+    const std::shared_ptr<const TestConfig> config = channel.poll(last_generation);
+    ASSERT_NE(config, nullptr);
+    EXPECT_EQ(config->name, "first");
+    EXPECT_EQ(last_generation, 1U);
+    EXPECT_EQ(channel.poll(last_generation), nullptr);
+
+    // The latest snapshot is still there for modules that do not poll
+    ASSERT_NE(channel.latest(), nullptr);
+    EXPECT_EQ(channel.latest()->name, "first");
+}
+
+TEST(ConfigChannelTest, PollSkipsToTheLatestConfiguration) {
+    ConfigChannel<TestConfig> channel;
+    uint64_t last_generation = 0;
+
+    channel.publish({1, "first"});
+    channel.publish({2, "second"});
+    channel.publish({3, "third"});
+    const std::shared_ptr<const TestConfig> config = channel.poll(last_generation);
+    ASSERT_NE(config, nullptr);
+    EXPECT_EQ(config->name, "third");
+    EXPECT_EQ(last_generation, 3U);
+    EXPECT_EQ(channel.poll(last_generation), nullptr);
+}
+
+TEST(ConfigChannelTest, SnapshotsOutliveLaterPublishes) {
+    ConfigChannel<TestConfig> channel;
+    channel.publish({1, "first"});
+    const std::shared_ptr<const TestConfig> held = channel.latest();
+
+    channel.publish({2, "second"});
+    EXPECT_EQ(held->name, "first");
+    EXPECT_EQ(channel.latest()->name, "second");
+}
+
+TEST(ConfigChannelTest, ListenerIsCalledOnEveryPublishUntilRemoved) {
+    ConfigChannel<TestConfig> channel;
+    int calls = 0;
+    uint64_t generation_seen = 0;
+    channel.setPublishListener([&]() {
+        calls++;
+        // The new configuration is already visible to the listener
+        generation_seen = channel.generation();
+    });
+
+    channel.publish({1, "first"});
+    channel.publish({2, "second"});
+    EXPECT_EQ(calls, 2);
+    EXPECT_EQ(generation_seen, 2U);
+
+    channel.setPublishListener(nullptr);
+    channel.publish({3, "third"});
+    EXPECT_EQ(calls, 2);
+}
+
+TEST(ConfigChannelTest, ConcurrentPollersSeeConfigurationsAtLeastAsRecentAsTheGeneration) {
+    constexpr uint64_t kPublishes = 20000;
+    constexpr int kPollers = 3;
+
+    ConfigChannel<TestConfig> channel;
+    std::atomic<bool> done{false};
+    std::atomic<int> failures{0};
+
+    std::vector<std::thread> pollers;
+    for (int i = 0; i < kPollers; ++i) {
+        pollers.emplace_back([&]() {
+            uint64_t last_generation = 0;
+            uint64_t last_version = 0;
+            while (!done.load(std::memory_order_acquire) || channel.generation() != last_generation) {
+                const std::shared_ptr<const TestConfig> config = channel.poll(last_generation);
+                if (!config) {
+                    continue;
+                }
+                // Publish n stores version n, the snapshot is stored before the generation is bumped
+                if (config->version < last_generation || config->version < last_version ||
+                    config->name != std::to_string(config->version)) {
+                    failures++;
+                }
+                last_version = config->version;
+            }
+            if (last_version != kPublishes) {
+                failures++;
+            }
+        });
+    }
+
+    for (uint64_t version = 1; version <= kPublishes; ++version) {
+        channel.publish({version, std::to_string(version)});
+    }
+    done.store(true, std::memory_order_release);
+    for (std::thread& poller : pollers) {
+        poller.join();
+    }
+
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(channel.generation(), kPublishes);
+}
@@ -0,0 +1,237 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Tests of the lock-free frame channel
+ * @file FrameChannelTest.cpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#include <gtest/gtest.h>
+
+#include <FrameChannel.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+// Every field holds the sequence number the frame was published with, so a torn or mixed up frame is detectable
+struct TestFrame {
+    uint64_t sequence{0};
+    std::vector<uint64_t> payload;
+};
+
+constexpr size_t kMaxReaders = 4;
+using TestChannel = FrameChannel<TestFrame, kMaxReaders>;
+
+std::shared_ptr<const TestFrame> makeFrame(uint64_t sequence) {
+    auto frame = std::make_shared<TestFrame>();
+    frame->sequence = sequence;
+    frame->payload.assign(64, sequence);
+    return frame;
+}
+
+bool isConsistent(const TestFrame& frame) {
+    for (const uint64_t value : frame.payload) {
+        if (value != frame.sequence) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+TEST(FrameChannelTest, EmptyUntilFirstPublish) {
+    TestChannel channel;
+    EXPECT_EQ(channel.sequence(), 0U);
+
+    const TestChannel::Frame frame = channel.latest();
+    EXPECT_EQ(frame.data, nullptr);
+    EXPECT_EQ(frame.sequence, 0U);
+}
+
+TEST(FrameChannelTest, LatestReturnsLastPublishedFrame) {
+    TestChannel channel;
+    for (uint64_t sequence = 1; sequence <= 20; ++sequence) {
+        ASSERT_TRUE(channel.publish(makeFrame(sequence)));
+        EXPECT_EQ(channel.sequence(), sequence);
+
+        const TestChannel::Frame frame = channel.latest();
+        ASSERT_NE(frame.data, nullptr);
+        EXPECT_EQ(frame.sequence, sequence);
+        EXPECT_EQ(frame.data->sequence, sequence);
+    }
+}
+
+TEST(FrameChannelTest, HeldFramesOutliveNewerPublications) {
+    TestChannel channel;
+    ASSERT_TRUE(channel.publish(makeFrame(1)));
+    const TestChannel::Frame held = channel.latest();
+
+    // Cycle through all slots several times, the held frame must stay untouched
+    for (uint64_t sequence = 2; sequence < 20; ++sequence) {
+        ASSERT_TRUE(channel.publish(makeFrame(sequence)));
+    }
+
+    EXPECT_EQ(held.sequence, 1U);
+    EXPECT_EQ(held.data->sequence, 1U);
+    EXPECT_TRUE(isConsistent(*held.data));
+    EXPECT_EQ(channel.latest().sequence, 19U);
+}
+
+TEST(FrameChannelTest, NullFrameCanBePublished) {
+    TestChannel channel;
+    ASSERT_TRUE(channel.publish(makeFrame(1)));
+    ASSERT_TRUE(channel.publish(nullptr));
+
+    const TestChannel::Frame frame = channel.latest();
+    EXPECT_EQ(frame.data, nullptr);
+    EXPECT_EQ(frame.sequence, 2U);
+}
+
+TEST(FrameChannelTest, WaitForNewReturnsImmediatelyWhenBehind) {
+    TestChannel channel;
+    ASSERT_TRUE(channel.publish(makeFrame(1)));
+    ASSERT_TRUE(channel.publish(makeFrame(2)));
+
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(channel.wait_for_new(0, 10s), 2U);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 1s);
+}
+
+TEST(FrameChannelTest, WaitForNewTimesOut) {
+    TestChannel channel;
+    ASSERT_TRUE(channel.publish(makeFrame(1)));
+
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(channel.wait_for_new(1, 20ms), 1U);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 20ms);
+}
+
+TEST(FrameChannelTest, WaitForNewWakesUpOnPublish) {
+    TestChannel channel;
+    std::atomic<uint64_t> woken_sequence{0};
+
+    std::thread waiter([&]() { woken_sequence = channel.wait_for_new(0, 10s); });
+    std::this_thread::sleep_for(20ms);
+    const auto publish_time = std::chrono::steady_clock::now();
+    ASSERT_TRUE(channel.publish(makeFrame(1)));
+    waiter.join();
+
+    EXPECT_EQ(woken_sequence.load(), 1U);
+    EXPECT_LT(std::chrono::steady_clock::now() - publish_time, 1s);
+}
+
+// One producer and MaxReaders readers hammering the channel: publishing never fails, readers see non-decreasing
+// sequences and every frame they get is the one published with its sequence number
+TEST(FrameChannelTest, ConcurrentReadersSeeConsistentFrames) {
+    constexpr uint64_t kFrames = 20000;
+    TestChannel channel;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> failed_publications{0};
+    std::atomic<uint64_t> inconsistent_frames{0};
+    std::atomic<uint64_t> sequence_regressions{0};
+    std::atomic<uint64_t> frames_read{0};
+
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < kMaxReaders; ++i) {
+        readers.emplace_back([&]() {
+            uint64_t last_sequence = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                const TestChannel::Frame frame = channel.latest();
+                if (frame.data == nullptr) {
+                    continue;
+                }
+                if (frame.sequence < last_sequence) {
+                    sequence_regressions++;
+                }
+                if (frame.data->sequence != frame.sequence || !isConsistent(*frame.data)) {
+                    inconsistent_frames++;
+                }
+                last_sequence = frame.sequence;
+                frames_read++;
+            }
+        });
+    }
+
+    for (uint64_t sequence = 1; sequence <= kFrames; ++sequence) {
+        if (!channel.publish(makeFrame(sequence))) {
+            failed_publications++;
+        }
+    }
+    // Let the readers observe the final frame
+    std::this_thread::sleep_for(10ms);
+    done = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(failed_publications.load(), 0U);
+    EXPECT_EQ(inconsistent_frames.load(), 0U);
+    EXPECT_EQ(sequence_regressions.load(), 0U);
+    EXPECT_GT(frames_read.load(), 0U);
+    EXPECT_EQ(channel.latest().sequence, kFrames);
+}
+
+// A consumer blocking in wait_for_new() must be woken up by the last frame of a burst, not by its timeout
+TEST(FrameChannelTest, WaitingConsumerSeesEveryBurst) {
+    constexpr uint64_t kFrames = 500;
+    constexpr auto kTimeout = 2s;
+    TestChannel channel;
+    std::atomic<uint64_t> last_seen{0};
+
+    std::thread consumer([&]() {
+        uint64_t sequence = 0;
+        while (sequence < kFrames) {
+            sequence = channel.wait_for_new(sequence, kTimeout);
+            last_seen = sequence;
+        }
+    });
+
+    for (uint64_t sequence = 1; sequence <= kFrames; ++sequence) {
+        ASSERT_TRUE(channel.publish(makeFrame(sequence)));
+        if (sequence % 50 == 0) {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+    const auto last_publish = std::chrono::steady_clock::now();
+    consumer.join();
+
+    EXPECT_EQ(last_seen.load(), kFrames);
+    EXPECT_LT(std::chrono::steady_clock::now() - last_publish, kTimeout / 2);
+}
@@ -0,0 +1,125 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Tests of the consumer demand for the frames of a producer
+ * @file FrameDemandTest.cpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#include <gtest/gtest.h>
+
+#include <FrameDemand.hpp>
+#include <chrono>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+TEST(FrameDemandTest, AdmitsEveryFrameWithoutConsumers) {
+    FrameDemand demand;
+
+    EXPECT_TRUE(demand.admit());
+    EXPECT_TRUE(demand.admit());
+}
+
+TEST(FrameDemandTest, DropsFramesWhileNoConsumerIsActive) {
+    FrameDemand demand;
+    const auto consumer = demand.registerConsumer("test");
+
+    EXPECT_FALSE(demand.admit());
+
+    consumer->setDemand(true, 0.0);
+    EXPECT_TRUE(demand.admit());
+
+    consumer->setDemand(false, 0.0);
+    EXPECT_FALSE(demand.admit());
+}
+
+TEST(FrameDemandTest, LimitsTheRateOfEachConsumer) {
+    FrameDemand demand;
+    const auto consumer = demand.registerConsumer("test");
+    consumer->setDemand(true, 10.0);
+
+    const FrameDemand::Clock::time_point start = FrameDemand::Clock::now();
+    EXPECT_TRUE(demand.admit(start));
+    EXPECT_FALSE(demand.admit(start + 50ms));
+
+    // Slightly early frames still count as due
+    EXPECT_TRUE(demand.admit(start + 95ms));
+    EXPECT_FALSE(demand.admit(start + 150ms));
+}
+
+TEST(FrameDemandTest, AdmitsAFrameIfAnyConsumerIsDue) {
+    FrameDemand demand;
+    const auto slow = demand.registerConsumer("slow");
+    const auto fast = demand.registerConsumer("fast");
+    slow->setDemand(true, 1.0);
+    fast->setDemand(true, 0.0);
+
+    const FrameDemand::Clock::time_point start = FrameDemand::Clock::now();
+    EXPECT_TRUE(demand.admit(start));
+    EXPECT_TRUE(demand.admit(start + 10ms));
+
+    fast->setDemand(false, 0.0);
+    EXPECT_FALSE(demand.admit(start + 20ms));
+}
+
+// The latest frame of a channel can outlive the demand it was admitted for
+TEST(FrameDemandTest, FramesFromBeforeTheActivationAreNotWanted) {
+    FrameDemand demand;
+    const auto consumer = demand.registerConsumer("test");
+    consumer->setDemand(true, 0.0);
+
+    const FrameDemand::Clock::time_point received_before = FrameDemand::Clock::now();
+    EXPECT_TRUE(consumer->wants(received_before));
+
+    consumer->setDemand(false, 0.0);
+    EXPECT_FALSE(consumer->wants(received_before));
+
+    std::this_thread::sleep_for(1ms);
+    consumer->setDemand(true, 0.0);
+    EXPECT_FALSE(consumer->wants(received_before));
+    EXPECT_TRUE(consumer->wants(FrameDemand::Clock::now()));
+}
+
+// Updating the rate of an active consumer does not make its current frame stale
+TEST(FrameDemandTest, ActivationIsOnlyRecordedOnTheTransition) {
+    FrameDemand demand;
+    const auto consumer = demand.registerConsumer("test");
+    consumer->setDemand(true, 0.0);
+
+    const FrameDemand::Clock::time_point received = FrameDemand::Clock::now();
+    std::this_thread::sleep_for(1ms);
+    consumer->setDemand(true, 10.0);
+    EXPECT_TRUE(consumer->wants(received));
+}
@@ -0,0 +1,146 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Tests of the preallocated frame pool
+ * @file FramePoolTest.cpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#include <gtest/gtest.h>
+
+#include <FrameChannel.hpp>
+#include <FramePool.hpp>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace {
+
+struct TestFrame {
+    std::vector<float> pixels;
+    int writes{0};
+};
+
+}  // namespace
+
+TEST(FramePoolTest, ResetPreparesEveryFrame) {
+    FramePool<TestFrame> pool;
+    pool.reset(3, [](TestFrame& frame) { frame.pixels.resize(16); });
+
+    EXPECT_EQ(pool.capacity(), 3U);
+    EXPECT_EQ(pool.allocations(), 3U);
+    for (size_t i = 0; i < pool.capacity(); ++i) {
+        const std::shared_ptr<TestFrame> frame = pool.acquire();
+        ASSERT_NE(frame, nullptr);
+        EXPECT_EQ(frame->pixels.size(), 16U);
+    }
+}
+
+TEST(FramePoolTest, HandsOutEachFrameOnceUntilExhausted) {
+    FramePool<TestFrame> pool;
+    pool.reset(4, [](TestFrame&) {});
+
+    std::vector<std::shared_ptr<TestFrame>> held;
+    std::set<TestFrame*> distinct;
+    for (size_t i = 0; i < pool.capacity(); ++i) {
+        held.push_back(pool.acquire());
+        ASSERT_NE(held.back(), nullptr);
+        distinct.insert(held.back().get());
+    }
+    EXPECT_EQ(distinct.size(), pool.capacity());
+
+    EXPECT_EQ(pool.acquire(), nullptr);
+    EXPECT_EQ(pool.exhausted(), 1U);
+}
+
+TEST(FramePoolTest, ReleasedFramesAreReusedWithoutAllocation) {
+    FramePool<TestFrame> pool;
+    pool.reset(2, [](TestFrame&) {});
+
+    std::shared_ptr<TestFrame> first = pool.acquire();
+    std::shared_ptr<TestFrame> second = pool.acquire();
+    TestFrame* const first_address = first.get();
+    first->writes = 1;
+    ASSERT_EQ(pool.acquire(), nullptr);
+
+    // The frame goes back to the pool with the last reference, its content is kept for the producer to overwrite
+    first.reset();
+    const std::shared_ptr<TestFrame> reused = pool.acquire();
+    ASSERT_NE(reused, nullptr);
+    EXPECT_EQ(reused.get(), first_address);
+    EXPECT_EQ(reused->writes, 1);
+    EXPECT_EQ(pool.allocations(), 2U);
+}
+
+TEST(FramePoolTest, ResetReplacesTheFrames) {
+    FramePool<TestFrame> pool;
+    pool.reset(2, [](TestFrame& frame) { frame.pixels.resize(4); });
+    pool.reset(5, [](TestFrame& frame) { frame.pixels.resize(8); });
+
+    EXPECT_EQ(pool.capacity(), 5U);
+    EXPECT_EQ(pool.allocations(), 7U);
+    const std::shared_ptr<TestFrame> frame = pool.acquire();
+    ASSERT_NE(frame, nullptr);
+    EXPECT_EQ(frame->pixels.size(), 8U);
+}
+
+// A pool of FrameChannel::kMaxFramesInUse + 1 frames, as the modules size it, never runs dry while every reader keeps
+// at most one frame
+TEST(FramePoolTest, ChannelSizedPoolNeverRunsDry) {
+    constexpr size_t kMaxReaders = 4;
+    using Channel = FrameChannel<TestFrame, kMaxReaders>;
+
+    Channel channel;
+    FramePool<TestFrame> pool;
+    pool.reset(Channel::kMaxFramesInUse + 1, [](TestFrame&) {});
+
+    std::mt19937 generator(1);
+    std::uniform_int_distribution<size_t> reader_index(0, kMaxReaders - 1);
+    std::bernoulli_distribution release(0.2);
+    std::vector<std::shared_ptr<const TestFrame>> held(kMaxReaders);
+
+    for (int i = 0; i < 10000; ++i) {
+        std::shared_ptr<TestFrame> frame = pool.acquire();
+        ASSERT_NE(frame, nullptr) << "iteration " << i;
+        frame->writes++;
+        ASSERT_TRUE(channel.publish(std::move(frame)));
+
+        // Readers swap their frame for the latest one, or let go of it
+        const size_t reader = reader_index(generator);
+        held[reader] = release(generator) ? nullptr : channel.latest().data;
+    }
+
+    EXPECT_EQ(pool.exhausted(), 0U);
+    EXPECT_EQ(pool.allocations(), Channel::kMaxFramesInUse + 1);
+}
@@ -0,0 +1,157 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 Auterion AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name Auterion nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @brief Tests of the sequence lock
+ * @file SeqLockTest.cpp
+ * @author Nuno Marques <nuno@auterion.com>
+ */
+
+#include <gtest/gtest.h>
+
+#include <SeqLock.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Spans several words and is not a multiple of the word size, every field always holds the same value
+struct Fields {
+    uint64_t values[5];
+    uint32_t tail;
+};
+
+Fields uniform(uint64_t value) {
+    Fields fields;
+    for (uint64_t& field : fields.values) {
+        field = value;
+    }
+    fields.tail = static_cast<uint32_t>(value);
+    return fields;
+}
+
+bool isUniform(const Fields& fields) {
+    for (const uint64_t field : fields.values) {
+        if (field != fields.values[0]) {
+            return false;
+        }
+    }
+    return fields.tail == static_cast<uint32_t>(fields.values[0]);
+}
+
+}  // namespace
+
+TEST(SeqLockTest, LoadsTheInitialValue) {
+    SeqLock<Fields> lock(uniform(7));
+    EXPECT_TRUE(isUniform(lock.load()));
+    EXPECT_EQ(lock.load().values[0], 7U);
+    EXPECT_EQ(lock.writes(), 0U);
+}
+
+TEST(SeqLockTest, StoreAndUpdateCountAsWrites) {
+    SeqLock<Fields> lock;
+    lock.store(uniform(3));
+    EXPECT_EQ(lock.load().values[4], 3U);
+    EXPECT_EQ(lock.writes(), 1U);
+
+    lock.update([](Fields& fields) { fields.values[1] = 42; });
+    const Fields fields = lock.load();
+    EXPECT_EQ(fields.values[0], 3U);
+    EXPECT_EQ(fields.values[1], 42U);
+    EXPECT_EQ(fields.tail, 3U);
+    EXPECT_EQ(lock.writes(), 2U);
+}
+
+TEST(SeqLockTest, UpdatesOfDifferentFieldsFromSeveralWritersAreAllKept) {
+    constexpr int kWriters = 4;
+    constexpr uint64_t kUpdates = 5000;
+
+    SeqLock<Fields> lock(uniform(0));
+    std::vector<std::thread> writers;
+    for (int i = 0; i < kWriters; ++i) {
+        writers.emplace_back([&lock, i]() {
+            for (uint64_t n = 0; n < kUpdates; ++n) {
+                lock.update([i](Fields& fields) { fields.values[i]++; });
+            }
+        });
+    }
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+
+    const Fields fields = lock.load();
+    for (int i = 0; i < kWriters; ++i) {
+        EXPECT_EQ(fields.values[i], kUpdates);
+    }
+    EXPECT_EQ(lock.writes(), kWriters * kUpdates);
+}
+
+TEST(SeqLockTest, ReadersNeverSeeTornValues) {
+    constexpr uint64_t kWrites = 200000;
+    constexpr int kReaders = 3;
+
+    SeqLock<Fields> lock(uniform(0));
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+    std::atomic<int> regressed{0};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < kReaders; ++i) {
+        readers.emplace_back([&]() {
+            uint64_t last = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                const Fields fields = lock.load();
+                if (!isUniform(fields)) {
+                    torn++;
+                }
+                if (fields.values[0] < last) {
+                    regressed++;
+                }
+                last = fields.values[0];
+            }
+        });
+    }
+
+    for (uint64_t value = 1; value <= kWrites; ++value) {
+        lock.store(uniform(value));
+    }
+    done.store(true, std::memory_order_release);
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(torn.load(), 0);
+    EXPECT_EQ(regressed.load(), 0);
+    EXPECT_EQ(lock.load().values[0], kWrites);
+}